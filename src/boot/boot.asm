@@ -1,7 +1,8 @@
 [bits 16]
 [org 0x7c00]
 
-KERNEL_OFFSET equ 0x1000
+KERNEL_OFFSET equ 0x10000
+KERNEL_SEGMENT equ KERNEL_OFFSET >> 4
 
 ; save boot drive
 mov [BOOT_DRIVE], dl
@@ -1,22 +1,51 @@
+; Load KERNEL_SECTORS sectors starting at LBA 1 (the sector after the boot
+; sector) to KERNEL_SEGMENT:0000. Sectors are read one at a time so a read
+; never crosses a track or a 64KB DMA boundary, which lets the kernel grow
+; past the first track of the floppy.
+
+%ifndef KERNEL_SECTORS
+KERNEL_SECTORS equ 64   ; Overridden by the Makefile with the real kernel size
+%endif
+
+SECTORS_PER_TRACK equ 18    ; 1.44MB floppy geometry
+
 load_kernel:
-    mov ah, 0x02        ; BIOS Read Sector
-    mov al, 30          ; Read 30 sectors (enough for kernel)
-    mov ch, 0x00        ; Cylinder 0
-    mov dh, 0x00        ; Head 0
-    mov cl, 0x02        ; Start at Sector 2
-    
-    xor bx, bx          ; Clear BX
-    mov es, bx          ; ES = 0
-    mov bx, KERNEL_OFFSET ; BX = 0x1000. Buffer = 0000:1000
-    
-    mov dl, [BOOT_DRIVE]; Ensure we read from the boot disk
-    int 0x13            ; BIOs Interrupt
-    
-    jc disk_error       ; Check Carry Flag (BIOS Error)
-    
-    cmp al, 30          ; Check Sector Count (Incomplete Read)
+    mov ax, KERNEL_SEGMENT
+    mov es, ax
+    xor bx, bx              ; Buffer = KERNEL_SEGMENT:0000
+    mov si, 1               ; SI = LBA of next sector to read
+    mov di, KERNEL_SECTORS  ; DI = sectors left to read
+
+.next_sector:
+    ; LBA -> CHS (2 heads): sector = lba % spt + 1, head = (lba / spt) & 1,
+    ; cylinder = (lba / spt) >> 1
+    mov ax, si
+    xor dx, dx
+    mov cx, SECTORS_PER_TRACK
+    div cx                  ; AX = lba / spt, DX = lba % spt
+    mov cl, dl
+    inc cl                  ; CL = sector (1-based)
+    mov dh, al
+    and dh, 1               ; DH = head
+    shr ax, 1
+    mov ch, al              ; CH = cylinder
+
+    mov dl, [BOOT_DRIVE]    ; Ensure we read from the boot disk
+    mov ax, 0x0201          ; BIOS Read Sector, 1 sector
+    int 0x13                ; BIOS Interrupt
+
+    jc disk_error           ; Check Carry Flag (BIOS Error)
+
+    cmp al, 1               ; Check Sector Count (Incomplete Read)
     jne disk_error
-    
+
+    mov ax, es
+    add ax, 0x20            ; Advance buffer by 512 bytes
+    mov es, ax
+    inc si
+    dec di
+    jnz .next_sector
+
     ret
 
 disk_error:
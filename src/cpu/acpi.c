@@ -0,0 +1,137 @@
+#include "acpi.h"
+#include "lapic.h"
+#include <stdint.h>
+
+// BIOS data area word holding the EBDA segment
+#define BDA_EBDA_SEGMENT 0x40E
+
+static int bytes_equal(const void* a, const char* b, uint32_t n) {
+    const char* p = (const char*)a;
+    for (uint32_t i = 0; i < n; i++) {
+        if (p[i] != b[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// ACPI and MP structures are valid when their bytes sum to zero
+static int checksum_ok(const void* data, uint32_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += p[i];
+    }
+    return sum == 0;
+}
+
+// Scan [start, start + length) on 16-byte boundaries for a signature
+static const void* scan(uint32_t start, uint32_t length, const char* signature,
+                        uint32_t sig_len, uint32_t check_len) {
+    for (uint32_t addr = start; addr + check_len <= start + length; addr += 16) {
+        if (bytes_equal((const void*)addr, signature, sig_len) && checksum_ok((const void*)addr, check_len)) {
+            return (const void*)addr;
+        }
+    }
+    return 0;
+}
+
+// Look in the first KB of the EBDA, then the BIOS ROM area
+static const void* find_bios_structure(const char* signature, uint32_t sig_len, uint32_t check_len) {
+    uint32_t ebda = (uint32_t)(*(volatile uint16_t*)BDA_EBDA_SEGMENT) << 4;
+    const void* found = 0;
+    if (ebda >= 0x80000 && ebda < 0xA0000) {
+        found = scan(ebda, 1024, signature, sig_len, check_len);
+    }
+    if (!found) {
+        found = scan(0x9FC00, 1024, signature, sig_len, check_len);
+    }
+    if (!found) {
+        found = scan(0xE0000, 0x20000, signature, sig_len, check_len);
+    }
+    return found;
+}
+
+static void add_cpu(cpu_topology_t* topo, uint8_t apic_id) {
+    if (topo->count < SMP_MAX_CPUS) {
+        topo->apic_ids[topo->count++] = apic_id;
+    }
+}
+
+static uint32_t madt_find_cpus(cpu_topology_t* topo) {
+    const acpi_rsdp_t* rsdp = (const acpi_rsdp_t*)find_bios_structure("RSD PTR ", 8, sizeof(acpi_rsdp_t));
+    if (!rsdp) {
+        return 0;
+    }
+    const acpi_sdt_header_t* rsdt = (const acpi_sdt_header_t*)rsdp->rsdt_address;
+    if (!rsdt || !bytes_equal(rsdt->signature, "RSDT", 4) || !checksum_ok(rsdt, rsdt->length)) {
+        return 0;
+    }
+    
+    uint32_t entries = (rsdt->length - sizeof(acpi_sdt_header_t)) / 4;
+    const uint32_t* tables = (const uint32_t*)(rsdt + 1);
+    for (uint32_t i = 0; i < entries; i++) {
+        const acpi_sdt_header_t* madt = (const acpi_sdt_header_t*)tables[i];
+        if (!bytes_equal(madt->signature, "APIC", 4) || !checksum_ok(madt, madt->length)) {
+            continue;
+        }
+        
+        // Local APIC address, flags, then variable-length entries
+        const uint8_t* p = (const uint8_t*)(madt + 1);
+        const uint8_t* end = (const uint8_t*)madt + madt->length;
+        topo->lapic_base = *(const uint32_t*)p;
+        p += 8;
+        while (p + 2 <= end && p[1] >= 2) {
+            // Processor ID, APIC ID, flags
+            if (p[0] == MADT_LOCAL_APIC && (*(const uint32_t*)(p + 4) & MADT_LAPIC_ENABLED)) {
+                add_cpu(topo, p[3]);
+            }
+            p += p[1];
+        }
+        topo->source = CPU_SOURCE_ACPI;
+        return topo->count;
+    }
+    return 0;
+}
+
+static uint32_t mp_find_cpus(cpu_topology_t* topo) {
+    const uint8_t* fps = (const uint8_t*)find_bios_structure("_MP_", 4, 16);
+    if (!fps) {
+        return 0;
+    }
+    const uint8_t* config = (const uint8_t*)*(const uint32_t*)(fps + 4);
+    if (!config || !bytes_equal(config, "PCMP", 4) || !checksum_ok(config, *(const uint16_t*)(config + 4))) {
+        return 0;
+    }
+    
+    // Header: entry count at 34, LAPIC address at 36, entries from 44.
+    // Processor entries are 20 bytes, every other kind 8.
+    uint16_t count = *(const uint16_t*)(config + 34);
+    topo->lapic_base = *(const uint32_t*)(config + 36);
+    const uint8_t* p = config + 44;
+    for (uint16_t i = 0; i < count; i++) {
+        if (p[0] == MP_ENTRY_PROCESSOR) {
+            if (p[3] & MP_PROCESSOR_ENABLED) {
+                add_cpu(topo, p[1]);
+            }
+            p += 20;
+        } else {
+            p += 8;
+        }
+    }
+    topo->source = CPU_SOURCE_MP;
+    return topo->count;
+}
+
+uint32_t acpi_find_cpus(cpu_topology_t* topo) {
+    topo->count = 0;
+    topo->lapic_base = LAPIC_DEFAULT_BASE;
+    topo->source = CPU_SOURCE_NONE;
+    
+    if (madt_find_cpus(topo)) {
+        return topo->count;
+    }
+    topo->count = 0;
+    topo->lapic_base = LAPIC_DEFAULT_BASE;
+    return mp_find_cpus(topo);
+}
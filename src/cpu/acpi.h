@@ -0,0 +1,54 @@
+#ifndef ACPI_H
+#define ACPI_H
+
+#include <stdint.h>
+#include "smp.h"
+
+// Where the processor list came from
+#define CPU_SOURCE_NONE 0
+#define CPU_SOURCE_ACPI 1       // ACPI MADT
+#define CPU_SOURCE_MP 2         // Intel MultiProcessor tables
+
+// Processors the firmware reports as usable
+typedef struct {
+    uint32_t count;
+    uint8_t apic_ids[SMP_MAX_CPUS];
+    uint32_t lapic_base;
+    uint32_t source;
+} cpu_topology_t;
+
+// ACPI table header
+typedef struct {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) acpi_sdt_header_t;
+
+// Root System Description Pointer (ACPI 1.0 part)
+typedef struct {
+    char signature[8];          // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+} __attribute__((packed)) acpi_rsdp_t;
+
+// MADT entry types
+#define MADT_LOCAL_APIC 0
+#define MADT_LAPIC_ENABLED 0x01
+
+// MP floating pointer / configuration table entry types
+#define MP_ENTRY_PROCESSOR 0
+#define MP_PROCESSOR_ENABLED 0x01
+
+// Fill topo from the ACPI MADT, falling back to the MP tables. Returns
+// the number of processors found (0 if neither table exists).
+uint32_t acpi_find_cpus(cpu_topology_t* topo);
+
+#endif
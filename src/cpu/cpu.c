@@ -0,0 +1,161 @@
+#include "cpu.h"
+#include "../drivers/screen.h"
+#include <stdint.h>
+
+static cpu_info_t cpu_info;
+
+// Enable the x87 FPU and, if present, SSE/SSE2
+static void cpu_enable_fpu(void) {
+    uint32_t cr0, cr4;
+    
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    cr0 &= ~CR0_EM;             // Use the real FPU instead of trapping
+    cr0 |= CR0_MP | CR0_NE;
+    __asm__ volatile("mov %0, %%cr0" : : "r"(cr0));
+    __asm__ volatile("fninit");
+    
+    if ((cpu_info.edx & CPUID_EDX_FXSR) && (cpu_info.edx & CPUID_EDX_SSE)) {
+        __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+        cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+        __asm__ volatile("mov %0, %%cr4" : : "r"(cr4));
+    }
+}
+
+static void cpu_add_cache(uint32_t level, uint32_t type, uint32_t line, uint32_t ways, uint32_t size) {
+    if (cpu_info.num_caches == CPU_MAX_CACHES || !size) {
+        return;
+    }
+    cpu_cache_t* cache = &cpu_info.caches[cpu_info.num_caches++];
+    cache->level = (uint8_t)level;
+    cache->type = (uint8_t)type;
+    cache->line = (uint16_t)line;
+    cache->ways = ways;
+    cache->size = size;
+}
+
+// Deterministic cache parameters: leaf 4 on Intel, 0x8000001D on AMD,
+// same layout. Returns the number of caches found.
+static uint32_t cpu_read_cache_leaf(uint32_t leaf) {
+    uint32_t a, b, c, d;
+    uint32_t found = 0;
+    
+    for (uint32_t i = 0; i < CPU_MAX_CACHES; i++) {
+        cpuid_count(leaf, i, &a, &b, &c, &d);
+        uint32_t type = a & 0x1F;
+        if (!type) {
+            break;
+        }
+        uint32_t line = (b & 0xFFF) + 1;
+        uint32_t partitions = ((b >> 12) & 0x3FF) + 1;
+        uint32_t ways = (b >> 22) + 1;
+        uint32_t sets = c + 1;
+        cpu_add_cache((a >> 5) & 7, type, line, ways, ways * partitions * line * sets);
+        found++;
+    }
+    return found;
+}
+
+static void cpu_read_caches(void) {
+    uint32_t a, b, c, d;
+    
+    if (cpu_info.max_leaf >= 4 && cpu_read_cache_leaf(4)) {
+        return;
+    }
+    if (cpu_info.max_ext_leaf >= 0x8000001D && cpu_read_cache_leaf(0x8000001D)) {
+        return;
+    }
+    
+    // Older AMD (and QEMU's default models): L1 data in 0x80000005 ECX,
+    // L2 and L3 in 0x80000006 ECX/EDX. Associativity is left unknown.
+    if (cpu_info.max_ext_leaf >= 0x80000005) {
+        cpuid(0x80000005, &a, &b, &c, &d);
+        cpu_add_cache(1, CPU_CACHE_DATA, c & 0xFF, 0, (c >> 24) * 1024);
+    }
+    if (cpu_info.max_ext_leaf >= 0x80000006) {
+        cpuid(0x80000006, &a, &b, &c, &d);
+        cpu_add_cache(2, CPU_CACHE_UNIFIED, c & 0xFF, 0, (c >> 16) * 1024);
+        cpu_add_cache(3, CPU_CACHE_UNIFIED, d & 0xFF, 0, (d >> 18) * 512 * 1024);
+    }
+}
+
+void cpu_init(void) {
+    uint32_t a, b, c, d;
+    
+    // Leaf 0: highest leaf and vendor string (EBX, EDX, ECX order)
+    cpuid(0, &a, &b, &c, &d);
+    cpu_info.max_leaf = a;
+    *(uint32_t*)&cpu_info.vendor[0] = b;
+    *(uint32_t*)&cpu_info.vendor[4] = d;
+    *(uint32_t*)&cpu_info.vendor[8] = c;
+    cpu_info.vendor[12] = '\0';
+    
+    // Leaf 1: feature flags
+    if (cpu_info.max_leaf >= 1) {
+        cpuid(1, &a, &b, &c, &d);
+        cpu_info.signature = a;
+        cpu_info.edx = d;
+        cpu_info.ecx = c;
+    }
+    
+    // Leaf 7: structured extended features
+    if (cpu_info.max_leaf >= 7) {
+        cpuid(7, &a, &b, &c, &d);
+        cpu_info.leaf7_ebx = b;
+    }
+    
+    // Extended leaves
+    cpuid(0x80000000, &a, &b, &c, &d);
+    cpu_info.max_ext_leaf = a;
+    if (cpu_info.max_ext_leaf >= 0x80000001) {
+        cpuid(0x80000001, &a, &b, &c, &d);
+        cpu_info.ext_edx = d;
+    }
+    
+    cpu_read_caches();
+    
+    // The BSP is CPU 0 for RDTSCP readers (APs set theirs in smp.c)
+    if (cpu_info.ext_edx & CPUID_EXT_EDX_RDTSCP) {
+        wrmsr(MSR_TSC_AUX, 0);
+    }
+    
+    cpu_enable_fpu();
+    
+    // The math kernels are built with -msse2
+    if (!(cpu_info.edx & CPUID_EDX_SSE2)) {
+        kprint("Warning: CPU lacks SSE2, math kernels will fault\n");
+    }
+}
+
+void cpu_init_ap(void) {
+    cpu_enable_fpu();
+}
+
+const cpu_info_t* cpu_get_info(void) {
+    return &cpu_info;
+}
+
+int cpu_has_edx(uint32_t bit) {
+    return (cpu_info.edx & bit) != 0;
+}
+
+int cpu_has_ecx(uint32_t bit) {
+    return (cpu_info.ecx & bit) != 0;
+}
+
+int cpu_has_leaf7_ebx(uint32_t bit) {
+    return (cpu_info.leaf7_ebx & bit) != 0;
+}
+
+int cpu_has_ext_edx(uint32_t bit) {
+    return (cpu_info.ext_edx & bit) != 0;
+}
+
+const cpu_cache_t* cpu_data_cache(uint32_t level) {
+    for (uint32_t i = 0; i < cpu_info.num_caches; i++) {
+        const cpu_cache_t* cache = &cpu_info.caches[i];
+        if (cache->level == level && cache->type != CPU_CACHE_CODE) {
+            return cache;
+        }
+    }
+    return 0;
+}
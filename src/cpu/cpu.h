@@ -0,0 +1,149 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+// CPUID leaf 1 EDX feature bits
+#define CPUID_EDX_FPU   (1 << 0)
+#define CPUID_EDX_TSC   (1 << 4)
+#define CPUID_EDX_APIC  (1 << 9)
+#define CPUID_EDX_FXSR  (1 << 24)
+#define CPUID_EDX_SSE   (1 << 25)
+#define CPUID_EDX_SSE2  (1 << 26)
+
+// CPUID leaf 1 ECX feature bits
+#define CPUID_ECX_SSE3  (1 << 0)
+#define CPUID_ECX_SSSE3 (1 << 9)
+#define CPUID_ECX_SSE41 (1 << 19)
+#define CPUID_ECX_TSC_DEADLINE (1 << 24)
+
+// CPUID leaf 7 (subleaf 0) EBX feature bits
+#define CPUID_7_EBX_ERMS (1 << 9)   // Enhanced REP MOVSB/STOSB
+
+// CPUID leaf 0x80000001 EDX feature bits
+#define CPUID_EXT_EDX_RDTSCP (1 << 27)
+
+// Per-CPU value returned by RDTSCP in ECX
+#define MSR_TSC_AUX     0xC0000103
+
+// Control register bits
+#define CR0_MP          (1 << 1)    // Monitor coprocessor
+#define CR0_EM          (1 << 2)    // x87 emulation
+#define CR0_NE          (1 << 5)    // Native FPU error reporting
+#define CR4_OSFXSR      (1 << 9)    // OS supports FXSAVE/FXRSTOR (enables SSE)
+#define CR4_OSXMMEXCPT  (1 << 10)   // OS handles SIMD FP exceptions
+
+// Cache types (CPUID leaf 4 / 0x8000001D EAX[4:0])
+#define CPU_CACHE_DATA      1
+#define CPU_CACHE_CODE      2
+#define CPU_CACHE_UNIFIED   3
+
+#define CPU_MAX_CACHES 8
+
+typedef struct {
+    uint8_t level;
+    uint8_t type;           // CPU_CACHE_*
+    uint16_t line;          // Bytes
+    uint32_t ways;          // 0 if unknown
+    uint32_t size;          // Bytes
+} cpu_cache_t;
+
+// Features detected by cpu_init()
+typedef struct {
+    uint32_t signature;     // CPUID leaf 1 EAX (family, model, stepping)
+    uint32_t edx;           // CPUID leaf 1 EDX
+    uint32_t ecx;           // CPUID leaf 1 ECX
+    uint32_t leaf7_ebx;     // CPUID leaf 7 EBX
+    uint32_t ext_edx;       // CPUID leaf 0x80000001 EDX
+    uint32_t max_leaf;      // Highest standard CPUID leaf
+    uint32_t max_ext_leaf;  // Highest extended CPUID leaf
+    char vendor[13];        // Vendor string, NUL terminated
+    uint32_t num_caches;
+    cpu_cache_t caches[CPU_MAX_CACHES];
+} cpu_info_t;
+
+// Execute CPUID for the given leaf
+static inline void cpuid(uint32_t leaf, uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d) {
+    __asm__ volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+// CPUID for leaves with subleaves (ECX input)
+static inline void cpuid_count(uint32_t leaf, uint32_t subleaf,
+                               uint32_t* a, uint32_t* b, uint32_t* c, uint32_t* d) {
+    __asm__ volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(subleaf));
+}
+
+// Read the time stamp counter
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Read the time stamp counter and TSC_AUX together. Waits for earlier
+// instructions to finish, so it also marks the end of a timed region.
+static inline uint64_t rdtscp(uint32_t* aux) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdtscp" : "=a"(lo), "=d"(hi), "=c"(*aux));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Model-specific registers
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    __asm__ volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    __asm__ volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// Interrupt flag in EFLAGS
+#define EFLAGS_IF (1 << 9)
+
+static inline uint32_t cpu_get_flags(void) {
+    uint32_t flags;
+    __asm__ volatile("pushf; pop %0" : "=r"(flags));
+    return flags;
+}
+
+// Disable interrupts, returning the previous EFLAGS for cpu_irq_restore
+static inline uint32_t cpu_irq_save(void) {
+    uint32_t flags;
+    __asm__ volatile("pushf; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void cpu_irq_restore(uint32_t flags) {
+    if (flags & EFLAGS_IF) {
+        __asm__ volatile("sti" ::: "memory");
+    }
+}
+
+// Detect CPU features and enable the FPU and SSE units
+void cpu_init(void);
+
+// Enable the FPU and SSE on an application processor (features are
+// assumed identical to the BSP's)
+void cpu_init_ap(void);
+
+// Detected CPU information
+const cpu_info_t* cpu_get_info(void);
+
+// Check a leaf 1 EDX feature bit
+int cpu_has_edx(uint32_t bit);
+
+// Check a leaf 1 ECX feature bit
+int cpu_has_ecx(uint32_t bit);
+
+// Check a leaf 7 EBX feature bit
+int cpu_has_leaf7_ebx(uint32_t bit);
+
+// Check a leaf 0x80000001 EDX feature bit
+int cpu_has_ext_edx(uint32_t bit);
+
+// The data (or unified) cache at 'level', or NULL if CPUID did not report one
+const cpu_cache_t* cpu_data_cache(uint32_t level);
+
+#endif
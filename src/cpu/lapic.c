@@ -0,0 +1,85 @@
+#include "lapic.h"
+#include "cpu.h"
+#include <stdint.h>
+
+static volatile uint32_t* lapic_base = 0;
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return lapic_base[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_base[reg / 4] = value;
+}
+
+void lapic_init(uint32_t base) {
+    if (!cpu_has_edx(CPUID_EDX_APIC)) {
+        return;
+    }
+    uint64_t msr = rdmsr(MSR_APIC_BASE);
+    if (!base) {
+        base = (uint32_t)msr & 0xFFFFF000;
+    }
+    lapic_base = (volatile uint32_t*)base;
+    
+    // Make sure the APIC is globally enabled at the address we use
+    wrmsr(MSR_APIC_BASE, (base & 0xFFFFF000) | MSR_APIC_BASE_ENABLE | ((uint32_t)msr & 0xFFF));
+    lapic_enable();
+}
+
+int lapic_available(void) {
+    return lapic_base != 0;
+}
+
+void lapic_enable(void) {
+    // LINT0/LINT1 keep their virtual-wire setup, so the 8259 PIC still
+    // delivers legacy IRQs to the BSP
+    lapic_write(LAPIC_REG_TPR, 0);
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+uint32_t lapic_id(void) {
+    return lapic_base ? lapic_read(LAPIC_REG_ID) >> 24 : 0;
+}
+
+void lapic_eoi(void) {
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+static void lapic_send_ipi(uint8_t apic_id, uint32_t command) {
+    lapic_write(LAPIC_REG_ESR, 0);
+    lapic_write(LAPIC_REG_ICR_HI, (uint32_t)apic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LO, command);
+    while (lapic_read(LAPIC_REG_ICR_LO) & LAPIC_ICR_PENDING) {
+        __asm__ volatile("pause");
+    }
+}
+
+void lapic_send_init(uint8_t apic_id) {
+    lapic_send_ipi(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_ASSERT | LAPIC_ICR_LEVEL);
+}
+
+void lapic_send_startup(uint8_t apic_id, uint8_t vector) {
+    lapic_send_ipi(apic_id, LAPIC_ICR_STARTUP | vector);
+}
+
+void lapic_timer_start(uint8_t vector, uint32_t mode, uint32_t count) {
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIV16);
+    lapic_write(LAPIC_REG_LVT_TIMER, mode | vector);
+    if (mode != LAPIC_TIMER_TSC_DEADLINE) {
+        lapic_write(LAPIC_REG_TIMER_INIT, count);
+    }
+}
+
+void lapic_timer_stop(void) {
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+}
+
+uint32_t lapic_timer_current(void) {
+    return lapic_read(LAPIC_REG_TIMER_CURRENT);
+}
+
+void lapic_timer_set_deadline(uint64_t tsc) {
+    wrmsr(MSR_TSC_DEADLINE, tsc);
+}
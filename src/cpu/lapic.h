@@ -0,0 +1,73 @@
+#ifndef LAPIC_H
+#define LAPIC_H
+
+#include <stdint.h>
+
+#define LAPIC_DEFAULT_BASE 0xFEE00000
+
+// Register offsets
+#define LAPIC_REG_ID 0x020
+#define LAPIC_REG_VERSION 0x030
+#define LAPIC_REG_TPR 0x080
+#define LAPIC_REG_EOI 0x0B0
+#define LAPIC_REG_SVR 0x0F0
+#define LAPIC_REG_ESR 0x280
+#define LAPIC_REG_ICR_LO 0x300
+#define LAPIC_REG_ICR_HI 0x310
+#define LAPIC_REG_LVT_TIMER 0x320
+#define LAPIC_REG_TIMER_INIT 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE 0x3E0
+
+// Spurious vector register
+#define LAPIC_SVR_ENABLE 0x100
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+// Interrupt command register
+#define LAPIC_ICR_INIT 0x00000500
+#define LAPIC_ICR_STARTUP 0x00000600
+#define LAPIC_ICR_PENDING 0x00001000   // Delivery status
+#define LAPIC_ICR_ASSERT 0x00004000
+#define LAPIC_ICR_LEVEL 0x00008000
+
+// Timer LVT modes and divider
+#define LAPIC_TIMER_ONESHOT 0x00000
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_TSC_DEADLINE 0x40000
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_TIMER_DIV16 0x3
+#define LAPIC_TIMER_DIVISOR 16
+
+// MSR holding the APIC base and global enable bit
+#define MSR_APIC_BASE 0x1B
+#define MSR_APIC_BASE_ENABLE (1 << 11)
+
+// Absolute TSC value at which a TSC-deadline timer fires (0 disarms)
+#define MSR_TSC_DEADLINE 0x6E0
+
+// Record the MMIO base (from ACPI/MP tables, or 0 to take it from the
+// APIC base MSR) and enable the BSP's APIC
+void lapic_init(uint32_t base);
+int lapic_available(void);
+
+// Software-enable the calling CPU's local APIC
+void lapic_enable(void);
+
+// APIC ID of the calling CPU
+uint32_t lapic_id(void);
+
+void lapic_eoi(void);
+
+// INIT / STARTUP inter-processor interrupts for AP bring-up. The startup
+// vector is the trampoline's physical page number (address >> 12).
+void lapic_send_init(uint8_t apic_id);
+void lapic_send_startup(uint8_t apic_id, uint8_t vector);
+
+// Timer on the calling CPU, counting at bus clock / LAPIC_TIMER_DIVISOR.
+// count is ignored in TSC-deadline mode; arm it with a deadline instead.
+void lapic_timer_start(uint8_t vector, uint32_t mode, uint32_t count);
+void lapic_timer_stop(void);
+uint32_t lapic_timer_current(void);
+void lapic_timer_set_deadline(uint64_t tsc);
+
+#endif
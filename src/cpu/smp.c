@@ -0,0 +1,127 @@
+#include "smp.h"
+#include "acpi.h"
+#include "lapic.h"
+#include "cpu.h"
+#include "work.h"
+#include "../drivers/screen.h"
+#include "../drivers/timer.h"
+#include "../interrupt/idt.h"
+#include "../memory/memory.h"
+#include "../libc/printf.h"
+#include <stdint.h>
+
+// Start-up code and its patch slots (cpu/trampoline.asm)
+extern uint8_t trampoline_start[];
+extern uint8_t trampoline_end[];
+extern uint8_t trampoline_stack[];
+extern uint8_t trampoline_entry[];
+
+// Delays of the INIT-SIPI-SIPI sequence, and how long to wait for an AP
+// to report in
+#define SMP_INIT_DELAY_NS 10000000ULL
+#define SMP_SIPI_DELAY_NS 200000ULL
+#define SMP_AP_TIMEOUT_NS 100000000ULL
+
+static cpu_topology_t topology;
+static volatile uint32_t cpus_online = 1;
+static uint8_t apic_to_index[256];
+static uint8_t smp_ready = 0;
+static uint8_t has_rdtscp = 0;
+
+// C entry point of every AP, on its own stack with interrupts off
+static void smp_ap_main(void) {
+    idt_load();
+    cpu_init_ap();
+    if (has_rdtscp) {
+        wrmsr(MSR_TSC_AUX, apic_to_index[lapic_id() & 0xFF]);
+    }
+    lapic_enable();
+    __sync_fetch_and_add(&cpus_online, 1);
+    work_worker_loop();
+}
+
+// INIT-SIPI-SIPI; returns 1 once the AP has incremented cpus_online
+static int smp_start_ap(uint8_t apic_id, uint32_t index) {
+    uint8_t* stack = (uint8_t*)kmalloc(SMP_AP_STACK_SIZE);
+    if (!stack) {
+        return 0;
+    }
+    uint32_t slot = SMP_TRAMPOLINE_ADDR;
+    *(volatile uint32_t*)(slot + (trampoline_stack - trampoline_start)) = (uint32_t)(stack + SMP_AP_STACK_SIZE);
+    *(volatile uint32_t*)(slot + (trampoline_entry - trampoline_start)) = (uint32_t)smp_ap_main;
+    apic_to_index[apic_id] = (uint8_t)index;
+    
+    uint32_t expected = cpus_online + 1;
+    lapic_send_init(apic_id);
+    timer_sleep_ns(SMP_INIT_DELAY_NS);
+    
+    for (int attempt = 0; attempt < 2; attempt++) {
+        lapic_send_startup(apic_id, SMP_TRAMPOLINE_ADDR >> 12);
+        timer_sleep_ns(SMP_SIPI_DELAY_NS);
+        uint64_t deadline = timer_now_ns() + SMP_AP_TIMEOUT_NS;
+        while (cpus_online < expected && timer_now_ns() < deadline) {
+            __asm__ volatile("pause");
+        }
+        if (cpus_online == expected) {
+            return 1;
+        }
+    }
+    
+    // The stack stays allocated: a late AP could still be using it
+    return 0;
+}
+
+uint32_t smp_init(void) {
+    has_rdtscp = cpu_has_ext_edx(CPUID_EXT_EDX_RDTSCP);
+    if (!acpi_find_cpus(&topology) || !cpu_has_edx(CPUID_EDX_APIC)) {
+        kprint("SMP: no MP/ACPI processor tables, running on 1 CPU\n");
+        return 1;
+    }
+    lapic_init(topology.lapic_base);
+    
+    uint32_t bsp_id = lapic_id();
+    apic_to_index[bsp_id] = 0;
+    smp_ready = 1;
+    
+    // Copy the start-up code below 1MB where real mode can reach it
+    uint8_t* dst = (uint8_t*)SMP_TRAMPOLINE_ADDR;
+    for (uint8_t* src = trampoline_start; src < trampoline_end; src++) {
+        *dst++ = *src;
+    }
+    
+    for (uint32_t i = 0; i < topology.count; i++) {
+        uint8_t apic_id = topology.apic_ids[i];
+        if (apic_id == bsp_id || cpus_online >= SMP_MAX_CPUS) {
+            continue;
+        }
+        if (!smp_start_ap(apic_id, cpus_online)) {
+            kprintf("SMP: AP %u did not start\n", apic_id);
+        }
+    }
+    
+    kprintf("SMP: %u CPU%s online (%s)\n", cpus_online, cpus_online == 1 ? "" : "s",
+            topology.source == CPU_SOURCE_ACPI ? "ACPI MADT" : "MP table");
+    return cpus_online;
+}
+
+uint32_t smp_cpu_count(void) {
+    return cpus_online;
+}
+
+uint32_t smp_cpu_index(void) {
+    // TSC_AUX holds the index, which saves an uncached LAPIC read
+    if (has_rdtscp) {
+        uint32_t index;
+        rdtscp(&index);
+        return index;
+    }
+    return smp_ready ? apic_to_index[lapic_id() & 0xFF] : 0;
+}
+
+uint64_t smp_tsc(uint32_t* cpu) {
+    if (has_rdtscp) {
+        return rdtscp(cpu);
+    }
+    *cpu = smp_ready ? apic_to_index[lapic_id() & 0xFF] : 0;
+    return rdtsc();
+}
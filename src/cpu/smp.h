@@ -0,0 +1,28 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+
+#define SMP_MAX_CPUS 16
+
+// Application processors start in real mode at this page-aligned
+// address (free low memory between the boot sector and the kernel)
+#define SMP_TRAMPOLINE_ADDR 0x8000
+#define SMP_AP_STACK_SIZE (16 * 1024)
+
+// Discover processors, start every AP and park them in the work-stealing
+// loop. Needs the heap, timer_init() (it times the start-up sequence)
+// and cpu_init() done. Returns the number of online CPUs.
+uint32_t smp_init(void);
+
+// Online CPUs (1 until smp_init has run)
+uint32_t smp_cpu_count(void);
+
+// Index of the calling CPU in [0, smp_cpu_count()); 0 is the BSP
+uint32_t smp_cpu_index(void);
+
+// Time stamp counter and the index of the CPU it was read on, in one
+// RDTSCP where the CPU has it
+uint64_t smp_tsc(uint32_t* cpu);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+
+// Test-and-test-and-set lock. Holders must not sleep or take interrupts
+// that acquire the same lock.
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT { 0 }
+
+static inline void cpu_relax(void) {
+    __asm__ volatile("pause" ::: "memory");
+}
+
+static inline void spin_lock(spinlock_t* lock) {
+    while (__sync_lock_test_and_set(&lock->locked, 1)) {
+        while (lock->locked) {
+            cpu_relax();
+        }
+    }
+}
+
+static inline int spin_trylock(spinlock_t* lock) {
+    return !lock->locked && !__sync_lock_test_and_set(&lock->locked, 1);
+}
+
+static inline void spin_unlock(spinlock_t* lock) {
+    __sync_lock_release(&lock->locked);
+}
+
+#endif
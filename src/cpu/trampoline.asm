@@ -0,0 +1,66 @@
+; Application processor start-up code
+; smp_init() copies trampoline_start..trampoline_end to TRAMPOLINE_BASE,
+; patches the stack and entry slots and sends STARTUP IPIs with vector
+; TRAMPOLINE_BASE >> 12. Each AP starts here in real mode at CS:IP =
+; 0800:0000, switches to protected mode with the kernel's flat segments
+; and calls the C entry point on its own stack.
+
+TRAMPOLINE_BASE equ 0x8000
+
+; Absolute address of a label once the code is copied
+%define ABS(label) (TRAMPOLINE_BASE + (label) - trampoline_start)
+
+section .text
+
+global trampoline_start
+global trampoline_end
+global trampoline_stack
+global trampoline_entry
+
+[bits 16]
+trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    lgdt [ABS(tramp_gdt_descriptor)]
+    
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword 0x08:ABS(tramp_protected)
+
+[bits 32]
+tramp_protected:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    
+    mov esp, [ABS(trampoline_stack)]
+    mov eax, [ABS(trampoline_entry)]
+    call eax                ; Does not return
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+; Same flat layout as the boot GDT (code 0x08, data 0x10)
+align 8
+tramp_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF
+    dq 0x00CF92000000FFFF
+tramp_gdt_descriptor:
+    dw tramp_gdt_descriptor - tramp_gdt - 1
+    dd ABS(tramp_gdt)
+
+; Patched by the BSP before each start-up
+align 4
+trampoline_stack:
+    dd 0
+trampoline_entry:
+    dd 0
+trampoline_end:
@@ -0,0 +1,120 @@
+#include "work.h"
+#include "smp.h"
+#include "../kernel/thread.h"
+#include <stdint.h>
+
+static work_queue_t queues[SMP_MAX_CPUS];
+
+static int queue_push(work_queue_t* q, work_job_t* job, uint32_t index) {
+    int ok = 0;
+    spin_lock(&q->lock);
+    if (q->tail - q->head < WORK_QUEUE_SIZE) {
+        work_item_t* item = &q->items[q->tail % WORK_QUEUE_SIZE];
+        item->job = job;
+        item->index = index;
+        q->tail++;
+        ok = 1;
+    }
+    spin_unlock(&q->lock);
+    return ok;
+}
+
+// Owner side: newest item
+static int queue_pop(work_queue_t* q, work_item_t* out) {
+    int ok = 0;
+    if (q->tail == q->head) {
+        return 0;
+    }
+    spin_lock(&q->lock);
+    if (q->tail != q->head) {
+        q->tail--;
+        *out = q->items[q->tail % WORK_QUEUE_SIZE];
+        ok = 1;
+    }
+    spin_unlock(&q->lock);
+    return ok;
+}
+
+// Thief side: oldest item; gives up instead of waiting on a busy lock
+static int queue_steal(work_queue_t* q, work_item_t* out) {
+    int ok = 0;
+    if (q->tail == q->head || !spin_trylock(&q->lock)) {
+        return 0;
+    }
+    if (q->tail != q->head) {
+        *out = q->items[q->head % WORK_QUEUE_SIZE];
+        q->head++;
+        ok = 1;
+    }
+    spin_unlock(&q->lock);
+    return ok;
+}
+
+static void run_item(const work_item_t* item) {
+    item->job->fn(item->job->arg, item->index);
+    __sync_fetch_and_sub(&item->job->remaining, 1);
+}
+
+// Run one item from our own queue or stolen from another CPU
+static int work_run_one(uint32_t self, uint32_t cpus) {
+    work_item_t item;
+    if (queue_pop(&queues[self], &item)) {
+        run_item(&item);
+        return 1;
+    }
+    for (uint32_t i = 1; i < cpus; i++) {
+        uint32_t victim = (self + i) % cpus;
+        if (queue_steal(&queues[victim], &item)) {
+            run_item(&item);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void work_parallel_for(work_fn_t fn, void* arg, uint32_t count) {
+    uint32_t cpus = smp_cpu_count();
+    
+    if (cpus == 1 || count == 1) {
+        for (uint32_t i = 0; i < count; i++) {
+            fn(arg, i);
+        }
+        return;
+    }
+    
+    work_job_t job;
+    job.fn = fn;
+    job.arg = arg;
+    job.remaining = count;
+    
+    // Deal the items round-robin so every CPU starts with local work;
+    // stealing evens out whatever imbalance remains
+    uint32_t self = smp_cpu_index();
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t target = (self + i) % cpus;
+        if (!queue_push(&queues[target], &job, i)) {
+            fn(arg, i);
+            __sync_fetch_and_sub(&job.remaining, 1);
+        }
+    }
+    
+    // While the APs finish, the BSP can run other kernel threads (such as
+    // a dataset loader) instead of spinning
+    while (job.remaining) {
+        if (!work_run_one(self, cpus)) {
+            if (self == 0) {
+                thread_yield();
+            }
+            cpu_relax();
+        }
+    }
+}
+
+void work_worker_loop(void) {
+    uint32_t self = smp_cpu_index();
+    for (;;) {
+        if (!work_run_one(self, smp_cpu_count())) {
+            cpu_relax();
+        }
+    }
+}
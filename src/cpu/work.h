@@ -0,0 +1,43 @@
+#ifndef WORK_H
+#define WORK_H
+
+#include <stdint.h>
+#include "smp.h"
+#include "spinlock.h"
+
+// Items per CPU queue; pushes beyond this run inline
+#define WORK_QUEUE_SIZE 256
+
+typedef void (*work_fn_t)(void* arg, uint32_t index);
+
+// A parallel_for call in flight
+typedef struct {
+    work_fn_t fn;
+    void* arg;
+    volatile uint32_t remaining;
+} work_job_t;
+
+typedef struct {
+    work_job_t* job;
+    uint32_t index;
+} work_item_t;
+
+// Per-CPU deque: the owner pushes and pops at the tail (LIFO, cache
+// warm), idle CPUs steal from the head (oldest work first). Padded to its
+// own cache lines so owners do not false-share.
+typedef struct {
+    spinlock_t lock;
+    uint32_t head;
+    uint32_t tail;
+    work_item_t items[WORK_QUEUE_SIZE];
+} __attribute__((aligned(64))) work_queue_t;
+
+// Run fn(arg, i) for every i in [0, count) across all online CPUs and
+// return when all have finished. The caller works too, and calls may
+// nest (a waiting CPU keeps running other work).
+void work_parallel_for(work_fn_t fn, void* arg, uint32_t count);
+
+// Idle loop of an application processor; never returns
+void work_worker_loop(void);
+
+#endif
@@ -0,0 +1,331 @@
+#include "ata.h"
+#include "ports.h"
+#include "screen.h"
+#include "../interrupt/isr.h"
+#include "../interrupt/idt.h"
+#include "../kernel/prof.h"
+#include "../libc/printf.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Status polls before a command is considered hung
+#define ATA_TIMEOUT 1000000
+
+static ata_drive_t drives[2];
+
+// Interrupt-driven command in flight on the channel (one at a time for
+// both drives)
+static struct {
+    ata_drive_t* drive;         // NULL when idle
+    block_request_t* req;       // Request the next sector belongs to
+    uint32_t offset;            // Sectors already moved for req
+    uint32_t remaining;         // Sectors still to transfer
+    uint8_t write;
+} channel;
+
+static inline uint8_t ata_status(void) {
+    return port_byte_in(ATA_PRIMARY_IO + ATA_REG_STATUS);
+}
+
+// Reading the alternate status four times gives the drive the 400ns it
+// needs to update status after a command or drive select
+static void ata_delay(void) {
+    for (int i = 0; i < 4; i++) {
+        port_byte_in(ATA_PRIMARY_CTRL);
+    }
+}
+
+static int ata_wait_not_busy(void) {
+    for (uint32_t i = 0; i < ATA_TIMEOUT; i++) {
+        if (!(ata_status() & ATA_SR_BSY)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Wait until the drive has a sector ready (or failed)
+static int ata_wait_drq(void) {
+    for (uint32_t i = 0; i < ATA_TIMEOUT; i++) {
+        uint8_t status = ata_status();
+        if (status & ATA_SR_BSY) {
+            continue;
+        }
+        if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+            return 0;
+        }
+        if (status & ATA_SR_DRQ) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Select the drive and load an LBA28 address and sector count
+// (a count of 256 is sent as 0)
+static int ata_setup(const ata_drive_t* drive, uint32_t lba, uint32_t count) {
+    if (!ata_wait_not_busy()) {
+        return 0;
+    }
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_DRIVE, 0xE0 | (drive->slave << 4) | ((lba >> 24) & 0x0F));
+    ata_delay();
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_SECCOUNT, (uint8_t)count);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_LO, (uint8_t)lba);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_MID, (uint8_t)(lba >> 8));
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_HI, (uint8_t)(lba >> 16));
+    return 1;
+}
+
+int ata_read_sectors(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buf) {
+    if (count == 0 || count > 256 || !ata_setup(drive, lba, count)) {
+        return 0;
+    }
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, ATA_CMD_READ_PIO);
+    
+    uint8_t* dst = (uint8_t*)buf;
+    for (uint32_t s = 0; s < count; s++) {
+        ata_delay();
+        if (!ata_wait_drq()) {
+            return 0;
+        }
+        port_words_in(ATA_PRIMARY_IO + ATA_REG_DATA, dst, BLOCK_SECTOR_SIZE / 2);
+        dst += BLOCK_SECTOR_SIZE;
+    }
+    return 1;
+}
+
+int ata_write_sectors(ata_drive_t* drive, uint32_t lba, uint32_t count, const void* buf) {
+    if (count == 0 || count > 256 || !ata_setup(drive, lba, count)) {
+        return 0;
+    }
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, ATA_CMD_WRITE_PIO);
+    
+    const uint8_t* src = (const uint8_t*)buf;
+    for (uint32_t s = 0; s < count; s++) {
+        ata_delay();
+        if (!ata_wait_drq()) {
+            return 0;
+        }
+        port_words_out(ATA_PRIMARY_IO + ATA_REG_DATA, src, BLOCK_SECTOR_SIZE / 2);
+        src += BLOCK_SECTOR_SIZE;
+    }
+    ata_delay();
+    return ata_wait_not_busy() && !(ata_status() & (ATA_SR_ERR | ATA_SR_DF));
+}
+
+int ata_flush(ata_drive_t* drive) {
+    if (!ata_wait_not_busy()) {
+        return 0;
+    }
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_DRIVE, 0xE0 | (drive->slave << 4));
+    ata_delay();
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, ATA_CMD_CACHE_FLUSH);
+    ata_delay();
+    return ata_wait_not_busy() && !(ata_status() & (ATA_SR_ERR | ATA_SR_DF));
+}
+
+// Block layer callbacks. The polled ones run with the queue locked and
+// fail if a queued command is still in flight on the channel (for either
+// drive).
+static int ata_block_read(block_device_t* dev, uint32_t lba, uint32_t count, void* buf) {
+    if (channel.drive) {
+        return 0;
+    }
+    return ata_read_sectors((ata_drive_t*)dev->driver_data, lba, count, buf);
+}
+
+static int ata_block_write(block_device_t* dev, uint32_t lba, uint32_t count, const void* buf) {
+    if (channel.drive) {
+        return 0;
+    }
+    return ata_write_sectors((ata_drive_t*)dev->driver_data, lba, count, buf);
+}
+
+static int ata_block_flush(block_device_t* dev) {
+    return ata_flush((ata_drive_t*)dev->driver_data);
+}
+
+// Buffer position of the next sector, moving along the merged chain
+static uint8_t* ata_next_sector(void) {
+    while (channel.offset == channel.req->count) {
+        channel.req = channel.req->merged;
+        channel.offset = 0;
+    }
+    return (uint8_t*)channel.req->buf + channel.offset++ * BLOCK_SECTOR_SIZE;
+}
+
+// Software reset of both drives on the channel, to get a drive that
+// timed out or stopped mid-command back to idle
+static void ata_reset(void) {
+    port_byte_out(ATA_PRIMARY_CTRL, ATA_CTRL_SRST);
+    for (int i = 0; i < 16; i++) {
+        ata_delay();            // SRST must be held for 5us
+    }
+    port_byte_out(ATA_PRIMARY_CTRL, 0);
+    ata_delay();
+    ata_wait_not_busy();
+}
+
+// Issue the command for req and its merged followers
+static int ata_block_start(block_device_t* dev, block_request_t* req) {
+    ata_drive_t* drive = (ata_drive_t*)dev->driver_data;
+    if (channel.drive) {
+        return BLOCK_START_BUSY;
+    }
+    if (!ata_setup(drive, req->lba, req->span)) {
+        ata_reset();
+        return BLOCK_START_FAILED;
+    }
+    channel.drive = drive;
+    channel.req = req;
+    channel.offset = 0;
+    channel.remaining = req->span;
+    channel.write = req->write;
+    
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, req->write ? ATA_CMD_WRITE_PIO : ATA_CMD_READ_PIO);
+    
+    // Writes supply the first sector now; the drive interrupts once it
+    // has taken each sector
+    if (req->write) {
+        ata_delay();
+        if (!ata_wait_drq()) {
+            // The drive would otherwise sit waiting for data
+            channel.drive = NULL;
+            ata_reset();
+            return BLOCK_START_FAILED;
+        }
+        port_words_out(ATA_PRIMARY_IO + ATA_REG_DATA, ata_next_sector(), BLOCK_SECTOR_SIZE / 2);
+        channel.remaining--;
+    }
+    return BLOCK_START_OK;
+}
+
+static void ata_finish(int ok) {
+    ata_drive_t* drive = channel.drive;
+    channel.drive = NULL;
+    block_complete(&drive->block, ok);
+    
+    // The other drive may have been held back by this command
+    ata_drive_t* other = &drives[!drive->slave];
+    if (other->present && !channel.drive) {
+        block_kick(&other->block);
+    }
+}
+
+// IRQ14: move one sector per interrupt
+static void ata_irq_handler(registers_t* regs) {
+    (void)regs;
+    PROF_SCOPE("ata_irq");
+    
+    // Reading status acknowledges the interrupt (polled commands raise it too)
+    uint8_t status = ata_status();
+    if (!channel.drive) {
+        return;
+    }
+    if (status & (ATA_SR_ERR | ATA_SR_DF)) {
+        ata_finish(0);
+        return;
+    }
+    
+    if (channel.write) {
+        if (channel.remaining == 0) {
+            ata_finish(1);
+            return;
+        }
+        port_words_out(ATA_PRIMARY_IO + ATA_REG_DATA, ata_next_sector(), BLOCK_SECTOR_SIZE / 2);
+        channel.remaining--;
+    } else {
+        if (!(status & ATA_SR_DRQ)) {
+            return;
+        }
+        port_words_in(ATA_PRIMARY_IO + ATA_REG_DATA, ata_next_sector(), BLOCK_SECTOR_SIZE / 2);
+        if (--channel.remaining == 0) {
+            ata_finish(1);
+        }
+    }
+}
+
+// IDENTIFY one drive; returns 0 if there is no ATA disk in the slot
+static int ata_identify(ata_drive_t* drive) {
+    uint16_t id[256];
+    
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_DRIVE, 0xA0 | (drive->slave << 4));
+    ata_delay();
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_SECCOUNT, 0);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_LO, 0);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_MID, 0);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_LBA_HI, 0);
+    port_byte_out(ATA_PRIMARY_IO + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+    ata_delay();
+    
+    // No drive (status 0, or a floating bus reading 0xFF)
+    uint8_t status = ata_status();
+    if (status == 0 || status == 0xFF || !ata_wait_not_busy()) {
+        return 0;
+    }
+    
+    // ATAPI and SATA devices set the signature registers; not handled
+    if (port_byte_in(ATA_PRIMARY_IO + ATA_REG_LBA_MID) || port_byte_in(ATA_PRIMARY_IO + ATA_REG_LBA_HI)) {
+        return 0;
+    }
+    if (!ata_wait_drq()) {
+        return 0;
+    }
+    port_words_in(ATA_PRIMARY_IO + ATA_REG_DATA, id, 256);
+    
+    drive->sectors = id[60] | ((uint32_t)id[61] << 16);
+    if (drive->sectors == 0) {
+        return 0;
+    }
+    
+    // Model string is stored as byte-swapped words, space padded
+    for (int i = 0; i < 20; i++) {
+        drive->model[2 * i] = (char)(id[27 + i] >> 8);
+        drive->model[2 * i + 1] = (char)(id[27 + i] & 0xFF);
+    }
+    int end = 40;
+    while (end > 0 && drive->model[end - 1] == ' ') {
+        end--;
+    }
+    drive->model[end] = '\0';
+    return 1;
+}
+
+uint32_t ata_init(void) {
+    static const char* names[2] = { "hda", "hdb" };
+    uint32_t found = 0;
+    
+    port_byte_out(ATA_PRIMARY_CTRL, ATA_CTRL_NIEN);
+    
+    for (uint8_t d = 0; d < 2; d++) {
+        ata_drive_t* drive = &drives[d];
+        drive->slave = d;
+        drive->present = (uint8_t)ata_identify(drive);
+        if (!drive->present) {
+            continue;
+        }
+        
+        drive->block.name = names[d];
+        drive->block.sector_count = drive->sectors;
+        drive->block.max_transfer = 256;
+        drive->block.driver_data = drive;
+        drive->block.read = ata_block_read;
+        drive->block.write = ata_block_write;
+        drive->block.flush = ata_block_flush;
+        drive->block.start = ata_block_start;
+        block_register(&drive->block);
+        found++;
+        
+        kprintf("ATA %s: %s, %u MB\n", names[d], drive->model, drive->sectors / 2048);
+    }
+    
+    // Let the drives interrupt on IRQ14 for queued requests (IRQ2 is the
+    // cascade from the slave PIC)
+    if (found) {
+        register_interrupt_handler(IRQ14, ata_irq_handler);
+        irq_clear_mask(2);
+        irq_clear_mask(14);
+        port_byte_out(ATA_PRIMARY_CTRL, 0);
+    }
+    return found;
+}
@@ -0,0 +1,59 @@
+#ifndef ATA_H
+#define ATA_H
+
+#include <stdint.h>
+#include "block.h"
+
+// Primary ATA bus
+#define ATA_PRIMARY_IO 0x1F0
+#define ATA_PRIMARY_CTRL 0x3F6
+
+// Register offsets from the I/O base
+#define ATA_REG_DATA 0
+#define ATA_REG_ERROR 1
+#define ATA_REG_SECCOUNT 2
+#define ATA_REG_LBA_LO 3
+#define ATA_REG_LBA_MID 4
+#define ATA_REG_LBA_HI 5
+#define ATA_REG_DRIVE 6
+#define ATA_REG_STATUS 7
+#define ATA_REG_COMMAND 7
+
+// Status bits
+#define ATA_SR_ERR 0x01
+#define ATA_SR_DRQ 0x08
+#define ATA_SR_DF 0x20
+#define ATA_SR_BSY 0x80
+
+// Commands
+#define ATA_CMD_READ_PIO 0x20
+#define ATA_CMD_WRITE_PIO 0x30
+#define ATA_CMD_CACHE_FLUSH 0xE7
+#define ATA_CMD_IDENTIFY 0xEC
+
+// Device control: disable drive interrupts (while probing), software
+// reset (both drives)
+#define ATA_CTRL_NIEN 0x02
+#define ATA_CTRL_SRST 0x04
+
+// One drive on the primary bus
+typedef struct {
+    uint8_t present;
+    uint8_t slave;
+    uint32_t sectors;       // LBA28 addressable sectors
+    char model[41];
+    block_device_t block;
+} ata_drive_t;
+
+// Probe the primary master and slave with IDENTIFY and register every
+// ATA disk found with the block layer ("hda", "hdb"), with interrupt-
+// driven queued I/O on IRQ14. Returns the number of drives found.
+uint32_t ata_init(void);
+
+// Polled PIO transfers of 1..256 sectors (LBA28), used while interrupts
+// are off. Return 1 on success.
+int ata_read_sectors(ata_drive_t* drive, uint32_t lba, uint32_t count, void* buf);
+int ata_write_sectors(ata_drive_t* drive, uint32_t lba, uint32_t count, const void* buf);
+int ata_flush(ata_drive_t* drive);
+
+#endif
@@ -0,0 +1,371 @@
+#include "block.h"
+#include "../cpu/cpu.h"
+#include "../cpu/smp.h"
+#include "../cpu/spinlock.h"
+#include "../interrupt/defer.h"
+#include "../kernel/prof.h"
+#include "../kernel/thread.h"
+#include "../kernel/trace.h"
+#include "../libc/string.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Requests per batch when block_read/block_write go through the queue
+#define BLOCK_SYNC_BATCH 8
+
+static block_device_t* devices[BLOCK_MAX_DEVICES];
+static uint32_t num_devices = 0;
+
+// Protects every device queue; taken with interrupts off
+static spinlock_t queue_lock = SPINLOCK_INIT;
+
+int block_register(block_device_t* dev) {
+    if (num_devices >= BLOCK_MAX_DEVICES) {
+        return 0;
+    }
+    devices[num_devices++] = dev;
+    return 1;
+}
+
+uint32_t block_device_count(void) {
+    return num_devices;
+}
+
+block_device_t* block_get(uint32_t index) {
+    return index < num_devices ? devices[index] : 0;
+}
+
+// The request must lie entirely on the device (and not wrap around)
+static int block_in_range(const block_device_t* dev, uint32_t lba, uint32_t count) {
+    return lba <= dev->sector_count && count <= dev->sector_count - lba;
+}
+
+// Whether transfers can go through the interrupt-driven queue
+static int block_async_usable(const block_device_t* dev) {
+    // The disk interrupt goes to the BSP, so other CPUs may queue (and
+    // poll for completion) whenever the BSP has interrupts on
+    return dev->start && (smp_cpu_index() != 0 || (cpu_get_flags() & EFLAGS_IF));
+}
+
+// Split a transfer into max_transfer requests and keep up to
+// BLOCK_SYNC_BATCH of them queued at once so the device never idles
+// between chunks
+static int block_transfer_async(block_device_t* dev, uint32_t lba, uint32_t count, uint8_t* buf, uint8_t write) {
+    block_request_t reqs[BLOCK_SYNC_BATCH];
+    int ok = 1;
+    
+    while (count > 0 && ok) {
+        uint32_t batch = 0;
+        while (count > 0 && batch < BLOCK_SYNC_BATCH) {
+            uint32_t n = count < dev->max_transfer ? count : dev->max_transfer;
+            block_request_t* req = &reqs[batch++];
+            req->lba = lba;
+            req->count = n;
+            req->buf = buf;
+            req->write = write;
+            req->done = NULL;
+            req->ctx = NULL;
+            block_submit(dev, req);
+            lba += n;
+            count -= n;
+            buf += n * BLOCK_SECTOR_SIZE;
+        }
+        for (uint32_t i = 0; i < batch; i++) {
+            ok &= block_wait(&reqs[i]);
+        }
+    }
+    return ok;
+}
+
+// Polled transfer, split by max_transfer. Only the BSP with interrupts
+// off gets here for a queued device, so a command already in flight on
+// it cannot complete; the driver refuses instead of colliding with it,
+// and holding the queue lock keeps other CPUs from starting one meanwhile.
+static int block_transfer_polled(block_device_t* dev, uint32_t lba, uint32_t count, uint8_t* buf, uint8_t write) {
+    uint32_t flags = 0;
+    int ok = 1;
+    
+    if (dev->start) {
+        flags = cpu_irq_save();
+        spin_lock(&queue_lock);
+        ok = !dev->queue.active;
+    }
+    while (count > 0 && ok) {
+        uint32_t n = count < dev->max_transfer ? count : dev->max_transfer;
+        ok = write ? dev->write(dev, lba, n, buf) : dev->read(dev, lba, n, buf);
+        lba += n;
+        count -= n;
+        buf += n * BLOCK_SECTOR_SIZE;
+    }
+    if (dev->start) {
+        spin_unlock(&queue_lock);
+        cpu_irq_restore(flags);
+    }
+    return ok;
+}
+
+int block_read(block_device_t* dev, uint32_t lba, uint32_t count, void* buf) {
+    PROF_SCOPE("block_read");
+    TRACE_SCOPE(TRACE_EV_BLOCK_READ, lba);
+    if (!dev || !block_in_range(dev, lba, count)) {
+        return 0;
+    }
+    if (block_async_usable(dev)) {
+        return block_transfer_async(dev, lba, count, (uint8_t*)buf, 0);
+    }
+    return block_transfer_polled(dev, lba, count, (uint8_t*)buf, 0);
+}
+
+int block_write(block_device_t* dev, uint32_t lba, uint32_t count, const void* buf) {
+    PROF_SCOPE("block_write");
+    TRACE_SCOPE(TRACE_EV_BLOCK_WRITE, lba);
+    if (!dev || !dev->write || !block_in_range(dev, lba, count)) {
+        return 0;
+    }
+    if (block_async_usable(dev)) {
+        return block_transfer_async(dev, lba, count, (uint8_t*)buf, 1);
+    }
+    return block_transfer_polled(dev, lba, count, (uint8_t*)buf, 1);
+}
+
+// Wait for the device queue to drain so a polled command cannot collide
+// with one in flight
+static void block_wait_idle(block_device_t* dev) {
+    while (dev->queue.active || dev->queue.head) {
+        if (smp_cpu_index() == 0) {
+            thread_yield();
+        }
+        cpu_relax();
+    }
+}
+
+int block_flush(block_device_t* dev) {
+    if (!dev) {
+        return 0;
+    }
+    if (dev->start) {
+        block_wait_idle(dev);
+    }
+    return dev->flush ? dev->flush(dev) : 1;
+}
+
+int block_read_bytes(block_device_t* dev, uint32_t lba, void* buf, uint32_t size) {
+    uint32_t whole = size / BLOCK_SECTOR_SIZE;
+    uint32_t tail = size % BLOCK_SECTOR_SIZE;
+    uint8_t* dst = (uint8_t*)buf;
+    uint8_t bounce[BLOCK_SECTOR_SIZE] __attribute__((aligned(16)));   // Partial last sector
+    
+    if (whole && !block_read(dev, lba, whole, dst)) {
+        return 0;
+    }
+    if (tail) {
+        if (!block_read(dev, lba + whole, 1, bounce)) {
+            return 0;
+        }
+        memcpy(dst + whole * BLOCK_SECTOR_SIZE, bounce, tail);
+    }
+    return 1;
+}
+
+int block_write_bytes(block_device_t* dev, uint32_t lba, const void* buf, uint32_t size) {
+    uint32_t whole = size / BLOCK_SECTOR_SIZE;
+    uint32_t tail = size % BLOCK_SECTOR_SIZE;
+    const uint8_t* src = (const uint8_t*)buf;
+    uint8_t bounce[BLOCK_SECTOR_SIZE] __attribute__((aligned(16)));   // Partial last sector
+    
+    if (whole && !block_write(dev, lba, whole, src)) {
+        return 0;
+    }
+    if (tail) {
+        memcpy(bounce, src + whole * BLOCK_SECTOR_SIZE, tail);
+        memset(bounce + tail, 0, BLOCK_SECTOR_SIZE - tail);
+        if (!block_write(dev, lba + whole, 1, bounce)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Start the next request in C-LOOK order: the first at or past where the
+// last command ended, else wrap to the lowest LBA. Called locked. Returns
+// the requests the device failed to start, linked by 'next', for the
+// caller to complete with block_fail once the lock is dropped.
+static block_request_t* block_dispatch(block_device_t* dev) {
+    block_queue_t* q = &dev->queue;
+    block_request_t* failed = NULL;
+    
+    while (!q->active && q->head) {
+        block_request_t** link = &q->head;
+        while (*link && (*link)->lba < q->next_lba) {
+            link = &(*link)->next;
+        }
+        if (!*link) {
+            link = &q->head;
+        }
+        block_request_t* req = *link;
+        
+        *link = req->next;
+        req->next = NULL;
+        q->active = req;
+        TRACE_INSTANT(TRACE_EV_BLOCK_DISPATCH, req->lba);
+        int started = dev->start(dev, req);
+        if (started == BLOCK_START_BUSY) {
+            // E.g. the other drive on the channel; requeue in place and
+            // wait for block_kick
+            q->active = NULL;
+            req->next = *link;
+            *link = req;
+            break;
+        }
+        if (started == BLOCK_START_FAILED) {
+            // Nothing is in flight, so move on to the next request
+            q->active = NULL;
+            req->next = failed;
+            failed = req;
+        }
+    }
+    return failed;
+}
+
+// Complete req and its merged followers. Not called locked.
+static void block_notify(block_request_t* req, int ok) {
+    while (req) {
+        block_request_t* next = req->merged;
+        thread_t* waiter = req->waiter;
+        TRACE_ASYNC_END(TRACE_EV_BLOCK_REQUEST, req->lba);
+        if (req->done) {
+            req->done(req, ok);
+        }
+        
+        // A polling waiter may reuse req as soon as it sees the status
+        req->status = ok ? BLOCK_REQ_DONE : BLOCK_REQ_ERROR;
+        if (waiter) {
+            thread_wake(waiter);
+        }
+        req = next;
+    }
+}
+
+static void block_fail_deferred(void* arg);
+
+// Fail the requests block_dispatch could not start. thread_wake is only
+// safe on the BSP, so another CPU hands the list over to it.
+static void block_fail(block_request_t* failed) {
+    if (failed && smp_cpu_index() != 0 && defer_queue(block_fail_deferred, failed)) {
+        return;
+    }
+    while (failed) {
+        block_request_t* next = failed->next;
+        block_notify(failed, 0);
+        failed = next;
+    }
+}
+
+static void block_fail_deferred(void* arg) {
+    block_fail((block_request_t*)arg);
+}
+
+// Sorted insert, or append to a queued request that this one continues
+static void block_enqueue(block_device_t* dev, block_request_t* req) {
+    block_queue_t* q = &dev->queue;
+    block_request_t** link = &q->head;
+    
+    for (block_request_t* cur = q->head; cur; cur = cur->next) {
+        if (cur->write == req->write && cur->lba + cur->span == req->lba
+            && cur->span + req->count <= dev->max_transfer) {
+            block_request_t* tail = cur;
+            while (tail->merged) {
+                tail = tail->merged;
+            }
+            tail->merged = req;
+            cur->span += req->count;
+            q->merged++;
+            return;
+        }
+    }
+    
+    while (*link && (*link)->lba <= req->lba) {
+        link = &(*link)->next;
+    }
+    req->next = *link;
+    *link = req;
+}
+
+int block_submit(block_device_t* dev, block_request_t* req) {
+    if (!dev || req->count == 0 || req->count > dev->max_transfer
+        || !block_in_range(dev, req->lba, req->count) || (req->write && !dev->write)) {
+        return 0;
+    }
+    req->status = BLOCK_REQ_PENDING;
+    req->waiter = NULL;
+    req->next = NULL;
+    req->merged = NULL;
+    req->span = req->count;
+    TRACE_ASYNC_BEGIN(TRACE_EV_BLOCK_REQUEST, req->lba);
+    
+    // Synchronous device: complete right away
+    if (!dev->start) {
+        int ok = req->write ? dev->write(dev, req->lba, req->count, req->buf)
+                            : dev->read(dev, req->lba, req->count, req->buf);
+        if (req->done) {
+            req->done(req, ok);
+        }
+        TRACE_ASYNC_END(TRACE_EV_BLOCK_REQUEST, req->lba);
+        req->status = ok ? BLOCK_REQ_DONE : BLOCK_REQ_ERROR;
+        return 1;
+    }
+    
+    uint32_t flags = cpu_irq_save();
+    spin_lock(&queue_lock);
+    dev->queue.submitted++;
+    block_enqueue(dev, req);
+    block_request_t* failed = block_dispatch(dev);
+    spin_unlock(&queue_lock);
+    cpu_irq_restore(flags);
+    block_fail(failed);
+    return 1;
+}
+
+int block_wait(block_request_t* req) {
+    uint32_t flags = cpu_irq_save();
+    while (req->status == BLOCK_REQ_PENDING) {
+        if (smp_cpu_index() != 0 || !(flags & EFLAGS_IF)) {
+            // Not the CPU taking the disk interrupt: poll
+            cpu_irq_restore(flags);
+            cpu_relax();
+            flags = cpu_irq_save();
+        } else if (thread_current()) {
+            req->waiter = thread_current();
+            thread_block();
+        } else {
+            __asm__ volatile("sti; hlt; cli" ::: "memory");
+        }
+    }
+    cpu_irq_restore(flags);
+    return req->status == BLOCK_REQ_DONE;
+}
+
+void block_complete(block_device_t* dev, int ok) {
+    block_queue_t* q = &dev->queue;
+    
+    spin_lock(&queue_lock);
+    block_request_t* req = q->active;
+    q->active = NULL;
+    if (req) {
+        q->next_lba = req->lba + req->span;
+    }
+    
+    // Keep the device busy before running any callbacks
+    block_request_t* failed = block_dispatch(dev);
+    spin_unlock(&queue_lock);
+    
+    block_notify(req, ok);
+    block_fail(failed);
+}
+
+void block_kick(block_device_t* dev) {
+    spin_lock(&queue_lock);
+    block_request_t* failed = block_dispatch(dev);
+    spin_unlock(&queue_lock);
+    block_fail(failed);
+}
@@ -0,0 +1,111 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <stdint.h>
+
+#define BLOCK_SECTOR_SIZE 512
+#define BLOCK_MAX_DEVICES 4
+
+struct block_device;
+struct thread;
+
+// Asynchronous request. The caller owns it until it completes.
+typedef enum {
+    BLOCK_REQ_PENDING,
+    BLOCK_REQ_DONE,
+    BLOCK_REQ_ERROR
+} block_req_status_t;
+
+typedef struct block_request {
+    uint32_t lba;
+    uint32_t count;             // At most the device's max_transfer
+    void* buf;
+    uint8_t write;
+    volatile uint8_t status;    // block_req_status_t
+    
+    // Called from the completion interrupt, before status is set; keep it
+    // short (or defer)
+    void (*done)(struct block_request* req, int ok);
+    void* ctx;
+    
+    // Owned by the block layer
+    struct thread* waiter;              // Thread sleeping in block_wait
+    struct block_request* next;         // Queue link
+    struct block_request* merged;       // Followers served by the same command
+    uint32_t span;                      // Sectors of this request plus followers
+} block_request_t;
+
+// Per-device queue, kept sorted by LBA and served in one direction
+// (C-LOOK) so the head sweeps across the disk instead of seeking back and
+// forth. Requests that continue a queued one are merged into a single
+// device command.
+typedef struct {
+    block_request_t* head;      // Waiting, sorted by LBA
+    block_request_t* active;    // On the device
+    uint32_t next_lba;          // Where the last command ended
+    uint32_t submitted;
+    uint32_t merged;
+} block_queue_t;
+
+// A sector-addressed storage device. Drivers fill in the geometry and
+// callbacks and register the device; everything above uses block_read()
+// and block_write(), which bounds-check and split large requests.
+//
+// Drivers that can complete by interrupt also provide start(): it issues
+// one command covering req and its merged followers (req->span sectors
+// from req->lba) and returns a BLOCK_START_* code. The driver reports
+// the end with block_complete() from its interrupt handler. read/write
+// remain the polled path used while interrupts are off.
+#define BLOCK_START_BUSY 0      // Hardware busy: stays queued for block_kick
+#define BLOCK_START_OK 1        // Issued; block_complete will follow
+#define BLOCK_START_FAILED -1   // Device error: the request fails now
+
+typedef struct block_device {
+    const char* name;
+    uint32_t sector_count;
+    uint32_t max_transfer;      // Sectors per driver call
+    void* driver_data;
+    int (*read)(struct block_device* dev, uint32_t lba, uint32_t count, void* buf);
+    int (*write)(struct block_device* dev, uint32_t lba, uint32_t count, const void* buf);
+    int (*flush)(struct block_device* dev);
+    int (*start)(struct block_device* dev, block_request_t* req);
+    block_queue_t queue;
+} block_device_t;
+
+// Register a device; returns 0 if the table is full
+int block_register(block_device_t* dev);
+
+// Registered devices in probe order (0 if index is out of range)
+uint32_t block_device_count(void);
+block_device_t* block_get(uint32_t index);
+
+// Sector I/O. Return 1 on success, 0 on a device error or out-of-range
+// request.
+int block_read(block_device_t* dev, uint32_t lba, uint32_t count, void* buf);
+int block_write(block_device_t* dev, uint32_t lba, uint32_t count, const void* buf);
+int block_flush(block_device_t* dev);
+
+// Byte-length I/O starting at a sector boundary. Whole sectors transfer
+// straight to/from buf; only a partial last sector goes through a bounce
+// buffer (and is zero padded on write).
+int block_read_bytes(block_device_t* dev, uint32_t lba, void* buf, uint32_t size);
+int block_write_bytes(block_device_t* dev, uint32_t lba, const void* buf, uint32_t size);
+
+// Queue a request (read/write, lba, count, buf, done and ctx filled in).
+// Devices without start() complete it synchronously before returning.
+// Returns 0 if the request is invalid; it is then not queued.
+int block_submit(block_device_t* dev, block_request_t* req);
+
+// Wait for a submitted request (the calling thread blocks; outside
+// thread context the CPU halts). Returns 1 if it succeeded.
+int block_wait(block_request_t* req);
+
+// Driver side: the active command finished. Starts the next queued
+// request, then completes the finished ones. Interrupt context.
+void block_complete(block_device_t* dev, int ok);
+
+// Driver side: retry dispatch after start() returned BLOCK_START_BUSY.
+// Interrupt context.
+void block_kick(block_device_t* dev);
+
+#endif
@@ -0,0 +1,100 @@
+#include "clock.h"
+#include "ports.h"
+#include "timer.h"
+#include "../cpu/cpu.h"
+#include "../cpu/lapic.h"
+#include "../math/math.h"
+#include <stdint.h>
+
+static uint64_t tsc_base = 0;
+static uint32_t tsc_khz = 0;
+static uint32_t lapic_hz = 0;
+
+// 2^24-scaled factors: ns = cycles * ns_mult >> 24, cycles = ns * tsc_mult >> 24
+static uint32_t ns_mult = 0;
+static uint32_t tsc_mult = 0;
+
+// x * m >> 24 for a 64-bit x, without a 64x64 multiply overflowing
+static inline uint64_t mul_shift24(uint64_t x, uint32_t m) {
+    uint64_t lo = (uint64_t)(uint32_t)x * m;
+    uint64_t hi = (uint64_t)(uint32_t)(x >> 32) * m;
+    return (lo >> 24) + (hi << 8);
+}
+
+// Run one PIT channel 2 countdown of 'count' input clocks, measuring the
+// TSC and the LAPIC timer across it
+static void pit_measure(uint16_t count, uint64_t* tsc_elapsed, uint32_t* lapic_elapsed) {
+    uint8_t gate = port_byte_in(PIT_GATE_PORT);
+    port_byte_out(PIT_GATE_PORT, (gate & ~(PIT_SPEAKER_ENABLE | PIT_GATE_ENABLE)));
+    
+    // Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count)
+    port_byte_out(PIT_COMMAND, 0xB0);
+    port_byte_out(PIT_CHANNEL2, (uint8_t)count);
+    port_byte_out(PIT_CHANNEL2, (uint8_t)(count >> 8));
+    
+    if (lapic_available()) {
+        lapic_timer_start(0, LAPIC_TIMER_ONESHOT | LAPIC_LVT_MASKED, 0xFFFFFFFF);
+    }
+    
+    // Raising the gate starts the countdown; OUT2 goes high at zero
+    port_byte_out(PIT_GATE_PORT, (gate & ~PIT_SPEAKER_ENABLE) | PIT_GATE_ENABLE);
+    uint32_t lapic_start = lapic_available() ? lapic_timer_current() : 0;
+    uint64_t start = rdtsc();
+    while (!(port_byte_in(PIT_GATE_PORT) & PIT_OUT2)) {
+    }
+    *tsc_elapsed = rdtsc() - start;
+    *lapic_elapsed = lapic_available() ? lapic_start - lapic_timer_current() : 0;
+    
+    if (lapic_available()) {
+        lapic_timer_stop();
+    }
+    port_byte_out(PIT_GATE_PORT, gate);
+}
+
+void clock_init(void) {
+    if (!cpu_has_edx(CPUID_EDX_TSC)) {
+        return;
+    }
+    
+    uint16_t count = PIT_FREQUENCY / CLOCK_CALIBRATE_HZ;
+    uint64_t best_tsc = ~0ULL;
+    uint32_t best_lapic = 0;
+    for (int round = 0; round < CLOCK_CALIBRATE_ROUNDS; round++) {
+        uint64_t tsc;
+        uint32_t lapic;
+        pit_measure(count, &tsc, &lapic);
+        if (tsc < best_tsc) {
+            best_tsc = tsc;
+            best_lapic = lapic;
+        }
+    }
+    
+    tsc_khz = (uint32_t)k_udiv64(best_tsc * CLOCK_CALIBRATE_HZ, 1000);
+    lapic_hz = best_lapic * CLOCK_CALIBRATE_HZ;
+    if (tsc_khz == 0) {
+        return;
+    }
+    ns_mult = (uint32_t)k_udiv64(1000000ULL << 24, tsc_khz);
+    tsc_mult = (uint32_t)k_udiv64((uint64_t)tsc_khz << 24, 1000000);
+    tsc_base = rdtsc();
+}
+
+uint64_t clock_ns(void) {
+    return mul_shift24(rdtsc() - tsc_base, ns_mult);
+}
+
+uint64_t clock_tsc_to_ns(uint64_t cycles) {
+    return mul_shift24(cycles, ns_mult);
+}
+
+uint64_t clock_ns_to_tsc(uint64_t ns) {
+    return mul_shift24(ns, tsc_mult);
+}
+
+uint32_t clock_tsc_khz(void) {
+    return tsc_khz;
+}
+
+uint32_t clock_lapic_hz(void) {
+    return lapic_hz;
+}
@@ -0,0 +1,33 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+// PIT channel 2 (speaker channel, gated via port 0x61) is used as the
+// reference for calibration because it can be polled without interrupts
+#define PIT_CHANNEL2 0x42
+#define PIT_GATE_PORT 0x61
+#define PIT_GATE_ENABLE 0x01
+#define PIT_SPEAKER_ENABLE 0x02
+#define PIT_OUT2 0x20
+
+// Calibration window: 10ms, repeated and the shortest result kept
+#define CLOCK_CALIBRATE_HZ 100
+#define CLOCK_CALIBRATE_ROUNDS 3
+
+// Calibrate the TSC (and the local APIC timer, if lapic_init has run)
+// against the PIT. Must run with interrupts disabled.
+void clock_init(void);
+
+// Nanoseconds since clock_init, from the TSC
+uint64_t clock_ns(void);
+
+// Conversions between TSC cycles and nanoseconds
+uint64_t clock_tsc_to_ns(uint64_t cycles);
+uint64_t clock_ns_to_tsc(uint64_t ns);
+
+// Calibrated frequencies (0 if not measured)
+uint32_t clock_tsc_khz(void);
+uint32_t clock_lapic_hz(void);  // After the LAPIC timer divider
+
+#endif
@@ -0,0 +1,23 @@
+#include "console.h"
+#include "screen.h"
+#include "serial.h"
+#include <stdint.h>
+
+static uint32_t outputs = CONSOLE_VGA;
+
+void console_set_outputs(uint32_t mask) {
+    outputs = mask;
+}
+
+uint32_t console_get_outputs(void) {
+    return outputs;
+}
+
+void console_write(const char* str) {
+    if (outputs & CONSOLE_SERIAL) {
+        serial_write(str);
+    }
+    if (outputs & CONSOLE_VGA) {
+        screen_write(str);
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+
+// kprint output goes to every enabled sink
+#define CONSOLE_VGA     0x01    // Text mode screen
+#define CONSOLE_SERIAL  0x02    // COM1, once serial_init has found it
+
+void console_set_outputs(uint32_t outputs);
+uint32_t console_get_outputs(void);
+
+// Write to the enabled sinks (what kprint does)
+void console_write(const char* str);
+
+#endif
@@ -0,0 +1,17 @@
+#include "debugcon.h"
+#include "ports.h"
+#include <stdint.h>
+
+int debugcon_present(void) {
+    return port_byte_in(DEBUGCON_PORT) == DEBUGCON_PORT;
+}
+
+void debugcon_putc(char c) {
+    port_byte_out(DEBUGCON_PORT, (unsigned char)c);
+}
+
+void debugcon_write(const char* str) {
+    while (*str) {
+        port_byte_out(DEBUGCON_PORT, (unsigned char)*str++);
+    }
+}
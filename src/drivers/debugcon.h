@@ -0,0 +1,17 @@
+#ifndef DEBUGCON_H
+#define DEBUGCON_H
+
+#include <stdint.h>
+
+// Emulator debug console: bytes written to port 0xE9 go to the host
+// (QEMU -debugcon file:out.log, Bochs port_e9_hack). Writes are harmless
+// on real hardware, where nothing listens.
+#define DEBUGCON_PORT 0xE9
+
+// Non-zero if an emulator debug console answers (it reads back 0xE9)
+int debugcon_present(void);
+
+void debugcon_putc(char c);
+void debugcon_write(const char* str);
+
+#endif
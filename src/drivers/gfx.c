@@ -0,0 +1,166 @@
+#include "gfx.h"
+#include "vga.h"
+#include "../memory/memory.h"
+#include "../libc/string.h"
+#include <stdint.h>
+
+#define GFX_PALETTE_SIZE (GFX_YELLOW + 1)
+
+static uint8_t* back = 0;
+
+// Rectangle drawn since the last flush, [x0, x1) x [y0, y1); empty if x0 >= x1
+static int dirty_x0 = 0, dirty_y0 = 0, dirty_x1 = 0, dirty_y1 = 0;
+
+static inline int clamp(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void mark_dirty(int x0, int y0, int x1, int y1) {
+    if (dirty_x0 >= dirty_x1) {
+        dirty_x0 = x0;
+        dirty_y0 = y0;
+        dirty_x1 = x1;
+        dirty_y1 = y1;
+        return;
+    }
+    dirty_x0 = x0 < dirty_x0 ? x0 : dirty_x0;
+    dirty_y0 = y0 < dirty_y0 ? y0 : dirty_y0;
+    dirty_x1 = x1 > dirty_x1 ? x1 : dirty_x1;
+    dirty_y1 = y1 > dirty_y1 ? y1 : dirty_y1;
+}
+
+static void load_palette(void) {
+    static const uint8_t colours[][3] = {
+        { 12, 52, 12 },         // GFX_GREEN
+        { 58, 12, 12 },         // GFX_RED
+        { 6, 8, 22 },           // GFX_BLUE
+        { 62, 56, 10 },         // GFX_YELLOW
+    };
+    uint8_t rgb[GFX_PALETTE_SIZE * 3];
+    
+    for (uint32_t i = 0; i < GFX_GRAY_LEVELS; i++) {
+        rgb[i * 3] = rgb[i * 3 + 1] = rgb[i * 3 + 2] = (uint8_t)i;
+    }
+    memcpy(rgb + GFX_GRAY_LEVELS * 3, colours, sizeof(colours));
+    vga_set_palette(0, GFX_PALETTE_SIZE, rgb);
+}
+
+int gfx_begin(void) {
+    if (!back) {
+        back = (uint8_t*)kmalloc(GFX_WIDTH * GFX_HEIGHT);
+        if (!back) {
+            return 0;
+        }
+    }
+    if (!vga_enter_graphics()) {
+        return 0;
+    }
+    load_palette();
+    
+    // The screen is already black; start with nothing to flush
+    memset(back, GFX_BLACK, GFX_WIDTH * GFX_HEIGHT);
+    dirty_x0 = dirty_x1 = 0;
+    return 1;
+}
+
+void gfx_end(void) {
+    vga_leave_graphics();
+}
+
+void gfx_clear(uint8_t color) {
+    memset(back, color, GFX_WIDTH * GFX_HEIGHT);
+    mark_dirty(0, 0, GFX_WIDTH, GFX_HEIGHT);
+}
+
+void gfx_fill_rect(int x, int y, int w, int h, uint8_t color) {
+    int x0 = clamp(x, 0, GFX_WIDTH), x1 = clamp(x + w, 0, GFX_WIDTH);
+    int y0 = clamp(y, 0, GFX_HEIGHT), y1 = clamp(y + h, 0, GFX_HEIGHT);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    for (int row = y0; row < y1; row++) {
+        memset(back + row * GFX_WIDTH + x0, color, x1 - x0);
+    }
+    mark_dirty(x0, y0, x1, y1);
+}
+
+void gfx_frame(int x, int y, int w, int h, uint8_t color) {
+    gfx_fill_rect(x, y, w, 1, color);
+    gfx_fill_rect(x, y + h - 1, w, 1, color);
+    gfx_fill_rect(x, y + 1, 1, h - 2, color);
+    gfx_fill_rect(x + w - 1, y + 1, 1, h - 2, color);
+}
+
+void gfx_blit_gray(int x, int y, const uint8_t* pixels, uint32_t w, uint32_t h, uint32_t scale) {
+    uint8_t row[GFX_WIDTH];
+    int x0 = clamp(x, 0, GFX_WIDTH), x1 = clamp(x + (int)(w * scale), 0, GFX_WIDTH);
+    int y0 = clamp(y, 0, GFX_HEIGHT), y1 = clamp(y + (int)(h * scale), 0, GFX_HEIGHT);
+    if (scale == 0 || x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    
+    const uint8_t* expanded = 0;
+    for (int dy = y0; dy < y1; dy++) {
+        const uint8_t* src = pixels + (uint32_t)(dy - y) / scale * w;
+        
+        // Expand each source row once; its other scale - 1 rows are copies
+        if (src != expanded) {
+            uint32_t sx = (uint32_t)(x0 - x) / scale;
+            uint32_t phase = (uint32_t)(x0 - x) % scale;
+            for (int i = 0; i < x1 - x0; i++) {
+                row[i] = GFX_GRAY(src[sx]);
+                if (++phase == scale) {
+                    phase = 0;
+                    sx++;
+                }
+            }
+            expanded = src;
+        }
+        memcpy(back + dy * GFX_WIDTH + x0, row, x1 - x0);
+    }
+    mark_dirty(x0, y0, x1, y1);
+}
+
+int gfx_text(int x, int y, const char* str, uint8_t color) {
+    const uint8_t* font = vga_font();
+    int height = (int)vga_font_height();
+    int start = x;
+    
+    for (; *str; str++, x += GFX_CHAR_WIDTH) {
+        const uint8_t* glyph = font + (uint8_t)*str * VGA_FONT_STRIDE;
+        for (int gy = 0; gy < height; gy++) {
+            int py = y + gy;
+            if (py < 0 || py >= GFX_HEIGHT || !glyph[gy]) {
+                continue;
+            }
+            for (int gx = 0; gx < GFX_CHAR_WIDTH; gx++) {
+                int px = x + gx;
+                if ((glyph[gy] & (0x80 >> gx)) && px >= 0 && px < GFX_WIDTH) {
+                    back[py * GFX_WIDTH + px] = color;
+                }
+            }
+        }
+    }
+    mark_dirty(clamp(start, 0, GFX_WIDTH), clamp(y, 0, GFX_HEIGHT),
+               clamp(x, 0, GFX_WIDTH), clamp(y + height, 0, GFX_HEIGHT));
+    return x;
+}
+
+void gfx_flush(void) {
+    uint8_t* screen = (uint8_t*)VGA_GFX_ADDRESS;
+    if (dirty_x0 >= dirty_x1 || dirty_y0 >= dirty_y1) {
+        return;
+    }
+    
+    // Full-width spans are contiguous: one copy for the whole band
+    if (dirty_x0 == 0 && dirty_x1 == GFX_WIDTH) {
+        memcpy(screen + dirty_y0 * GFX_WIDTH, back + dirty_y0 * GFX_WIDTH,
+               (dirty_y1 - dirty_y0) * GFX_WIDTH);
+    } else {
+        for (int row = dirty_y0; row < dirty_y1; row++) {
+            memcpy(screen + row * GFX_WIDTH + dirty_x0, back + row * GFX_WIDTH + dirty_x0,
+                   dirty_x1 - dirty_x0);
+        }
+    }
+    dirty_x0 = dirty_x1 = 0;
+}
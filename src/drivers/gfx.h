@@ -0,0 +1,47 @@
+#ifndef GFX_H
+#define GFX_H
+
+#include "vga.h"
+#include <stdint.h>
+
+// Drawing goes to a back buffer in RAM; gfx_flush copies the rectangle
+// touched since the last flush to video memory in one pass per row
+#define GFX_WIDTH VGA_GFX_WIDTH
+#define GFX_HEIGHT VGA_GFX_HEIGHT
+
+// Palette loaded by gfx_begin: a 64-level gray ramp, then a few colours
+#define GFX_GRAY_LEVELS 64
+#define GFX_GRAY(v) ((uint8_t)((v) >> 2))  // 8-bit intensity to its gray index
+#define GFX_BLACK 0
+#define GFX_WHITE 63
+#define GFX_GREEN 64
+#define GFX_RED 65
+#define GFX_BLUE 66
+#define GFX_YELLOW 67
+
+// Text uses the VGA font: 8 pixels wide, vga_font_height() tall
+#define GFX_CHAR_WIDTH 8
+
+// Enter mode 13h with the palette above and a cleared back buffer.
+// Returns 0 (still in text mode) on allocation failure.
+int gfx_begin(void);
+
+// Back to the text console
+void gfx_end(void);
+
+// Drawing is clipped to the screen
+void gfx_clear(uint8_t color);
+void gfx_fill_rect(int x, int y, int w, int h, uint8_t color);
+void gfx_frame(int x, int y, int w, int h, uint8_t color);     // 1-pixel outline
+
+// Draw a w x h 8-bit grayscale image (e.g. an MNIST digit) with each
+// pixel scaled up to a scale x scale block
+void gfx_blit_gray(int x, int y, const uint8_t* pixels, uint32_t w, uint32_t h, uint32_t scale);
+
+// Draw text with a transparent background; returns the x after it
+int gfx_text(int x, int y, const char* str, uint8_t color);
+
+// Copy what changed to the screen
+void gfx_flush(void);
+
+#endif
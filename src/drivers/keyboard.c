@@ -3,6 +3,7 @@
 #include "screen.h"
 #include "../interrupt/isr.h"
 #include "../interrupt/idt.h"
+#include "../interrupt/defer.h"
 #include <stdint.h>
 
 // Keyboard data and control ports
@@ -52,6 +53,14 @@ static const char scancode_to_ascii_shift[] = {
 #define SC_ALT_RELEASE    0xB8
 #define SC_MAX            0x39
 
+// Keys that trigger deferred work instead of input
+static struct {
+    uint8_t scancode;
+    defer_fn_t fn;
+    void* arg;
+} hotkeys[KEYBOARD_MAX_HOTKEYS];
+static uint32_t num_hotkeys = 0;
+
 // Add character to keyboard buffer
 static void buffer_put(char c) {
     int next_write = (buffer_write + 1) % BUFFER_SIZE;
@@ -71,7 +80,18 @@ static int buffer_get(char* c) {
     return 1;  // Character available
 }
 
-// Keyboard interrupt handler
+// Echo typed text from deferred context; arg is the character, or 0 for ^C
+static void keyboard_echo(void* arg) {
+    char c = (char)(uintptr_t)arg;
+    if (c == 0) {
+        kprint("^C");
+        return;
+    }
+    char str[2] = {c, '\0'};
+    kprint(str);
+}
+
+// Keyboard interrupt handler: decode and buffer only, echo is deferred
 static void keyboard_callback(registers_t* regs) {
     (void)regs;  // Unused parameter
     
@@ -96,6 +116,13 @@ static void keyboard_callback(registers_t* regs) {
         return;
     }
     
+    for (uint32_t i = 0; i < num_hotkeys; i++) {
+        if (hotkeys[i].scancode == scancode) {
+            defer_queue(hotkeys[i].fn, hotkeys[i].arg);
+            return;
+        }
+    }
+    
     // Handle key presses
     switch (scancode) {
         case SC_LSHIFT_PRESS:
@@ -139,16 +166,15 @@ static void keyboard_callback(registers_t* regs) {
                 if (ctrl_pressed) {
                     // Ctrl+C, Ctrl+D, etc. could be handled here
                     if (ascii == 'c' || ascii == 'C') {
-                        kprint("^C");
+                        defer_queue(keyboard_echo, (void*)0);
                         return;
                     }
                 }
                 
-                // If valid ASCII character, print it and buffer it
+                // If valid ASCII character, buffer it and echo it later
                 if (ascii != 0) {
-                    char str[2] = {ascii, '\0'};
-                    kprint(str);
                     buffer_put(ascii);
+                    defer_queue(keyboard_echo, (void*)(uintptr_t)(uint8_t)ascii);
                 }
             }
             break;
@@ -166,12 +192,31 @@ void keyboard_init(void) {
     kprint("Keyboard initialized. Start typing!\n");
 }
 
+int keyboard_set_hotkey(uint8_t scancode, defer_fn_t fn, void* arg) {
+    if (num_hotkeys == KEYBOARD_MAX_HOTKEYS) {
+        return 0;
+    }
+    hotkeys[num_hotkeys].scancode = scancode;
+    hotkeys[num_hotkeys].fn = fn;
+    hotkeys[num_hotkeys].arg = arg;
+    num_hotkeys++;
+    return 1;
+}
+
 // Get a character from keyboard buffer (blocking)
 char keyboard_getchar(void) {
     char c;
     while (!buffer_get(&c)) {
-        // Wait for character - halt CPU for efficiency
-        __asm__ volatile("hlt");
+        // Wait for character - run deferred work, then halt until the
+        // next interrupt (checked with interrupts off so a key cannot
+        // slip in before the hlt)
+        defer_run();
+        __asm__ volatile("cli");
+        if (keyboard_available() || defer_pending()) {
+            __asm__ volatile("sti");
+        } else {
+            __asm__ volatile("sti; hlt" ::: "memory");
+        }
     }
     return c;
 }
@@ -1,8 +1,16 @@
 #ifndef KEYBOARD_H
 #define KEYBOARD_H
 
+#include "../interrupt/defer.h"
 #include <stdint.h>
 
+// Scancodes usable as hotkeys
+#define SC_F10 0x44
+#define SC_F11 0x57
+#define SC_F12 0x58
+
+#define KEYBOARD_MAX_HOTKEYS 4
+
 // Keyboard initialization
 void keyboard_init(void);
 
@@ -12,4 +20,8 @@ char keyboard_getchar(void);
 // Check if a key is available
 int keyboard_available(void);
 
+// Run fn(arg) as deferred work whenever the key with this make code is
+// pressed; the key is not buffered. Returns 0 if all slots are taken.
+int keyboard_set_hotkey(uint8_t scancode, defer_fn_t fn, void* arg);
+
 #endif
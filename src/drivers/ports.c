@@ -24,3 +24,14 @@ void port_word_out(unsigned short port, unsigned short data)
 {
     __asm__("out %%ax, %%dx" : : "a"(data), "d"(port));
 }
+
+// Block transfers of 'count' words (rep insw / rep outsw)
+void port_words_in(unsigned short port, void* buffer, unsigned int count)
+{
+    __asm__ volatile("rep insw" : "+D"(buffer), "+c"(count) : "d"(port) : "memory");
+}
+
+void port_words_out(unsigned short port, const void* buffer, unsigned int count)
+{
+    __asm__ volatile("rep outsw" : "+S"(buffer), "+c"(count) : "d"(port) : "memory");
+}
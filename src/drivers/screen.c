@@ -1,117 +1,147 @@
 #include "screen.h"
 #include "ports.h"
+#include "console.h"
+#include "../libc/string.h"
+#include <stdint.h>
 
-int get_cursor_offset();
-void set_cursor_offset(int offset);
 int print_char(char c, int col, int row, char attr);
-int get_offset(int col, int row);
-int get_offset_row(int offset);
-int get_offset_col(int offset);
-void memory_copy(char *source, char *dest, int nbytes);
+static int write_string(const char *message, int offset, char attr);
+static void scroll_up(void);
+static void sync_cursor(void);
+
+// The cursor lives in memory; the CRTC is only told where it is once per
+// string, since each CRTC access is port I/O (slow, especially emulated)
+static int cursor = -1;         // Offset in bytes, -1 until first read
+static int hw_cursor = -1;      // Last offset written to the CRTC
+static int drawing = 1;         // Cleared while the VGA is in graphics mode
 
 void kprint_at(const char *message, int col, int row)
 {
-    int offset;
     if (col >= 0 && row >= 0)
-        offset = get_offset(col, row);
-    else
     {
-        offset = get_cursor_offset();
-        row = get_offset_row(offset);
-        col = get_offset_col(offset);
+        // Fixed position: leave the cursor where it is
+        write_string(message, get_offset(col, row), WHITE_ON_BLACK);
+        return;
     }
 
-    int i = 0;
-    while (message[i] != 0)
-    {
-        offset = print_char(message[i++], col, row, WHITE_ON_BLACK);
-        row = get_offset_row(offset);
-        col = get_offset_col(offset);
-    }
+    cursor = write_string(message, get_cursor_offset(), WHITE_ON_BLACK);
+    sync_cursor();
 }
 
 void kprint(const char *message)
+{
+    console_write(message);
+}
+
+void screen_write(const char *message)
 {
     kprint_at(message, -1, -1);
 }
 
-void clear_screen()
+void screen_set_active(int active)
 {
-    int screen_size = MAX_COLS * MAX_ROWS;
-    int i;
-    char *screen = (char *)VIDEO_ADDRESS;
+    drawing = active;
+}
 
-    for (i = 0; i < screen_size; i++)
-    {
-        screen[i * 2] = ' ';
-        screen[i * 2 + 1] = WHITE_ON_BLACK;
-    }
+void clear_screen()
+{
+    if (!drawing)
+        return;
+    memset16((void *)VIDEO_ADDRESS, ' ' | (WHITE_ON_BLACK << 8), MAX_COLS * MAX_ROWS);
     set_cursor_offset(get_offset(0, 0));
 }
 
 int print_char(char c, int col, int row, char attr)
+{
+    char str[2] = {c, '\0'};
+    int offset;
+
+    if (col >= 0 && row >= 0)
+        return write_string(str, get_offset(col, row), attr);
+
+    offset = write_string(str, get_cursor_offset(), attr);
+    set_cursor_offset(offset);
+    return offset;
+}
+
+// Write a string straight into video memory starting at 'offset' and
+// return the offset after it. Newlines and scrolling are handled inline;
+// the hardware cursor is not touched.
+static int write_string(const char *message, int offset, char attr)
 {
     unsigned char *vidmem = (unsigned char *)VIDEO_ADDRESS;
+    if (!drawing)
+        return offset;
     if (!attr)
         attr = WHITE_ON_BLACK;
 
-    if (col >= MAX_COLS || row >= MAX_ROWS)
+    if (offset < 0 || offset >= MAX_ROWS * MAX_COLS * 2)
     {
         vidmem[2 * (MAX_COLS) * (MAX_ROWS)-2] = 'E';
         vidmem[2 * (MAX_COLS) * (MAX_ROWS)-1] = RED_ON_WHITE;
-        return get_offset(col, row);
+        return offset;
     }
 
-    int offset;
-    if (col >= 0 && row >= 0)
-        offset = get_offset(col, row);
-    else
-        offset = get_cursor_offset();
-
-    if (c == '\n')
+    for (; *message; message++)
     {
-        int rows = offset / (2 * MAX_COLS);
-        offset = get_offset(0, rows + 1);
+        if (*message == '\n')
+        {
+            offset = get_offset(0, get_offset_row(offset) + 1);
+        }
+        else
+        {
+            vidmem[offset] = *message;
+            vidmem[offset + 1] = attr;
+            offset += 2;
+        }
+
+        if (offset >= MAX_ROWS * MAX_COLS * 2)
+        {
+            scroll_up();
+            offset -= 2 * MAX_COLS;
+        }
     }
-    else
-    {
-        vidmem[offset] = c;
-        vidmem[offset + 1] = attr;
-        offset += 2;
-    }
-
-    // Scroll if needed
-    if (offset >= MAX_ROWS * MAX_COLS * 2)
-    {
-        int i;
-        for (i = 1; i < MAX_ROWS; i++)
-            memory_copy((char *)(get_offset(0, i) + VIDEO_ADDRESS),
-                        (char *)(get_offset(0, i - 1) + VIDEO_ADDRESS),
-                        MAX_COLS * 2);
-
-        char *last_line = (char *)(get_offset(0, MAX_ROWS - 1) + VIDEO_ADDRESS);
-        for (i = 0; i < MAX_COLS * 2; i++)
-            last_line[i] = 0;
+    return offset;
+}
 
-        offset -= 2 * MAX_COLS;
-    }
+// Move every row up by one and blank the last
+static void scroll_up(void)
+{
+    unsigned char *vidmem = (unsigned char *)VIDEO_ADDRESS;
+    int row_bytes = 2 * MAX_COLS;
 
-    set_cursor_offset(offset);
-    return offset;
+    memmove(vidmem, vidmem + row_bytes, (MAX_ROWS - 1) * row_bytes);
+    memset(vidmem + (MAX_ROWS - 1) * row_bytes, 0, row_bytes);
 }
 
 int get_cursor_offset()
 {
-    port_byte_out(REG_SCREEN_CTRL, 14);
-    int offset = port_byte_in(REG_SCREEN_DATA) << 8;
-    port_byte_out(REG_SCREEN_CTRL, 15);
-    offset += port_byte_in(REG_SCREEN_DATA);
-    return offset * 2;
+    if (cursor < 0)
+    {
+        // First use: pick up where the boot code left the cursor
+        port_byte_out(REG_SCREEN_CTRL, 14);
+        int offset = port_byte_in(REG_SCREEN_DATA) << 8;
+        port_byte_out(REG_SCREEN_CTRL, 15);
+        offset += port_byte_in(REG_SCREEN_DATA);
+        cursor = hw_cursor = offset * 2;
+    }
+    return cursor;
 }
 
 void set_cursor_offset(int offset)
 {
-    offset /= 2;
+    cursor = offset;
+    sync_cursor();
+}
+
+// Tell the CRTC where the cursor is, if it moved
+static void sync_cursor(void)
+{
+    if (cursor == hw_cursor || !drawing)
+        return;
+    hw_cursor = cursor;
+
+    int offset = cursor / 2;
     port_byte_out(REG_SCREEN_CTRL, 14);
     port_byte_out(REG_SCREEN_DATA, (unsigned char)(offset >> 8));
     port_byte_out(REG_SCREEN_CTRL, 15);
@@ -121,12 +151,3 @@ void set_cursor_offset(int offset)
 int get_offset(int col, int row) { return 2 * (row * MAX_COLS + col); }
 int get_offset_row(int offset) { return offset / (2 * MAX_COLS); }
 int get_offset_col(int offset) { return (offset - (get_offset_row(offset) * 2 * MAX_COLS)) / 2; }
-
-void memory_copy(char *source, char *dest, int nbytes)
-{
-    int i;
-    for (i = 0; i < nbytes; i++)
-    {
-        *(dest + i) = *(source + i);
-    }
-}
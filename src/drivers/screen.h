@@ -14,7 +14,12 @@
 // Public kernel API
 void clear_screen();
 void kprint_at(const char *message, int col, int row);
-void kprint(const char *message);
+void kprint(const char *message);     // Through the console (console.h)
+void screen_write(const char *message); // Screen only, at the cursor
+
+// Stop drawing while the VGA is in a graphics mode (vga.h); output is
+// dropped and the cursor left alone until re-activated
+void screen_set_active(int active);
 
 // Cursor management
 int get_cursor_offset();
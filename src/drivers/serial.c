@@ -0,0 +1,138 @@
+#include "serial.h"
+#include "ports.h"
+#include "../cpu/cpu.h"
+#include "../cpu/spinlock.h"
+#include "../interrupt/isr.h"
+#include "../interrupt/idt.h"
+#include <stdint.h>
+
+static char tx_ring[SERIAL_TX_RING_SIZE];
+static uint32_t tx_head = 0;            // Bytes ever queued
+static uint32_t tx_tail = 0;            // Bytes ever handed to the UART
+static spinlock_t tx_lock = SPINLOCK_INIT;
+static uint8_t ier = 0;
+static uint8_t present = 0;
+static uint32_t stalls = 0;
+
+static inline int tx_ready(void) {
+    return port_byte_in(SERIAL_COM1 + SERIAL_REG_LSR) & SERIAL_LSR_THRE;
+}
+
+// Refill the empty transmit FIFO from the ring. Called locked.
+static void serial_fill_fifo(void) {
+    for (int i = 0; i < SERIAL_FIFO_SIZE && tx_tail != tx_head; i++) {
+        port_byte_out(SERIAL_COM1 + SERIAL_REG_DATA,
+                      (uint8_t)tx_ring[tx_tail++ & (SERIAL_TX_RING_SIZE - 1)]);
+    }
+}
+
+// Ask for a THRE interrupt only while there is something left to send
+static void serial_update_ier(void) {
+    uint8_t want = tx_head != tx_tail ? SERIAL_IER_THRI : 0;
+    if (want != ier) {
+        ier = want;
+        port_byte_out(SERIAL_COM1 + SERIAL_REG_IER, ier);
+    }
+}
+
+static void serial_put(char c) {
+    if (tx_head - tx_tail == SERIAL_TX_RING_SIZE) {
+        // Full: drain by polling rather than drop log output
+        stalls++;
+        while (tx_head - tx_tail == SERIAL_TX_RING_SIZE) {
+            while (!tx_ready()) {
+                cpu_relax();
+            }
+            serial_fill_fifo();
+        }
+    }
+    tx_ring[tx_head++ & (SERIAL_TX_RING_SIZE - 1)] = c;
+}
+
+static void serial_irq_handler(registers_t* regs) {
+    (void)regs;
+    spin_lock(&tx_lock);
+    
+    // Reading IIR acknowledges a THRE interrupt. The FIFO may have been
+    // refilled by a writer since it was raised, so check it is empty.
+    port_byte_in(SERIAL_COM1 + SERIAL_REG_IIR);
+    if (tx_ready()) {
+        serial_fill_fifo();
+    }
+    serial_update_ier();
+    spin_unlock(&tx_lock);
+}
+
+int serial_init(uint32_t baud) {
+    if (baud == 0 || baud > SERIAL_CLOCK) {
+        return 0;
+    }
+    uint16_t divisor = (uint16_t)(SERIAL_CLOCK / baud);
+    
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_IER, 0);
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_LCR, SERIAL_LCR_DLAB);
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_DATA, (uint8_t)(divisor & 0xFF));
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_IER, (uint8_t)(divisor >> 8));
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_LCR, SERIAL_LCR_8N1);
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_FCR, SERIAL_FCR_ENABLE);
+    
+    // A byte sent in loopback mode must come straight back
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_MCR, SERIAL_MCR_DTR_RTS | SERIAL_MCR_OUT2 | SERIAL_MCR_LOOP);
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_DATA, 0xAE);
+    if (port_byte_in(SERIAL_COM1 + SERIAL_REG_DATA) != 0xAE) {
+        return 0;
+    }
+    port_byte_out(SERIAL_COM1 + SERIAL_REG_MCR, SERIAL_MCR_DTR_RTS | SERIAL_MCR_OUT2);
+    
+    register_interrupt_handler(IRQ4, serial_irq_handler);
+    irq_clear_mask(4);
+    present = 1;
+    return 1;
+}
+
+int serial_present(void) {
+    return present;
+}
+
+void serial_write(const char* str) {
+    if (!present) {
+        return;
+    }
+    uint32_t flags = cpu_irq_save();
+    spin_lock(&tx_lock);
+    for (; *str; str++) {
+        if (*str == '\n') {
+            serial_put('\r');
+        }
+        serial_put(*str);
+    }
+    
+    // Start an idle transmitter; the THRE interrupt keeps it going
+    if (tx_ready()) {
+        serial_fill_fifo();
+    }
+    serial_update_ier();
+    spin_unlock(&tx_lock);
+    cpu_irq_restore(flags);
+}
+
+void serial_flush(void) {
+    if (!present) {
+        return;
+    }
+    uint32_t flags = cpu_irq_save();
+    spin_lock(&tx_lock);
+    while (tx_head != tx_tail) {
+        while (!tx_ready()) {
+            cpu_relax();
+        }
+        serial_fill_fifo();
+    }
+    serial_update_ier();
+    spin_unlock(&tx_lock);
+    cpu_irq_restore(flags);
+}
+
+uint32_t serial_stalls(void) {
+    return stalls;
+}
@@ -0,0 +1,52 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdint.h>
+
+// 16550 UART on COM1
+#define SERIAL_COM1 0x3F8
+#define SERIAL_CLOCK 115200         // Divisor latch base rate
+
+// Register offsets from the I/O base
+#define SERIAL_REG_DATA 0           // RX/TX, divisor low with DLAB
+#define SERIAL_REG_IER 1            // Interrupt enable, divisor high with DLAB
+#define SERIAL_REG_IIR 2            // Interrupt identification (read)
+#define SERIAL_REG_FCR 2            // FIFO control (write)
+#define SERIAL_REG_LCR 3
+#define SERIAL_REG_MCR 4
+#define SERIAL_REG_LSR 5
+
+#define SERIAL_IER_THRI 0x02        // Interrupt when the transmitter empties
+#define SERIAL_FCR_ENABLE 0xC7      // Enable and clear FIFOs, 14-byte RX trigger
+#define SERIAL_LCR_8N1 0x03
+#define SERIAL_LCR_DLAB 0x80
+#define SERIAL_MCR_DTR_RTS 0x03
+#define SERIAL_MCR_OUT2 0x08        // Gates the UART interrupt onto the bus
+#define SERIAL_MCR_LOOP 0x10
+#define SERIAL_LSR_THRE 0x20        // Transmit holding register empty
+
+// The 16550 transmit FIFO
+#define SERIAL_FIFO_SIZE 16
+
+// Transmit ring; writers only block when it is full
+#define SERIAL_TX_RING_SIZE (64 * 1024)     // Power of two
+
+// Probe COM1 (loopback test), program 'baud' 8N1 and start IRQ4-driven
+// transmit. Returns 0 if there is no UART.
+int serial_init(uint32_t baud);
+
+// Non-zero once serial_init has found the UART
+int serial_present(void);
+
+// Queue bytes for transmit ("\n" goes out as "\r\n"). Safe from any CPU
+// and from interrupt handlers. If the ring is full the caller drains it
+// by polling, so nothing is lost.
+void serial_write(const char* str);
+
+// Transmit everything queued by polling (before a halt or reset)
+void serial_flush(void);
+
+// Times a writer found the ring full and had to drain it by polling
+uint32_t serial_stalls(void);
+
+#endif
@@ -3,67 +3,138 @@
 #include "screen.h"
 #include "../interrupt/isr.h"
 #include "../interrupt/idt.h"
+#include "../interrupt/defer.h"
+#include "../cpu/cpu.h"
+#include "../cpu/lapic.h"
+#include "clock.h"
+#include "../cpu/smp.h"
+#include "../cpu/spinlock.h"
+#include "../math/math.h"
+#include "../libc/printf.h"
 #include <stdint.h>
+#include <stddef.h>
 
-// Global tick counter
-static volatile uint32_t tick_count = 0;
+// Pending events, ordered by the wheel; only the BSP takes timer interrupts
+static timer_wheel_t wheel;
+static spinlock_t timer_lock = SPINLOCK_INIT;
+static uint8_t timer_ready = 0;
 
-// PIT constants
-#define PIT_COMMAND 0x43
-#define PIT_CHANNEL0 0x40
-#define PIT_FREQUENCY 1193182  // Base PIT frequency in Hz
+static timer_source_t source = TIMER_SOURCE_PIT;
 
-// Helper function to convert int to string
-static void int_to_str(uint32_t num, char* str) {
-    int i = 0;
+// Deadline the hardware is currently armed for (TIMER_WHEEL_NONE if idle)
+static uint64_t armed = TIMER_WHEEL_NONE;
+
+// Length of a legacy tick (timer_get_ticks / timer_wait units) and, for
+// the PIT fallback, the time accumulated from its periodic interrupts
+static uint32_t tick_ns = 10000000;
+static volatile uint64_t pit_ns = 0;
+
+// Seconds display in the top right corner
+static timer_event_t uptime_event;
+static uint32_t uptime_seconds = 0;
+
+// Interrupted state while timer_callback runs events
+static registers_t* irq_regs = NULL;
+
+uint64_t timer_now_ns(void) {
+    if (source != TIMER_SOURCE_PIT || clock_tsc_khz()) {
+        return clock_ns();
+    }
     
-    if (num == 0) {
-        str[0] = '0';
-        str[1] = '\0';
+    // 64-bit reads are not atomic here; retry if a tick landed in between
+    uint64_t now;
+    do {
+        now = pit_ns;
+    } while (now != pit_ns);
+    return now;
+}
+
+// Arm the one-shot hardware timer for the wheel's next deadline. The PIT
+// fallback keeps ticking periodically, so there is nothing to program.
+// Called with timer_lock held.
+static void timer_program(void) {
+    uint64_t next = timer_wheel_next(&wheel);
+    armed = next;
+    if (source == TIMER_SOURCE_PIT) {
         return;
     }
-    
-    while (num > 0) {
-        str[i++] = '0' + (num % 10);
-        num /= 10;
+    if (next == TIMER_WHEEL_NONE) {
+        if (source == TIMER_SOURCE_TSC_DEADLINE) {
+            lapic_timer_set_deadline(0);
+        } else {
+            lapic_timer_start(IRQ_LAPIC_TIMER, LAPIC_TIMER_ONESHOT, 0);
+        }
+        return;
     }
-    str[i] = '\0';
     
-    // Reverse string
-    for (int j = 0; j < i / 2; j++) {
-        char temp = str[j];
-        str[j] = str[i - j - 1];
-        str[i - j - 1] = temp;
+    uint64_t now = clock_ns();
+    uint64_t delta = next > now ? next - now : 0;
+    if (source == TIMER_SOURCE_TSC_DEADLINE) {
+        // A deadline already in the past fires immediately
+        lapic_timer_set_deadline(rdtsc() + clock_ns_to_tsc(delta));
+    } else {
+        // Longer waits wake early, find nothing due and re-arm
+        if (delta > TIMER_ONESHOT_MAX_NS) {
+            delta = TIMER_ONESHOT_MAX_NS;
+        }
+        uint64_t count = k_udiv64(delta * clock_lapic_hz(), 1000000000);
+        lapic_timer_start(IRQ_LAPIC_TIMER, LAPIC_TIMER_ONESHOT, count ? (uint32_t)count : 1);
     }
 }
 
-// Timer interrupt handler
+// Timer interrupt handler: run every due event, then arm for the next one
 static void timer_callback(registers_t* regs) {
-    (void)regs;  // Unused parameter
-    tick_count++;
+    if (source == TIMER_SOURCE_PIT) {
+        pit_ns += tick_ns;
+    }
     
-    // Display tick counter in top right corner every 100 ticks (~1 second at 100Hz)
-    if (tick_count % 100 == 0) {
-        char buffer[32];
-        int_to_str(tick_count / 100, buffer);
-        
-        // Save current cursor position
-        int old_offset = get_cursor_offset();
+    irq_regs = regs;
+    spin_lock(&timer_lock);
+    uint64_t now = timer_now_ns();
+    timer_event_t* due = timer_wheel_advance(&wheel, now);
+    while (due) {
+        timer_event_t* ev = due;
+        due = ev->next;
         
-        // Print to top right corner (row 0, col 70)
-        int offset = get_offset(0, 70);
-        set_cursor_offset(offset);
-        kprint("Time: ");
-        kprint(buffer);
-        kprint("s ");
+        // Periodic events keep their phase; missed periods are skipped
+        // rather than delivered in a burst
+        if (ev->period) {
+            do {
+                ev->expires += ev->period;
+            } while (ev->expires <= now);
+            timer_wheel_insert(&wheel, ev);
+        }
         
-        // Restore cursor position
-        set_cursor_offset(old_offset);
+        // Callbacks may add or cancel events, so run them unlocked
+        timer_fn_t fn = ev->fn;
+        void* arg = ev->arg;
+        spin_unlock(&timer_lock);
+        fn(arg);
+        spin_lock(&timer_lock);
     }
+    timer_program();
+    spin_unlock(&timer_lock);
+    irq_regs = NULL;
 }
 
-// Initialize the timer
-void timer_init(uint32_t frequency) {
+// Console output is slow, so it runs deferred
+static void uptime_display(void* arg) {
+    (void)arg;
+    char buffer[32];
+    ksnprintf(buffer, sizeof(buffer), "Time: %us ", uptime_seconds);
+    
+    // Top right corner (row 0, col 70), on screen only; the cursor stays put
+    kprint_at(buffer, 70, 0);
+}
+
+static void uptime_callback(void* arg) {
+    (void)arg;
+    uptime_seconds++;
+    defer_queue(uptime_display, NULL);
+}
+
+// Program PIT channel 0 as a rate generator on IRQ0
+static void pit_start(uint32_t frequency) {
     // Register the timer interrupt handler
     register_interrupt_handler(IRQ0, timer_callback);
     
@@ -84,16 +155,144 @@ void timer_init(uint32_t frequency) {
     irq_clear_mask(0);
 }
 
+// Initialize the timer, preferring the local APIC over the PIT
+void timer_init(uint32_t frequency) {
+    if (cpu_has_edx(CPUID_EDX_APIC)) {
+        lapic_init(0);
+    }
+    clock_init();
+    tick_ns = 1000000000 / frequency;
+    
+    if (lapic_available() && clock_tsc_khz() && cpu_has_ecx(CPUID_ECX_TSC_DEADLINE)) {
+        source = TIMER_SOURCE_TSC_DEADLINE;
+        register_interrupt_handler(IRQ_LAPIC_TIMER, timer_callback);
+        lapic_timer_start(IRQ_LAPIC_TIMER, LAPIC_TIMER_TSC_DEADLINE, 0);
+    } else if (lapic_available() && clock_tsc_khz() && clock_lapic_hz()) {
+        source = TIMER_SOURCE_LAPIC;
+        register_interrupt_handler(IRQ_LAPIC_TIMER, timer_callback);
+    } else {
+        source = TIMER_SOURCE_PIT;
+        pit_start(frequency);
+    }
+    timer_wheel_init(&wheel, timer_now_ns());
+    timer_ready = 1;
+    
+    timer_event_init(&uptime_event, uptime_callback, NULL);
+    timer_add_periodic(&uptime_event, 1000000000ULL);
+    
+    kprintf("Timer: %s\n", timer_source_name());
+}
+
+void timer_event_init(timer_event_t* ev, timer_fn_t fn, void* arg) {
+    ev->expires = 0;
+    ev->period = 0;
+    ev->fn = fn;
+    ev->arg = arg;
+    ev->next = NULL;
+    ev->pprev = NULL;
+}
+
+// Queue an event whose expires/period are set; re-arms the hardware only
+// if it became the earliest deadline
+static void timer_queue(timer_event_t* ev) {
+    uint32_t flags = cpu_irq_save();
+    spin_lock(&timer_lock);
+    timer_wheel_remove(&wheel, ev);
+    timer_wheel_insert(&wheel, ev);
+    if (ev->expires < armed) {
+        timer_program();
+    }
+    spin_unlock(&timer_lock);
+    cpu_irq_restore(flags);
+}
+
+void timer_add(timer_event_t* ev, uint64_t delay_ns) {
+    ev->expires = timer_now_ns() + delay_ns;
+    ev->period = 0;
+    timer_queue(ev);
+}
+
+void timer_add_periodic(timer_event_t* ev, uint64_t period_ns) {
+    ev->expires = timer_now_ns() + period_ns;
+    ev->period = period_ns;
+    timer_queue(ev);
+}
+
+int timer_cancel(timer_event_t* ev) {
+    uint32_t flags = cpu_irq_save();
+    spin_lock(&timer_lock);
+    int pending = ev->pprev != NULL;
+    timer_wheel_remove(&wheel, ev);
+    ev->period = 0;
+    spin_unlock(&timer_lock);
+    cpu_irq_restore(flags);
+    return pending;
+}
+
+registers_t* timer_irq_regs(void) {
+    return irq_regs;
+}
+
+int timer_pending(const timer_event_t* ev) {
+    return ev->pprev != NULL;
+}
+
+static void sleep_callback(void* arg) {
+    *(volatile int*)arg = 1;
+}
+
+void timer_sleep_ns(uint64_t ns) {
+    uint64_t deadline = timer_now_ns() + ns;
+    uint32_t flags = cpu_irq_save();
+    
+    // Only the BSP receives timer interrupts, and only once they are on;
+    // everyone else polls the clock
+    if (!timer_ready || !(flags & EFLAGS_IF) || smp_cpu_index() != 0) {
+        cpu_irq_restore(flags);
+        while (timer_now_ns() < deadline) {
+            cpu_relax();
+        }
+        return;
+    }
+    
+    volatile int done = 0;
+    timer_event_t ev;
+    timer_event_init(&ev, sleep_callback, (void*)&done);
+    ev.expires = deadline;
+    timer_queue(&ev);
+    
+    // Run deferred work while waiting. sti only takes effect after the
+    // next instruction, so no wakeup can slip in between the check and
+    // the hlt.
+    while (!done) {
+        __asm__ volatile("sti" ::: "memory");
+        defer_run();
+        __asm__ volatile("cli" ::: "memory");
+        if (!done && !defer_pending()) {
+            __asm__ volatile("sti; hlt; cli" ::: "memory");
+        }
+    }
+    cpu_irq_restore(flags);
+}
+
+timer_source_t timer_get_source(void) {
+    return source;
+}
+
+const char* timer_source_name(void) {
+    switch (source) {
+        case TIMER_SOURCE_TSC_DEADLINE: return "TSC-deadline";
+        case TIMER_SOURCE_LAPIC: return "local APIC";
+        default: return "PIT";
+    }
+}
+
 // Get current tick count
 uint32_t timer_get_ticks(void) {
-    return tick_count;
+    return (uint32_t)k_udiv64(timer_now_ns(), tick_ns);
 }
 
 // Wait for a specified number of ticks
 void timer_wait(uint32_t ticks) {
-    uint32_t end_tick = tick_count + ticks;
-    while (tick_count < end_tick) {
-        // Halt CPU until next interrupt for efficiency
-        __asm__ volatile("hlt");
-    }
+    timer_sleep_ns((uint64_t)ticks * tick_ns);
 }
@@ -1,12 +1,55 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+#include "timer_wheel.h"
+#include "../interrupt/isr.h"
 #include <stdint.h>
 
-// Initialize the Programmable Interval Timer (PIT)
+// PIT constants
+#define PIT_COMMAND 0x43
+#define PIT_CHANNEL0 0x40
+#define PIT_FREQUENCY 1193182  // Base PIT frequency in Hz
+
+// Hardware driving the tick interrupt, best first
+typedef enum {
+    TIMER_SOURCE_TSC_DEADLINE,  // LAPIC armed with absolute TSC deadlines
+    TIMER_SOURCE_LAPIC,         // LAPIC periodic mode, calibrated against the PIT
+    TIMER_SOURCE_PIT            // Legacy PIT on IRQ0
+} timer_source_t;
+
+// Longest one-shot LAPIC countdown, keeping the count within 32 bits
+#define TIMER_ONESHOT_MAX_NS 1000000000ULL
+
+// Set up the event timer on the best available source. With the local
+// APIC the timer is tickless: it is armed one-shot for the earliest
+// pending event and otherwise stays quiet. The PIT fallback ticks at
+// 'frequency' Hz. Also calibrates the TSC (see clock.h). Call with
+// interrupts disabled.
 void timer_init(uint32_t frequency);
 
-// Get the current tick count
+timer_source_t timer_get_source(void);
+const char* timer_source_name(void);
+
+// Nanoseconds since boot (TSC based where available)
+uint64_t timer_now_ns(void);
+
+// Events run in interrupt context on the BSP and must not block.
+// A cancelled event may still run if it had already expired.
+void timer_event_init(timer_event_t* ev, timer_fn_t fn, void* arg);
+void timer_add(timer_event_t* ev, uint64_t delay_ns);
+void timer_add_periodic(timer_event_t* ev, uint64_t period_ns);
+int timer_cancel(timer_event_t* ev);   // Returns 1 if it was still queued
+int timer_pending(const timer_event_t* ev);
+
+// State interrupted by the timer interrupt, for events that inspect it
+// (the sampling profiler). NULL outside timer_callback.
+registers_t* timer_irq_regs(void);
+
+// Sleep for at least ns nanoseconds. Halts on the BSP with interrupts on;
+// otherwise busy-waits on the clock.
+void timer_sleep_ns(uint64_t ns);
+
+// Legacy ticks of 1/'frequency' seconds, derived from timer_now_ns
 uint32_t timer_get_ticks(void);
 
 // Wait for a specified number of ticks
@@ -0,0 +1,164 @@
+#include "timer_wheel.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_SLOT_BITS)
+#define WHEEL_SPAN_BITS (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)
+
+// Deadline in wheel units, rounded up so an event never fires early
+static inline uint64_t event_unit(const timer_event_t* ev) {
+    return (ev->expires + (1ULL << TIMER_WHEEL_SHIFT) - 1) >> TIMER_WHEEL_SHIFT;
+}
+
+// Lowest set bit of a non-zero mask (no libgcc for __builtin_ctzll on i386)
+static inline uint32_t ctz64(uint64_t mask) {
+    uint32_t lo = (uint32_t)mask;
+    return lo ? (uint32_t)__builtin_ctz(lo) : 32 + (uint32_t)__builtin_ctz((uint32_t)(mask >> 32));
+}
+
+static inline uint32_t digit(uint64_t unit, int level) {
+    return (uint32_t)(unit >> LEVEL_SHIFT(level)) & (TIMER_WHEEL_SLOTS - 1);
+}
+
+void timer_wheel_init(timer_wheel_t* wheel, uint64_t now_ns) {
+    wheel->now = now_ns >> TIMER_WHEEL_SHIFT;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        wheel->occupied[level] = 0;
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            wheel->slots[level][slot] = NULL;
+        }
+    }
+}
+
+void timer_wheel_insert(timer_wheel_t* wheel, timer_event_t* ev) {
+    uint64_t now = wheel->now;
+    uint64_t unit = event_unit(ev);
+    if (unit < now) {
+        unit = now;
+    }
+    
+    // Lowest level whose parent block still contains 'now'; the event's
+    // digit there is then strictly ahead of now's (or equal at level 0)
+    if ((unit >> WHEEL_SPAN_BITS) != (now >> WHEEL_SPAN_BITS)) {
+        unit = now | ((1ULL << WHEEL_SPAN_BITS) - 1);
+    }
+    int level = 0;
+    while ((unit >> LEVEL_SHIFT(level + 1)) != (now >> LEVEL_SHIFT(level + 1))) {
+        level++;
+    }
+    uint32_t slot = digit(unit, level);
+    
+    timer_event_t** head = &wheel->slots[level][slot];
+    ev->next = *head;
+    if (*head) {
+        (*head)->pprev = &ev->next;
+    }
+    *head = ev;
+    ev->pprev = head;
+    ev->level = (uint8_t)level;
+    ev->slot = (uint8_t)slot;
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+void timer_wheel_remove(timer_wheel_t* wheel, timer_event_t* ev) {
+    if (!ev->pprev) {
+        return;
+    }
+    *ev->pprev = ev->next;
+    if (ev->next) {
+        ev->next->pprev = ev->pprev;
+    }
+    if (!wheel->slots[ev->level][ev->slot]) {
+        wheel->occupied[ev->level] &= ~(1ULL << ev->slot);
+    }
+    ev->next = NULL;
+    ev->pprev = NULL;
+}
+
+// Detach a whole slot
+static timer_event_t* take_slot(timer_wheel_t* wheel, int level, uint32_t slot) {
+    timer_event_t* list = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+    wheel->occupied[level] &= ~(1ULL << slot);
+    return list;
+}
+
+// Earliest unit with an occupied slot, in wheel units
+static uint64_t next_unit(const timer_wheel_t* wheel) {
+    uint64_t now = wheel->now;
+    uint64_t best = TIMER_WHEEL_NONE;
+    
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        // Slots behind now's digit are always empty: every event sits in
+        // the same parent block as now and ahead of it
+        uint64_t pending = wheel->occupied[level] & (~0ULL << digit(now, level));
+        if (!pending) {
+            continue;
+        }
+        uint32_t slot = ctz64(pending);
+        uint64_t block = now & ~((1ULL << LEVEL_SHIFT(level + 1)) - 1);
+        uint64_t unit = block + ((uint64_t)slot << LEVEL_SHIFT(level));
+        if (unit < now) {
+            unit = now;
+        }
+        if (unit < best) {
+            best = unit;
+        }
+    }
+    return best;
+}
+
+uint64_t timer_wheel_next(const timer_wheel_t* wheel) {
+    uint64_t unit = next_unit(wheel);
+    return unit == TIMER_WHEEL_NONE ? TIMER_WHEEL_NONE : unit << TIMER_WHEEL_SHIFT;
+}
+
+timer_event_t* timer_wheel_advance(timer_wheel_t* wheel, uint64_t now_ns) {
+    uint64_t target = now_ns >> TIMER_WHEEL_SHIFT;
+    timer_event_t* expired = NULL;
+    timer_event_t** tail = &expired;
+    
+    // Jump straight between occupied slots instead of stepping every unit
+    for (;;) {
+        uint64_t unit = next_unit(wheel);
+        if (unit == TIMER_WHEEL_NONE || unit > target) {
+            break;
+        }
+        wheel->now = unit;
+        
+        // Entering a higher-level slot: redistribute it to finer levels
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            uint32_t slot = digit(unit, level);
+            if (!(wheel->occupied[level] & (1ULL << slot))) {
+                continue;
+            }
+            timer_event_t* ev = take_slot(wheel, level, slot);
+            while (ev) {
+                timer_event_t* next = ev->next;
+                timer_wheel_insert(wheel, ev);
+                ev = next;
+            }
+        }
+        
+        timer_event_t* ev = take_slot(wheel, 0, digit(unit, 0));
+        wheel->now = unit + 1;
+        while (ev) {
+            timer_event_t* next = ev->next;
+            if (event_unit(ev) <= unit) {
+                ev->pprev = NULL;
+                ev->next = NULL;
+                *tail = ev;
+                tail = &ev->next;
+            } else {
+                // Parked beyond the wheel's span; place it again
+                timer_wheel_insert(wheel, ev);
+            }
+            ev = next;
+        }
+    }
+    
+    if (target >= wheel->now) {
+        wheel->now = target + 1;
+    }
+    return expired;
+}
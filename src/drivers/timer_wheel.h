@@ -0,0 +1,54 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Hierarchical timing wheel. Time is counted in wheel units of
+// 2^TIMER_WHEEL_SHIFT ns (~1us). Level L has 64 slots of 64^L units each,
+// so insert/cancel are O(1) and an event is moved down at most once per
+// level before it fires. Events beyond the top level are parked in its
+// last reachable slot and re-placed when that slot is reached.
+#define TIMER_WHEEL_SHIFT 10
+#define TIMER_WHEEL_LEVELS 5
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+#define TIMER_WHEEL_NONE 0xFFFFFFFFFFFFFFFFULL
+
+typedef void (*timer_fn_t)(void* arg);
+
+// Caller-owned timer event; must stay valid while pending
+typedef struct timer_event {
+    uint64_t expires;               // Absolute deadline in ns
+    uint64_t period;                // Re-arm interval in ns, 0 for one-shot
+    timer_fn_t fn;
+    void* arg;
+    struct timer_event* next;
+    struct timer_event** pprev;     // NULL when not queued
+    uint8_t level;
+    uint8_t slot;
+} timer_event_t;
+
+typedef struct {
+    uint64_t now;                               // Next unit to be processed
+    uint64_t occupied[TIMER_WHEEL_LEVELS];      // Non-empty slot bitmap per level
+    timer_event_t* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t* wheel, uint64_t now_ns);
+
+// Queue ev at ev->expires (deadlines already passed fire on the next advance)
+void timer_wheel_insert(timer_wheel_t* wheel, timer_event_t* ev);
+
+// Unlink a queued event; no-op if it is not queued
+void timer_wheel_remove(timer_wheel_t* wheel, timer_event_t* ev);
+
+// Earliest time in ns at which timer_wheel_advance has work to do (an
+// expiry or a cascade), or TIMER_WHEEL_NONE if the wheel is empty
+uint64_t timer_wheel_next(const timer_wheel_t* wheel);
+
+// Advance to now_ns and return the expired events as a list linked
+// through 'next', in expiry order. They are no longer queued.
+timer_event_t* timer_wheel_advance(timer_wheel_t* wheel, uint64_t now_ns);
+
+#endif
@@ -0,0 +1,176 @@
+#include "vga.h"
+#include "ports.h"
+#include "screen.h"
+#include "../cpu/cpu.h"
+#include "../memory/memory.h"
+#include "../libc/string.h"
+#include <stdint.h>
+
+#define TEXT_BYTES (MAX_COLS * MAX_ROWS * 2)
+#define DAC_BYTES (256 * 3)
+
+typedef struct {
+    uint8_t misc;
+    uint8_t seq[VGA_NUM_SEQ];
+    uint8_t crtc[VGA_NUM_CRTC];
+    uint8_t gc[VGA_NUM_GC];
+    uint8_t ac[VGA_NUM_AC];
+} vga_regs_t;
+
+// Standard mode 13h register set: chain-4, 320x200 from 0xA0000
+static const vga_regs_t mode_13h = {
+    0x63,
+    { 0x03, 0x01, 0x0F, 0x00, 0x0E },
+    { 0x5F, 0x4F, 0x50, 0x82, 0x54, 0x80, 0xBF, 0x1F, 0x00, 0x41, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x9C, 0x0E, 0x8F, 0x28, 0x40, 0x96, 0xB9, 0xA3, 0xFF },
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x05, 0x0F, 0xFF },
+    { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+      0x0C, 0x0D, 0x0E, 0x0F, 0x41, 0x00, 0x0F, 0x00, 0x00 },
+};
+
+// Text mode state kept while in graphics. Mode 13h writes all four
+// planes, so the characters (planes 0/1) and font (plane 2) are lost
+// unless copied out first.
+typedef struct {
+    vga_regs_t regs;
+    uint8_t text[TEXT_BYTES];
+    uint8_t font[VGA_FONT_SIZE];
+    uint8_t dac[DAC_BYTES];
+} vga_saved_t;
+
+static vga_saved_t* saved = 0;
+static uint8_t graphics = 0;
+
+static uint8_t read_indexed(uint16_t index_port, uint8_t index) {
+    port_byte_out(index_port, index);
+    return port_byte_in(index_port + 1);
+}
+
+static void write_indexed(uint16_t index_port, uint8_t index, uint8_t value) {
+    port_byte_out(index_port, index);
+    port_byte_out(index_port + 1, value);
+}
+
+static void read_regs(vga_regs_t* r) {
+    r->misc = port_byte_in(VGA_MISC_READ);
+    for (uint8_t i = 0; i < VGA_NUM_SEQ; i++) {
+        r->seq[i] = read_indexed(VGA_SEQ_INDEX, i);
+    }
+    for (uint8_t i = 0; i < VGA_NUM_CRTC; i++) {
+        r->crtc[i] = read_indexed(VGA_CRTC_INDEX, i);
+    }
+    for (uint8_t i = 0; i < VGA_NUM_GC; i++) {
+        r->gc[i] = read_indexed(VGA_GC_INDEX, i);
+    }
+    
+    // The attribute controller shares one port for index and data
+    for (uint8_t i = 0; i < VGA_NUM_AC; i++) {
+        port_byte_in(VGA_INSTAT_READ);
+        port_byte_out(VGA_AC_INDEX, i);
+        r->ac[i] = port_byte_in(VGA_AC_READ);
+    }
+    port_byte_in(VGA_INSTAT_READ);
+    port_byte_out(VGA_AC_INDEX, 0x20);      // Give the palette back to the display
+}
+
+static void write_regs(const vga_regs_t* r) {
+    port_byte_out(VGA_MISC_WRITE, r->misc);
+    for (uint8_t i = 0; i < VGA_NUM_SEQ; i++) {
+        write_indexed(VGA_SEQ_INDEX, i, r->seq[i]);
+    }
+    
+    // CRTC 0-7 are write protected by bit 7 of register 0x11
+    write_indexed(VGA_CRTC_INDEX, 0x11, read_indexed(VGA_CRTC_INDEX, 0x11) & ~0x80);
+    for (uint8_t i = 0; i < VGA_NUM_CRTC; i++) {
+        write_indexed(VGA_CRTC_INDEX, i, r->crtc[i]);
+    }
+    for (uint8_t i = 0; i < VGA_NUM_GC; i++) {
+        write_indexed(VGA_GC_INDEX, i, r->gc[i]);
+    }
+    for (uint8_t i = 0; i < VGA_NUM_AC; i++) {
+        port_byte_in(VGA_INSTAT_READ);
+        port_byte_out(VGA_AC_INDEX, i);
+        port_byte_out(VGA_AC_INDEX, r->ac[i]);
+    }
+    port_byte_in(VGA_INSTAT_READ);
+    port_byte_out(VGA_AC_INDEX, 0x20);
+}
+
+// Map plane 2 (the font) linearly at 0xA0000 for reading and writing.
+// write_regs puts the text mode mapping back afterwards.
+static void map_font_plane(void) {
+    write_indexed(VGA_SEQ_INDEX, 2, 0x04);     // Write plane 2 only
+    write_indexed(VGA_SEQ_INDEX, 4, 0x06);     // Sequential, no odd/even
+    write_indexed(VGA_GC_INDEX, 1, 0x00);      // No set/reset
+    write_indexed(VGA_GC_INDEX, 3, 0x00);      // No rotate or logic op
+    write_indexed(VGA_GC_INDEX, 4, 0x02);      // Read plane 2
+    write_indexed(VGA_GC_INDEX, 5, 0x00);      // Write mode 0, no odd/even
+    write_indexed(VGA_GC_INDEX, 6, 0x04);      // 64KB at 0xA0000, no odd/even
+    write_indexed(VGA_GC_INDEX, 8, 0xFF);      // All bits writable
+}
+
+int vga_enter_graphics(void) {
+    if (graphics) {
+        return 1;
+    }
+    if (!saved) {
+        saved = (vga_saved_t*)kmalloc(sizeof(vga_saved_t));
+        if (!saved) {
+            return 0;
+        }
+    }
+    
+    // Stop console drawing first so nothing lands in the old text buffer
+    screen_set_active(0);
+    uint32_t flags = cpu_irq_save();
+    read_regs(&saved->regs);
+    memcpy(saved->text, (const void*)VIDEO_ADDRESS, TEXT_BYTES);
+    map_font_plane();
+    memcpy(saved->font, (const void*)VGA_GFX_ADDRESS, VGA_FONT_SIZE);
+    port_byte_out(VGA_DAC_READ_INDEX, 0);
+    for (uint32_t i = 0; i < DAC_BYTES; i++) {
+        saved->dac[i] = port_byte_in(VGA_DAC_DATA);
+    }
+    
+    write_regs(&mode_13h);
+    memset((void*)VGA_GFX_ADDRESS, 0, VGA_GFX_WIDTH * VGA_GFX_HEIGHT);
+    graphics = 1;
+    cpu_irq_restore(flags);
+    return 1;
+}
+
+void vga_leave_graphics(void) {
+    if (!graphics) {
+        return;
+    }
+    
+    uint32_t flags = cpu_irq_save();
+    write_regs(&saved->regs);
+    map_font_plane();
+    memcpy((void*)VGA_GFX_ADDRESS, saved->font, VGA_FONT_SIZE);
+    write_regs(&saved->regs);
+    memcpy((void*)VIDEO_ADDRESS, saved->text, TEXT_BYTES);
+    vga_set_palette(0, 256, saved->dac);
+    graphics = 0;
+    cpu_irq_restore(flags);
+    screen_set_active(1);
+}
+
+int vga_in_graphics(void) {
+    return graphics;
+}
+
+void vga_set_palette(uint32_t first, uint32_t count, const uint8_t* rgb) {
+    port_byte_out(VGA_DAC_WRITE_INDEX, (uint8_t)first);
+    for (uint32_t i = 0; i < count * 3; i++) {
+        port_byte_out(VGA_DAC_DATA, rgb[i]);
+    }
+}
+
+const uint8_t* vga_font(void) {
+    return saved->font;
+}
+
+uint32_t vga_font_height(void) {
+    return (saved->regs.crtc[9] & 0x1F) + 1;
+}
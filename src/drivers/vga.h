@@ -0,0 +1,58 @@
+#ifndef VGA_H
+#define VGA_H
+
+#include <stdint.h>
+
+// Mode 13h: 320x200, one byte per pixel indexing the 256-entry DAC
+#define VGA_GFX_ADDRESS 0xA0000
+#define VGA_GFX_WIDTH 320
+#define VGA_GFX_HEIGHT 200
+
+// Register ports (colour addressing)
+#define VGA_AC_INDEX 0x3C0          // Attribute controller, index and data
+#define VGA_AC_READ 0x3C1
+#define VGA_MISC_WRITE 0x3C2
+#define VGA_SEQ_INDEX 0x3C4
+#define VGA_SEQ_DATA 0x3C5
+#define VGA_DAC_READ_INDEX 0x3C7
+#define VGA_DAC_WRITE_INDEX 0x3C8
+#define VGA_DAC_DATA 0x3C9
+#define VGA_MISC_READ 0x3CC
+#define VGA_GC_INDEX 0x3CE
+#define VGA_GC_DATA 0x3CF
+#define VGA_CRTC_INDEX 0x3D4
+#define VGA_CRTC_DATA 0x3D5
+#define VGA_INSTAT_READ 0x3DA       // Reading resets the AC index/data flip-flop
+
+#define VGA_NUM_SEQ 5
+#define VGA_NUM_CRTC 25
+#define VGA_NUM_GC 9
+#define VGA_NUM_AC 21
+
+// Text mode font: 256 glyphs, 32 bytes apart in plane 2
+#define VGA_FONT_GLYPHS 256
+#define VGA_FONT_STRIDE 32
+#define VGA_FONT_SIZE (VGA_FONT_GLYPHS * VGA_FONT_STRIDE)
+
+// Switch to mode 13h by programming the registers directly (no BIOS in
+// protected mode). The text mode registers, screen contents, font and
+// palette are saved first, and the text console stops drawing until
+// vga_leave_graphics. Returns 0 if the save buffers cannot be allocated.
+int vga_enter_graphics(void);
+
+// Restore text mode exactly as vga_enter_graphics found it
+void vga_leave_graphics(void);
+
+// Non-zero while in mode 13h
+int vga_in_graphics(void);
+
+// Load 'count' DAC entries from 'first' with 6-bit R, G, B triples
+void vga_set_palette(uint32_t first, uint32_t count, const uint8_t* rgb);
+
+// The text mode font saved by vga_enter_graphics (VGA_FONT_STRIDE bytes
+// per glyph, one byte per row, MSB leftmost) and its glyph height. Valid
+// while in graphics mode.
+const uint8_t* vga_font(void);
+uint32_t vga_font_height(void);
+
+#endif
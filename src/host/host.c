@@ -0,0 +1,46 @@
+#include "host.h"
+#include "../memory/memory.h"
+#include "../cpu/smp.h"
+#include "../drivers/timer.h"
+#include <stdint.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// What QEMU's BIOS reports for 128MB
+static const e820_entry_t host_e820[] = {
+    { 0x00000000, 0x0009FC00, E820_USABLE, 1 },
+    { 0x0009FC00, 0x00000400, E820_RESERVED, 1 },
+    { 0x000F0000, 0x00010000, E820_RESERVED, 1 },
+    { 0x00100000, HOST_MEM_TOP - 0x00100000, E820_USABLE, 1 },
+};
+
+int host_memory_init(void) {
+    void* mem = mmap((void*)HOST_MEM_BASE, HOST_MEM_TOP - HOST_MEM_BASE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mem != (void*)HOST_MEM_BASE) {
+        return 0;
+    }
+    
+    *(uint32_t*)MEMORY_MAP_COUNT_ADDR = sizeof(host_e820) / sizeof(host_e820[0]);
+    e820_entry_t* entries = (e820_entry_t*)MEMORY_MAP_ADDR;
+    for (uint32_t i = 0; i < sizeof(host_e820) / sizeof(host_e820[0]); i++) {
+        entries[i] = host_e820[i];
+    }
+    memory_init();
+    return 1;
+}
+
+uint64_t host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Kernel services the hosted modules call: one CPU, no timer
+uint32_t smp_cpu_count(void) {
+    return 1;
+}
+
+uint32_t smp_cpu_index(void) {
+    return 0;
+}
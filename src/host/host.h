@@ -0,0 +1,31 @@
+#ifndef HOST_H
+#define HOST_H
+
+// Hosted build ('make hostbench'): the allocator and math modules
+// compiled into a Linux program, so they can be tuned under perf or a
+// sanitizer without booting. The host rules force-include this header
+// ahead of every source.
+//
+// Physical memory is an mmap at the addresses it has under QEMU, so the
+// PMM bitmap and the heap get the same layout and pointers still fit in
+// 32 bits. _kernel_start/_kernel_end come from --defsym in the Makefile
+// (a fake 320KB image at the real load address).
+
+#include <stdint.h>
+
+#define HOST_MEM_BASE 0x10000           // Lowest address Linux maps by default
+#define HOST_MEM_TOP 0x08000000         // 128MB, QEMU's default RAM size
+
+// Boot data the bootloader leaves below 1MB, moved up into the mapping
+// (real mode memory the PMM never hands out)
+#define MEMORY_MAP_COUNT_ADDR 0x8FFFC
+#define MEMORY_MAP_ADDR 0x90000
+
+// Map [HOST_MEM_BASE, HOST_MEM_TOP), write an E820 map like QEMU's and
+// run memory_init. Returns 0 if the range cannot be mapped.
+int host_memory_init(void);
+
+// Wall clock for the harness
+uint64_t host_ns(void);
+
+#endif
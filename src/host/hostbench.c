@@ -0,0 +1,280 @@
+#include "host.h"
+#include "../memory/memory.h"
+#include "../math/gemm.h"
+#include "../math/random.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Host microbenchmarks and stress runs over the kernel's allocator and
+// GEMM. Results use the kernel suite's line format (kernel/bench.h)
+// without the BENCH prefix:
+//
+//   hostbench [alloc|pmm|gemm|all] [-n ops] [-s seed] [-b mc,kc,nc]
+//
+// Exits non-zero if a check fails.
+
+#define HOST_MIN_NS 50000000ULL         // Each GEMM size runs at least 50ms
+
+#define ALLOC_SLOTS 1024
+#define ALLOC_MAX_SHIFT 16              // Sizes up to 64KB, log-uniform
+#define PMM_SLOTS 256
+#define PMM_MAX_RUN 16
+
+static uint32_t failures = 0;
+
+static void result(const char* name, double value, const char* unit, uint32_t iters, uint64_t ns) {
+    printf("{\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\",\"iters\":%u,\"ns\":%llu}\n",
+           name, value, unit, iters, (unsigned long long)ns);
+}
+
+static void fail(const char* what, uint32_t op) {
+    fprintf(stderr, "hostbench: %s at op %u\n", what, op);
+    failures++;
+}
+
+typedef struct {
+    uint8_t* ptr;
+    uint32_t size;
+    uint8_t tag;
+} alloc_slot_t;
+
+static int check_fill(const alloc_slot_t* s) {
+    for (uint32_t i = 0; i < s->size; i++) {
+        if (s->ptr[i] != s->tag) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Random kmalloc/kmalloc_aligned/kfree trace. Every block is filled with
+// its own tag and checked before it is freed, so overlapping blocks or a
+// corrupted free list show up as failures.
+static void bench_alloc(rng_t* rng, uint32_t ops) {
+    static alloc_slot_t slots[ALLOC_SLOTS];
+    uint64_t alloc_ns = 0, free_ns = 0;
+    uint32_t allocs = 0, frees = 0;
+    
+    for (uint32_t op = 0; op < ops; op++) {
+        alloc_slot_t* s = &slots[random_range(rng, ALLOC_SLOTS)];
+        if (s->ptr) {
+            if (!check_fill(s)) {
+                fail("heap block overwritten", op);
+            }
+            uint64_t start = host_ns();
+            kfree(s->ptr);
+            free_ns += host_ns() - start;
+            frees++;
+            s->ptr = 0;
+            continue;
+        }
+        
+        uint32_t size = 1 + random_range(rng, 1u << random_range(rng, ALLOC_MAX_SHIFT + 1));
+        uint32_t align = random_range(rng, 8) ? 0 : 32u << random_range(rng, 8);
+        uint64_t start = host_ns();
+        s->ptr = (uint8_t*)(align ? kmalloc_aligned(size, align) : kmalloc(size));
+        alloc_ns += host_ns() - start;
+        allocs++;
+        if (!s->ptr) {
+            continue;           // Heap full; the trace goes on
+        }
+        if (align && ((uint32_t)(uintptr_t)s->ptr & (align - 1))) {
+            fail("misaligned kmalloc_aligned", op);
+        }
+        s->size = size;
+        s->tag = (uint8_t)(op | 1);
+        memset(s->ptr, s->tag, size);
+    }
+    for (uint32_t i = 0; i < ALLOC_SLOTS; i++) {
+        if (slots[i].ptr) {
+            if (!check_fill(&slots[i])) {
+                fail("heap block overwritten", ops);
+            }
+            kfree(slots[i].ptr);
+            slots[i].ptr = 0;
+        }
+    }
+    
+    result("host_kmalloc", allocs ? (double)alloc_ns / allocs : 0, "ns/op", allocs, alloc_ns);
+    result("host_kfree", frees ? (double)free_ns / frees : 0, "ns/op", frees, free_ns);
+}
+
+typedef struct {
+    uint32_t* ptr;
+    uint32_t count;
+} pmm_slot_t;
+
+// Random single pages and contiguous runs; the first word of every page
+// holds its owner so a page handed out twice is caught
+static void bench_pmm(rng_t* rng, uint32_t ops) {
+    static pmm_slot_t slots[PMM_SLOTS];
+    uint32_t free_before = pmm_get_free_pages();
+    uint64_t start = host_ns();
+    
+    for (uint32_t op = 0; op < ops; op++) {
+        uint32_t index = random_range(rng, PMM_SLOTS);
+        pmm_slot_t* s = &slots[index];
+        if (s->ptr) {
+            for (uint32_t p = 0; p < s->count; p++) {
+                if (s->ptr[p * PAGE_SIZE / 4] != index) {
+                    fail("page shared by two owners", op);
+                }
+            }
+            if (s->count == 1) {
+                pmm_free_page(s->ptr);
+            } else {
+                pmm_free_pages(s->ptr, s->count);
+            }
+            s->ptr = 0;
+            continue;
+        }
+        
+        s->count = random_range(rng, 4) ? 1 : 1 + random_range(rng, PMM_MAX_RUN);
+        s->ptr = (uint32_t*)(s->count == 1 ? pmm_alloc_page() : pmm_alloc_pages(s->count));
+        for (uint32_t p = 0; s->ptr && p < s->count; p++) {
+            s->ptr[p * PAGE_SIZE / 4] = index;
+        }
+    }
+    for (uint32_t i = 0; i < PMM_SLOTS; i++) {
+        if (slots[i].ptr) {
+            pmm_free_pages(slots[i].ptr, slots[i].count);
+            slots[i].ptr = 0;
+        }
+    }
+    uint64_t ns = host_ns() - start;
+    
+    if (pmm_get_free_pages() != free_before) {
+        fail("free page count not restored", ops);
+    }
+    result("host_pmm", (double)ns / ops, "ns/op", ops, ns);
+}
+
+// Reference C = A * B (row-major, no transposes)
+static void gemm_reference(uint32_t n, const float* a, const float* b, float* c) {
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = 0; j < n; j++) {
+            double sum = 0;
+            for (uint32_t k = 0; k < n; k++) {
+                sum += (double)a[i * n + k] * b[k * n + j];
+            }
+            c[i * n + j] = (float)sum;
+        }
+    }
+}
+
+// Square sgemm sweep; sizes up to 256 are checked against the reference
+static void bench_gemm(rng_t* rng) {
+    static const uint32_t sizes[] = { 16, 32, 64, 96, 128, 192, 256, 384, 512 };
+    const gemm_blocking_t* blk = gemm_get_blocking();
+    
+    fprintf(stderr, "hostbench: sgemm blocking mc=%u kc=%u nc=%u\n", blk->mc, blk->kc, blk->nc);
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t n = sizes[s];
+        uint32_t bytes = n * n * sizeof(float);
+        float* a = (float*)kmalloc_aligned(bytes, 16);
+        float* b = (float*)kmalloc_aligned(bytes, 16);
+        float* c = (float*)kmalloc_aligned(bytes, 16);
+        float* ref = (float*)malloc(bytes);
+        if (!a || !b || !c || !ref) {
+            fail("out of memory for sgemm", n);
+            kfree(a);
+            kfree(b);
+            kfree(c);
+            free(ref);
+            continue;
+        }
+        random_fill_uniform(rng, a, n * n, -1.0f, 1.0f);
+        random_fill_uniform(rng, b, n * n, -1.0f, 1.0f);
+        
+        if (n <= 256) {
+            sgemm(0, 0, n, n, n, 1.0f, a, n, b, n, 0.0f, c, n);
+            gemm_reference(n, a, b, ref);
+            for (uint32_t i = 0; i < n * n; i++) {
+                float d = c[i] - ref[i];
+                if (d > 1e-3f * n || d < -1e-3f * n) {
+                    fail("sgemm result differs from the reference", n);
+                    break;
+                }
+            }
+        }
+        
+        uint32_t iters = 1;
+        uint64_t ns;
+        for (;;) {
+            uint64_t start = host_ns();
+            for (uint32_t i = 0; i < iters; i++) {
+                sgemm(0, 0, n, n, n, 1.0f, a, n, b, n, 0.0f, c, n);
+            }
+            ns = host_ns() - start;
+            if (ns >= HOST_MIN_NS) {
+                break;
+            }
+            iters *= 2;
+        }
+        
+        char name[32];
+        snprintf(name, sizeof(name), "host_sgemm_%u", n);
+        result(name, 2.0 * n * n * n * iters / ns, "GFLOP/s", iters, ns);
+        kfree(a);
+        kfree(b);
+        kfree(c);
+        free(ref);
+    }
+}
+
+static int usage(const char* prog) {
+    fprintf(stderr, "usage: %s [alloc|pmm|gemm|all] [-n ops] [-s seed] [-b mc,kc,nc]\n", prog);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    const char* suite = "all";
+    uint32_t ops = 1000000;
+    uint64_t seed = 1;
+    uint32_t mc = 0, kc = 0, nc = 0;
+    rng_t rng;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            ops = (uint32_t)strtoul(argv[++i], 0, 0);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = strtoull(argv[++i], 0, 0);
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u,%u,%u", &mc, &kc, &nc) != 3) {
+                return usage(argv[0]);
+            }
+        } else if (argv[i][0] != '-') {
+            suite = argv[i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    
+    int all = !strcmp(suite, "all");
+    if (!all && strcmp(suite, "alloc") && strcmp(suite, "pmm") && strcmp(suite, "gemm")) {
+        return usage(argv[0]);
+    }
+    
+    if (!host_memory_init()) {
+        fprintf(stderr, "hostbench: cannot map fake physical memory at 0x%x\n", HOST_MEM_BASE);
+        return 2;
+    }
+    if (mc && !gemm_set_blocking(mc, kc, nc)) {
+        fprintf(stderr, "hostbench: cannot set blocking %u,%u,%u\n", mc, kc, nc);
+        return 2;
+    }
+    random_seed(&rng, seed);
+    
+    if (all || !strcmp(suite, "alloc")) {
+        bench_alloc(&rng, ops);
+    }
+    if (all || !strcmp(suite, "pmm")) {
+        bench_pmm(&rng, ops);
+    }
+    if (all || !strcmp(suite, "gemm")) {
+        bench_gemm(&rng);
+    }
+    return failures ? 1 : 0;
+}
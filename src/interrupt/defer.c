@@ -0,0 +1,97 @@
+#include "defer.h"
+#include "../cpu/spinlock.h"
+#include <stdint.h>
+
+// Bounded multi-producer ring: each slot carries a sequence number saying
+// whose turn it is. A producer owns slot 'pos' once seq == pos and it
+// wins the CAS on tail; it publishes with seq = pos + 1. The consumer
+// hands the slot back for the next lap with seq = pos + DEFER_RING_SIZE.
+typedef struct {
+    volatile uint32_t seq;
+    defer_fn_t fn;
+    void* arg;
+} defer_slot_t;
+
+static defer_slot_t ring[DEFER_RING_SIZE];
+static volatile uint32_t tail = 0;      // Next position to produce
+static volatile uint32_t head = 0;      // Next position to consume
+static volatile uint32_t dropped = 0;
+static uint8_t ring_ready = 0;
+
+// Only one CPU drains the ring at a time
+static spinlock_t consumer_lock = SPINLOCK_INIT;
+
+void defer_init(void) {
+    for (uint32_t i = 0; i < DEFER_RING_SIZE; i++) {
+        ring[i].seq = i;
+    }
+    ring_ready = 1;
+}
+
+int defer_queue(defer_fn_t fn, void* arg) {
+    if (!ring_ready) {
+        return 0;
+    }
+    
+    uint32_t pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    for (;;) {
+        defer_slot_t* slot = &ring[pos & (DEFER_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&tail, &pos, pos + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->fn = fn;
+                slot->arg = arg;
+                __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+                return 1;
+            }
+            // pos was reloaded by the failed CAS
+        } else if (diff < 0) {
+            __sync_fetch_and_add(&dropped, 1);
+            return 0;
+        } else {
+            pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void defer_run(void) {
+    if (!ring_ready || !spin_trylock(&consumer_lock)) {
+        return;
+    }
+    
+    for (;;) {
+        uint32_t pos = head;
+        defer_slot_t* slot = &ring[pos & (DEFER_RING_SIZE - 1)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+            break;      // Empty, or the producer has not published yet
+        }
+        defer_fn_t fn = slot->fn;
+        void* arg = slot->arg;
+        __atomic_store_n(&slot->seq, pos + DEFER_RING_SIZE, __ATOMIC_RELEASE);
+        head = pos + 1;
+        fn(arg);
+    }
+    
+    spin_unlock(&consumer_lock);
+}
+
+int defer_pending(void) {
+    return ring_ready && ring[head & (DEFER_RING_SIZE - 1)].seq == head + 1;
+}
+
+void defer_idle(void) {
+    defer_run();
+    
+    // sti only takes effect after the following hlt, so an interrupt that
+    // queues work after the check still wakes us
+    __asm__ volatile("cli");
+    if (defer_pending()) {
+        __asm__ volatile("sti");
+    } else {
+        __asm__ volatile("sti; hlt" ::: "memory");
+    }
+}
+
+uint32_t defer_dropped(void) {
+    return dropped;
+}
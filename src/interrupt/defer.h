@@ -0,0 +1,37 @@
+#ifndef DEFER_H
+#define DEFER_H
+
+#include <stdint.h>
+
+// Deferred work ("bottom halves"). Interrupt handlers queue small items
+// here instead of doing slow work (console output, etc.) themselves; the
+// items run later with interrupts enabled, from the idle loop or another
+// safe point that calls defer_run.
+
+#define DEFER_RING_SIZE 256     // Power of two
+
+typedef void (*defer_fn_t)(void* arg);
+
+// Set up the ring; call once before interrupts are enabled
+void defer_init(void);
+
+// Queue fn(arg). Lock-free and safe from any context, including
+// interrupt handlers on any CPU. Returns 0 if the ring is full (counted
+// as a drop) or not yet initialized.
+int defer_queue(defer_fn_t fn, void* arg);
+
+// Run queued items in FIFO order until the ring is empty. Call with
+// interrupts enabled. Re-entrant calls (from an item) return at once.
+void defer_run(void);
+
+// Non-zero if items are waiting
+int defer_pending(void);
+
+// Run pending items, then halt until the next interrupt unless more
+// work arrived meanwhile. Returns with interrupts enabled.
+void defer_idle(void);
+
+// Items lost because the ring was full
+uint32_t defer_dropped(void);
+
+#endif
@@ -59,6 +59,23 @@ void pic_send_eoi(uint8_t irq) {
     port_byte_out(PIC1_COMMAND, PIC_EOI);
 }
 
+// A PIC raises IRQ 7 (IRQ 15 on the slave) when a request goes away
+// before it is acknowledged. A spurious one has no in-service bit and
+// must not get an EOI from the PIC that raised it, or a real interrupt
+// in service would be ended early. For a spurious IRQ 15 the master did
+// see a real request on its cascade line, so it still gets its EOI.
+int pic_spurious(uint8_t irq) {
+    uint16_t port = irq < 8 ? PIC1_COMMAND : PIC2_COMMAND;
+    port_byte_out(port, PIC_READ_ISR);
+    if (port_byte_in(port) & 0x80) {
+        return 0;
+    }
+    if (irq >= 8) {
+        port_byte_out(PIC1_COMMAND, PIC_EOI);
+    }
+    return 1;
+}
+
 // Disable (mask) an IRQ line
 void irq_set_mask(uint8_t irq) {
     uint16_t port;
@@ -111,3 +128,7 @@ void idt_init(void) {
     // Load the IDT
     idt_flush((uint32_t)&idt_ptr);
 }
+
+void idt_load(void) {
+    idt_flush((uint32_t)&idt_ptr);
+}
@@ -38,6 +38,7 @@ typedef struct {
 #define PIC2_COMMAND    0xA0
 #define PIC2_DATA       0xA1
 #define PIC_EOI         0x20    // End of Interrupt command
+#define PIC_READ_ISR    0x0B    // OCW3: next command port read returns the ISR
 
 // IRQ numbers (remapped to interrupts 32-47)
 #define IRQ0  32    // Programmable Interval Timer
@@ -57,11 +58,16 @@ typedef struct {
 #define IRQ14 46    // Primary ATA Hard Disk
 #define IRQ15 47    // Secondary ATA Hard Disk
 
+// Local APIC vectors (acknowledged with lapic_eoi, not the PIC)
+#define IRQ_LAPIC_TIMER 48
+
 // Function prototypes
 void idt_init(void);
+void idt_load(void);     // Load the shared IDT on another CPU
 void idt_set_gate(uint8_t num, uint32_t base, uint16_t selector, uint8_t flags);
 void pic_remap(void);
 void pic_send_eoi(uint8_t irq);
+int pic_spurious(uint8_t irq);      // IRQ 7 or 15 only; see idt.c
 void irq_set_mask(uint8_t irq);
 void irq_clear_mask(uint8_t irq);
 
@@ -7,65 +7,58 @@
 extern isr_handler
 extern irq_handler
 
-; Common ISR stub - saves processor state, calls C handler, restores state
-; This is called by all ISR stubs
-isr_common_stub:
-    ; Save all registers
+; Common entry for all ISR and IRQ stubs: save the processor state, call
+; the C handler with a pointer to it (registers_t), restore and return.
+; Interrupt gates already clear IF and iret restores EFLAGS, so there is
+; no cli/sti. The kernel runs in ring 0 on flat segments, so the data
+; segments only need switching (and switching back) when the interrupted
+; code ran at another privilege level.
+%macro COMMON_STUB 2
+%1:
     pusha                   ; Pushes edi, esi, ebp, esp, ebx, edx, ecx, eax
-    
-    mov ax, ds              ; Lower 16-bits of eax = ds
+    mov eax, ds
     push eax                ; Save the data segment descriptor
+    test byte [esp + 48], 3 ; RPL of the interrupted CS
+    jnz %%other_ring
     
-    mov ax, 0x10            ; Load the kernel data segment descriptor
-    mov ds, ax
-    mov es, ax
-    mov fs, ax
-    mov gs, ax
+%%dispatch:
+    push esp                ; registers_t* for the C handler
+    call %2
+    add esp, 4
+    test byte [esp + 48], 3
+    jnz %%restore
     
-    call isr_handler        ; Call C handler
+    add esp, 4              ; Skip the saved data segment
+    popa                    ; Restore registers
+    add esp, 8              ; Clean up pushed error code and ISR number
+    iret                    ; Return from interrupt (pops CS, EIP, EFLAGS, SS, ESP)
     
-    pop eax                 ; Restore the original data segment descriptor
+%%other_ring:
+    mov ax, 0x10            ; Load the kernel data segment descriptor
     mov ds, ax
     mov es, ax
     mov fs, ax
     mov gs, ax
+    jmp %%dispatch
     
-    popa                    ; Restore registers
-    add esp, 8              ; Clean up pushed error code and ISR number
-    sti                     ; Re-enable interrupts
-    iret                    ; Return from interrupt (pops CS, EIP, EFLAGS, SS, ESP)
-
-; Common IRQ stub - similar to ISR but calls irq_handler
-irq_common_stub:
-    pusha
-    
-    mov ax, ds
-    push eax
-    
-    mov ax, 0x10
+%%restore:
+    pop eax                 ; Restore the original data segment descriptor
     mov ds, ax
     mov es, ax
     mov fs, ax
     mov gs, ax
-    
-    call irq_handler        ; Call C IRQ handler
-    
-    pop ebx
-    mov ds, bx
-    mov es, bx
-    mov fs, bx
-    mov gs, bx
-    
     popa
     add esp, 8
-    sti
     iret
+%endmacro
+
+COMMON_STUB isr_common_stub, isr_handler
+COMMON_STUB irq_common_stub, irq_handler
 
 ; Macro to create ISR stubs without error codes
 %macro ISR_NOERRCODE 1
 global isr%1
 isr%1:
-    cli                     ; Disable interrupts
     push 0                  ; Push dummy error code
     push %1                 ; Push interrupt number
     jmp isr_common_stub
@@ -75,7 +68,6 @@ isr%1:
 %macro ISR_ERRCODE 1
 global isr%1
 isr%1:
-    cli
     push %1                 ; Push interrupt number (error code already pushed by CPU)
     jmp isr_common_stub
 %endmacro
@@ -84,7 +76,6 @@ isr%1:
 %macro IRQ 2
 global irq%1
 irq%1:
-    cli
     push 0                  ; Push dummy error code
     push %2                 ; Push interrupt number (32 + IRQ number)
     jmp irq_common_stub
@@ -142,6 +133,14 @@ IRQ 13, 45      ; FPU / Coprocessor
 IRQ 14, 46      ; Primary ATA Hard Disk
 IRQ 15, 47      ; Secondary ATA Hard Disk
 
+; Local APIC interrupts (vectors above the PIC range)
+IRQ 16, 48      ; Local APIC timer
+
+; Local APIC spurious interrupt: no EOI, nothing to do
+global isr_spurious
+isr_spurious:
+    iret
+
 ; Assembly function to load IDT
 global idt_flush
 idt_flush:
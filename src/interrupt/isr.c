@@ -1,11 +1,22 @@
 #include "isr.h"
 #include "idt.h"
-#include "../drivers/screen.h"
+#include "../cpu/cpu.h"
+#include "../cpu/lapic.h"
+#include "../drivers/clock.h"
+#include "../kernel/trace.h"
+#include "../libc/printf.h"
+#include "../libc/string.h"
+#include "../math/math.h"
 #include <stdint.h>
+#include <stddef.h>
 
 // Array of interrupt handler function pointers
 static interrupt_handler_t interrupt_handlers[256] = {0};
 
+// Hardware interrupts only reach the BSP, with interrupts disabled, so
+// the counters need no locking
+static irq_stats_t irq_stats[IRQ_STAT_VECTORS];
+
 // Exception messages
 static const char* exception_messages[] = {
     "Division By Zero",
@@ -42,43 +53,6 @@ static const char* exception_messages[] = {
     "Reserved"
 };
 
-// Helper function to convert int to hex string
-static void int_to_hex(uint32_t num, char* str) {
-    str[0] = '0';
-    str[1] = 'x';
-    
-    for (int i = 9; i >= 2; i--) {
-        uint8_t digit = num & 0xF;
-        str[i] = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
-        num >>= 4;
-    }
-    str[10] = '\0';
-}
-
-// Helper function to convert int to decimal string
-static void int_to_dec(uint32_t num, char* str) {
-    int i = 0;
-    
-    if (num == 0) {
-        str[0] = '0';
-        str[1] = '\0';
-        return;
-    }
-    
-    while (num > 0) {
-        str[i++] = '0' + (num % 10);
-        num /= 10;
-    }
-    str[i] = '\0';
-    
-    // Reverse string
-    for (int j = 0; j < i / 2; j++) {
-        char temp = str[j];
-        str[j] = str[i - j - 1];
-        str[i - j - 1] = temp;
-    }
-}
-
 // Register a custom interrupt handler
 void register_interrupt_handler(uint8_t n, interrupt_handler_t handler) {
     interrupt_handlers[n] = handler;
@@ -86,69 +60,26 @@ void register_interrupt_handler(uint8_t n, interrupt_handler_t handler) {
 
 // Main ISR handler (called from assembly stub)
 void isr_handler(registers_t* regs) {
-    char buffer[32];
-    
     // Check if we have a custom handler for this interrupt
     if (interrupt_handlers[regs->int_no] != 0) {
         interrupt_handler_t handler = interrupt_handlers[regs->int_no];
+        TRACE_SCOPE(TRACE_EV_EXCEPTION, regs->int_no);
         handler(regs);
     } else {
-        // No custom handler - this is a CPU exception, halt the system
-        kprint("\n!!! EXCEPTION: ");
-        kprint(exception_messages[regs->int_no]);
-        kprint(" !!!\n");
-        
-        kprint("Interrupt Number: ");
-        int_to_dec(regs->int_no, buffer);
-        kprint(buffer);
-        kprint("\n");
-        
-        kprint("Error Code: ");
-        int_to_hex(regs->err_code, buffer);
-        kprint(buffer);
-        kprint("\n");
-        
-        kprint("\nRegisters:\n");
-        kprint("EAX=");
-        int_to_hex(regs->eax, buffer);
-        kprint(buffer);
-        kprint(" EBX=");
-        int_to_hex(regs->ebx, buffer);
-        kprint(buffer);
-        kprint(" ECX=");
-        int_to_hex(regs->ecx, buffer);
-        kprint(buffer);
-        kprint(" EDX=");
-        int_to_hex(regs->edx, buffer);
-        kprint(buffer);
-        kprint("\n");
-        
-        kprint("ESI=");
-        int_to_hex(regs->esi, buffer);
-        kprint(buffer);
-        kprint(" EDI=");
-        int_to_hex(regs->edi, buffer);
-        kprint(buffer);
-        kprint(" EBP=");
-        int_to_hex(regs->ebp, buffer);
-        kprint(buffer);
-        kprint(" ESP=");
-        int_to_hex(regs->esp, buffer);
-        kprint(buffer);
-        kprint("\n");
-        
-        kprint("EIP=");
-        int_to_hex(regs->eip, buffer);
-        kprint(buffer);
-        kprint(" CS=");
-        int_to_hex(regs->cs, buffer);
-        kprint(buffer);
-        kprint(" EFLAGS=");
-        int_to_hex(regs->eflags, buffer);
-        kprint(buffer);
-        kprint("\n");
-        
-        kprint("\nSystem Halted.\n");
+        // No custom handler - this is a CPU exception, halt the system.
+        // The dump goes out in one console write.
+        kprintf("\n!!! EXCEPTION: %s !!!\n"
+                "Interrupt Number: %u\n"
+                "Error Code: 0x%08X\n"
+                "\nRegisters:\n"
+                "EAX=0x%08X EBX=0x%08X ECX=0x%08X EDX=0x%08X\n"
+                "ESI=0x%08X EDI=0x%08X EBP=0x%08X ESP=0x%08X\n"
+                "EIP=0x%08X CS=0x%08X EFLAGS=0x%08X\n"
+                "\nSystem Halted.\n",
+                exception_messages[regs->int_no], regs->int_no, regs->err_code,
+                regs->eax, regs->ebx, regs->ecx, regs->edx,
+                regs->esi, regs->edi, regs->ebp, regs->esp,
+                regs->eip, regs->cs, regs->eflags);
         
         // Halt the system
         for (;;) {
@@ -157,16 +88,111 @@ void isr_handler(registers_t* regs) {
     }
 }
 
+static void irq_account(irq_stats_t* stats, uint64_t elapsed) {
+    uint32_t cycles = elapsed > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)elapsed;
+    uint32_t bucket = 0;
+    
+    stats->count++;
+    stats->cycles += cycles;
+    if (cycles > stats->max_cycles) {
+        stats->max_cycles = cycles;
+    }
+    if (cycles >> (IRQ_HIST_SHIFT + 1)) {
+        bucket = 31 - __builtin_clz(cycles) - IRQ_HIST_SHIFT;
+        if (bucket >= IRQ_HIST_BUCKETS) {
+            bucket = IRQ_HIST_BUCKETS - 1;
+        }
+    }
+    stats->hist[bucket]++;
+}
+
 // Main IRQ handler (called from assembly stub)
 void irq_handler(registers_t* regs) {
-    // Send End of Interrupt signal to PIC
-    pic_send_eoi(regs->int_no - 32);
+    uint32_t vector = regs->int_no;
+    irq_stats_t* stats = &irq_stats[vector - IRQ0];
+    TRACE_SCOPE(TRACE_EV_IRQ, vector);
     
-    // Check if we have a custom handler for this IRQ
-    if (interrupt_handlers[regs->int_no] != 0) {
-        interrupt_handler_t handler = interrupt_handlers[regs->int_no];
+    // A spurious IRQ 7/15 gets no handler and no EOI from its PIC
+    if ((vector == IRQ7 || vector == IRQ15) && pic_spurious(vector - IRQ0)) {
+        stats->spurious++;
+        return;
+    }
+    
+    uint64_t start = rdtsc();
+    interrupt_handler_t handler = interrupt_handlers[vector];
+    if (handler) {
         handler(regs);
     }
+    
+    // End of Interrupt once the handler is done, so the line stays in
+    // service meanwhile. Threads never switch inside a handler, so every
+    // handler returns here.
+    if (vector >= IRQ_LAPIC_TIMER) {
+        lapic_eoi();
+    } else {
+        pic_send_eoi(vector - IRQ0);
+    }
+    irq_account(stats, rdtsc() - start);
+}
+
+const irq_stats_t* irq_get_stats(uint8_t vector) {
+    if (vector < IRQ0 || vector > IRQ_LAPIC_TIMER) {
+        return NULL;
+    }
+    return &irq_stats[vector - IRQ0];
+}
+
+void irq_stats_reset(void) {
+    uint32_t flags = cpu_irq_save();
+    memset(irq_stats, 0, sizeof(irq_stats));
+    cpu_irq_restore(flags);
+}
+
+void irq_stats_dump(void) {
+    irq_stats_t copy[IRQ_STAT_VECTORS];
+    uint32_t shown = 0;
+    
+    // Snapshot so each line is consistent
+    uint32_t flags = cpu_irq_save();
+    memcpy(copy, irq_stats, sizeof(copy));
+    cpu_irq_restore(flags);
+    
+    kprintf("Interrupts (TSC at %u kHz, cycles from dispatch to EOI)\n", clock_tsc_khz());
+    kprintf("%-8s%-10s%-10s%-10s%-10s%-10s\n",
+            "vector", "count", "spurious", "avg_cyc", "max_cyc", "avg_ns");
+    for (uint32_t i = 0; i < IRQ_STAT_VECTORS; i++) {
+        const irq_stats_t* stats = &copy[i];
+        if (!stats->count && !stats->spurious) {
+            continue;
+        }
+        uint32_t avg = stats->count ? (uint32_t)k_udiv64(stats->cycles, stats->count) : 0;
+        kprintf("%-8u%-10u%-10u%-10u%-10u%-10llu\n", i + IRQ0, stats->count, stats->spurious,
+                avg, stats->max_cycles, clock_tsc_to_ns(avg));
+        
+        // Histogram: "<bound:count" per non-empty bucket
+        char line[KPRINTF_BUFFER_SIZE];
+        int len = ksnprintf(line, sizeof(line), "  ");
+        for (uint32_t b = 0; b < IRQ_HIST_BUCKETS; b++) {
+            if (!stats->hist[b]) {
+                continue;
+            }
+            uint32_t bound = 1u << (IRQ_HIST_SHIFT + 1 + b);
+            if (b == IRQ_HIST_BUCKETS - 1) {
+                len += ksnprintf(line + len, sizeof(line) - len, " >=%uK:%u",
+                                 (bound >> 1) >> 10, stats->hist[b]);
+            } else if (bound >= 1024) {
+                len += ksnprintf(line + len, sizeof(line) - len, " <%uK:%u",
+                                 bound >> 10, stats->hist[b]);
+            } else {
+                len += ksnprintf(line + len, sizeof(line) - len, " <%u:%u", bound, stats->hist[b]);
+            }
+        }
+        kprintf("%s\n", line);
+        shown++;
+    }
+    if (!shown) {
+        kprintf("  no interrupts recorded\n");
+    }
 }
 
 // Install all ISRs and IRQs into the IDT
@@ -222,4 +248,8 @@ void isr_install(void) {
     idt_set_gate(45, (uint32_t)irq13, KERNEL_CS, IDT_GATE_KERNEL);
     idt_set_gate(46, (uint32_t)irq14, KERNEL_CS, IDT_GATE_KERNEL);
     idt_set_gate(47, (uint32_t)irq15, KERNEL_CS, IDT_GATE_KERNEL);
+    idt_set_gate(IRQ_LAPIC_TIMER, (uint32_t)irq16, KERNEL_CS, IDT_GATE_KERNEL);
+    
+    // Spurious interrupts from the local APIC need no EOI or handler
+    idt_set_gate(255, (uint32_t)isr_spurious, KERNEL_CS, IDT_GATE_KERNEL);
 }
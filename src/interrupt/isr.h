@@ -1,6 +1,7 @@
 #ifndef ISR_H
 #define ISR_H
 
+#include "idt.h"
 #include <stdint.h>
 
 // CPU register state structure
@@ -15,6 +16,22 @@ typedef struct {
 // Interrupt handler function type
 typedef void (*interrupt_handler_t)(registers_t*);
 
+// Per-vector statistics for hardware interrupts (PIC IRQs and the LAPIC
+// timer). A run is timed in TSC cycles from dispatch to EOI; it lands in
+// histogram bucket log2(cycles) - IRQ_HIST_SHIFT, so bucket 0 holds
+// everything under 2^(IRQ_HIST_SHIFT + 1) and the last bucket is open.
+#define IRQ_STAT_VECTORS (IRQ_LAPIC_TIMER - IRQ0 + 1)
+#define IRQ_HIST_BUCKETS 12
+#define IRQ_HIST_SHIFT 8
+
+typedef struct {
+    uint32_t count;
+    uint32_t spurious;          // IRQ 7/15 with nothing in service
+    uint64_t cycles;
+    uint32_t max_cycles;
+    uint32_t hist[IRQ_HIST_BUCKETS];
+} irq_stats_t;
+
 // External ASM ISR handlers (CPU exceptions 0-31)
 extern void isr0(void);
 extern void isr1(void);
@@ -67,6 +84,12 @@ extern void irq13(void);
 extern void irq14(void);
 extern void irq15(void);
 
+// Local APIC timer (vector 48)
+extern void irq16(void);
+
+// Local APIC spurious interrupt (vector 0xFF)
+extern void isr_spurious(void);
+
 // Function prototypes
 void isr_install(void);
 void register_interrupt_handler(uint8_t n, interrupt_handler_t handler);
@@ -75,4 +98,12 @@ void register_interrupt_handler(uint8_t n, interrupt_handler_t handler);
 void isr_handler(registers_t* regs);
 void irq_handler(registers_t* regs);
 
+// Statistics for one vector (IRQ0 to IRQ_LAPIC_TIMER), else NULL
+const irq_stats_t* irq_get_stats(uint8_t vector);
+void irq_stats_reset(void);
+
+// Print a line per vector that has fired: counts, mean and worst cycles,
+// and the histogram. Slow: call outside interrupts.
+void irq_stats_dump(void);
+
 #endif
@@ -0,0 +1,367 @@
+#include "bench.h"
+#include "../cpu/cpu.h"
+#include "../cpu/smp.h"
+#include "../drivers/block.h"
+#include "../drivers/clock.h"
+#include "../drivers/ports.h"
+#include "../drivers/screen.h"
+#include "../drivers/serial.h"
+#include "../libc/printf.h"
+#include "../libc/string.h"
+#include "../math/gemm.h"
+#include "../math/random.h"
+#include "../memory/memory.h"
+#include "../nn/activation.h"
+#include "../nn/mlp.h"
+#include "../nn/optimizer.h"
+#include "../nn/train.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define BENCH_SEED 0x5EED
+
+// Benchmark body: run the measured operation 'iters' times
+typedef void (*bench_fn_t)(void* ctx, uint32_t iters);
+
+typedef struct {
+    uint32_t iters;
+    uint64_t ns;
+} bench_result_t;
+
+// Run once to warm caches, then double the iterations until a run takes
+// BENCH_MIN_NS
+static bench_result_t bench_time(bench_fn_t fn, void* ctx, uint32_t iters) {
+    bench_result_t r;
+    
+    fn(ctx, 1);
+    for (;;) {
+        uint64_t start = rdtsc();
+        fn(ctx, iters);
+        r.ns = clock_tsc_to_ns(rdtsc() - start);
+        r.iters = iters;
+        if (r.ns >= BENCH_MIN_NS || iters >= BENCH_MAX_ITERS) {
+            return r;
+        }
+        iters *= 2;
+    }
+}
+
+static void bench_line(const char* name, double value, const char* unit, uint32_t iters, uint64_t ns) {
+    kprintf("BENCH {\"name\":\"%s\",\"value\":%.3f,\"unit\":\"%s\",\"iters\":%u,\"ns\":%llu}\n",
+            name, value, unit, iters, ns);
+}
+
+static double ns_of(const bench_result_t* r) {
+    return r->ns ? (double)(int64_t)r->ns : 1.0;
+}
+
+// Nanoseconds per iteration
+static void report_ns(const char* name, const bench_result_t* r) {
+    bench_line(name, ns_of(r) / r->iters, "ns/op", r->iters, r->ns);
+}
+
+// 'units' per second, scaled down by 'scale'
+static void report_rate(const char* name, const bench_result_t* r, double units, double scale,
+                        const char* unit) {
+    bench_line(name, units * r->iters / scale / (ns_of(r) * 1e-9), unit, r->iters, r->ns);
+}
+
+// PMM: one page allocated and freed
+static void bench_pmm(void* ctx, uint32_t iters) {
+    (void)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        pmm_free_page(pmm_alloc_page());
+    }
+}
+
+// Heap churn: a ring of live blocks of mixed sizes, each step frees the
+// oldest and allocates a new one
+#define CHURN_SLOTS 64
+#define CHURN_SIZES 256
+
+typedef struct {
+    void* slots[CHURN_SLOTS];
+    uint32_t sizes[CHURN_SIZES];
+    uint32_t next;
+} churn_t;
+
+static void bench_kmalloc(void* ctx, uint32_t iters) {
+    churn_t* c = (churn_t*)ctx;
+    for (uint32_t i = 0; i < iters; i++, c->next++) {
+        uint32_t slot = c->next % CHURN_SLOTS;
+        kfree(c->slots[slot]);
+        c->slots[slot] = kmalloc(c->sizes[c->next % CHURN_SIZES]);
+    }
+}
+
+typedef struct {
+    uint8_t* dst;
+    const uint8_t* src;
+    uint32_t size;
+} copy_t;
+
+static void bench_memcpy(void* ctx, uint32_t iters) {
+    copy_t* c = (copy_t*)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        memcpy(c->dst, c->src, c->size);
+    }
+}
+
+// One full 80-column row through the screen driver; it wraps after the
+// last column, so each op is exactly one scroll
+static void bench_vga(void* ctx, uint32_t iters) {
+    const char* line = (const char*)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        screen_write(line);
+    }
+}
+
+typedef struct {
+    float* a;
+    float* b;
+    float* c;
+    uint32_t n;
+} gemm_ctx_t;
+
+static void bench_sgemm(void* ctx, uint32_t iters) {
+    gemm_ctx_t* g = (gemm_ctx_t*)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        sgemm(0, 0, g->n, g->n, g->n, 1.0f, g->a, g->n, g->b, g->n, 0.0f, g->c, g->n);
+    }
+}
+
+typedef struct {
+    float* x;
+    float* y;
+    uint32_t n;
+} vec_ctx_t;
+
+static void bench_relu(void* ctx, uint32_t iters) {
+    vec_ctx_t* v = (vec_ctx_t*)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        relu_forward(v->x, v->n);
+    }
+}
+
+static void bench_softmax(void* ctx, uint32_t iters) {
+    vec_ctx_t* v = (vec_ctx_t*)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        softmax(v->x, v->y, v->n);
+    }
+}
+
+#define DISK_CHUNK_SECTORS 128      // 64KB per read
+
+typedef struct {
+    block_device_t* dev;
+    void* buf;
+    uint32_t lba;
+    uint32_t failed;
+} disk_ctx_t;
+
+// Sequential reads, wrapping at the end of the disk
+static void bench_disk(void* ctx, uint32_t iters) {
+    disk_ctx_t* d = (disk_ctx_t*)ctx;
+    for (uint32_t i = 0; i < iters; i++) {
+        if (d->lba + DISK_CHUNK_SECTORS > d->dev->sector_count) {
+            d->lba = 0;
+        }
+        d->failed += !block_read(d->dev, d->lba, DISK_CHUNK_SECTORS, d->buf);
+        d->lba += DISK_CHUNK_SECTORS;
+    }
+}
+
+#define TRAIN_IMAGES 2048
+#define TRAIN_BATCH 64
+
+typedef struct {
+    trainer_t* trainer;
+    optimizer_t* opt;
+    mnist_set_t set;
+    rng_t* rng;
+} train_ctx_t;
+
+static void bench_train(void* ctx, uint32_t iters) {
+    train_ctx_t* t = (train_ctx_t*)ctx;
+    trainer_train(t->trainer, t->opt, &t->set, TRAIN_BATCH, iters, t->rng, 0);
+}
+
+static uint32_t run_memory(rng_t* rng) {
+    static const uint32_t copy_sizes[] = { 64, 4096, 65536, 1024 * 1024 };
+    static const char* copy_names[] = { "memcpy_64", "memcpy_4k", "memcpy_64k", "memcpy_1m" };
+    static churn_t churn;
+    bench_result_t r;
+    uint32_t failed = 0;
+    
+    r = bench_time(bench_pmm, 0, 1024);
+    report_ns("pmm_page", &r);
+    
+    for (uint32_t i = 0; i < CHURN_SIZES; i++) {
+        churn.sizes[i] = 16 + random_range(rng, 4096);
+    }
+    r = bench_time(bench_kmalloc, &churn, 1024);
+    report_ns("kmalloc_churn", &r);
+    for (uint32_t i = 0; i < CHURN_SLOTS; i++) {
+        kfree(churn.slots[i]);
+        churn.slots[i] = 0;
+    }
+    
+    copy_t copy;
+    copy.dst = (uint8_t*)kmalloc_aligned(copy_sizes[3], 64);
+    copy.src = (const uint8_t*)kmalloc_aligned(copy_sizes[3], 64);
+    if (!copy.dst || !copy.src) {
+        failed += 4;
+    } else {
+        memset((void*)copy.src, 0x5A, copy_sizes[3]);
+        for (uint32_t i = 0; i < 4; i++) {
+            copy.size = copy_sizes[i];
+            r = bench_time(bench_memcpy, &copy, 64);
+            report_rate(copy_names[i], &r, copy.size, 1024.0 * 1024.0, "MB/s");
+        }
+    }
+    kfree(copy.dst);
+    kfree((void*)copy.src);
+    return failed;
+}
+
+static uint32_t run_math(rng_t* rng) {
+    static const uint32_t sizes[] = { 64, 128, 256 };
+    static const char* names[] = { "sgemm_64", "sgemm_128", "sgemm_256" };
+    bench_result_t r;
+    uint32_t failed = 0;
+    
+    for (uint32_t i = 0; i < 3; i++) {
+        gemm_ctx_t g;
+        uint32_t bytes = sizes[i] * sizes[i] * sizeof(float);
+        g.n = sizes[i];
+        g.a = (float*)kmalloc_aligned(bytes, 16);
+        g.b = (float*)kmalloc_aligned(bytes, 16);
+        g.c = (float*)kmalloc_aligned(bytes, 16);
+        if (g.a && g.b && g.c) {
+            random_fill_uniform(rng, g.a, g.n * g.n, -1.0f, 1.0f);
+            random_fill_uniform(rng, g.b, g.n * g.n, -1.0f, 1.0f);
+            r = bench_time(bench_sgemm, &g, 1);
+            report_rate(names[i], &r, 2.0 * g.n * g.n * g.n, 1e9, "GFLOP/s");
+        } else {
+            failed++;
+        }
+        kfree(g.a);
+        kfree(g.b);
+        kfree(g.c);
+    }
+    
+    // ReLU at a hidden layer's width; softmax over the output logits
+    vec_ctx_t v;
+    v.n = 4096;
+    v.x = (float*)kmalloc_aligned(v.n * sizeof(float), 16);
+    v.y = (float*)kmalloc_aligned(v.n * sizeof(float), 16);
+    if (v.x && v.y) {
+        random_fill_uniform(rng, v.x, v.n, -1.0f, 1.0f);
+        r = bench_time(bench_relu, &v, 256);
+        report_ns("relu_4096", &r);
+        v.n = MNIST_CLASSES;
+        r = bench_time(bench_softmax, &v, 4096);
+        report_ns("softmax_10", &r);
+    } else {
+        failed += 2;
+    }
+    kfree(v.x);
+    kfree(v.y);
+    return failed;
+}
+
+static uint32_t run_disk(void) {
+    disk_ctx_t d;
+    bench_result_t r;
+    
+    d.dev = block_get(0);
+    d.buf = kmalloc_aligned(DISK_CHUNK_SECTORS * BLOCK_SECTOR_SIZE, 16);
+    d.lba = 0;
+    d.failed = 0;
+    if (!d.dev || !d.buf || d.dev->sector_count < DISK_CHUNK_SECTORS) {
+        kfree(d.buf);
+        return 1;
+    }
+    r = bench_time(bench_disk, &d, 16);
+    kfree(d.buf);
+    if (d.failed) {
+        return 1;
+    }
+    report_rate("disk_read", &r, DISK_CHUNK_SECTORS * BLOCK_SECTOR_SIZE, 1024.0 * 1024.0, "MB/s");
+    return 0;
+}
+
+// Train the default 784-128-10 MLP on synthetic images about as sparse
+// as MNIST digits (roughly a fifth of the pixels lit)
+static uint32_t run_train(rng_t* rng) {
+    static const uint32_t layers[] = { MNIST_PIXELS, 128, MNIST_CLASSES };
+    train_ctx_t t;
+    bench_result_t r;
+    uint32_t failed = 0;
+    
+    uint8_t* images = (uint8_t*)kmalloc(TRAIN_IMAGES * MNIST_PIXELS);
+    uint8_t* labels = (uint8_t*)kmalloc(TRAIN_IMAGES);
+    mlp_t* model = mlp_create(layers, 3);
+    t.trainer = model ? trainer_create(model) : 0;
+    t.opt = model ? optimizer_create_sgd(model->num_params, 0.01f, 0.9f) : 0;
+    if (images && labels && t.trainer && t.opt) {
+        for (uint32_t i = 0; i < TRAIN_IMAGES * MNIST_PIXELS; i++) {
+            images[i] = random_range(rng, 5) ? 0 : (uint8_t)(64 + random_range(rng, 192));
+        }
+        for (uint32_t i = 0; i < TRAIN_IMAGES; i++) {
+            labels[i] = (uint8_t)random_range(rng, MNIST_CLASSES);
+        }
+        t.set.count = TRAIN_IMAGES;
+        t.set.images = images;
+        t.set.labels = labels;
+        t.rng = rng;
+        mlp_init_weights(model, rng);
+        
+        r = bench_time(bench_train, &t, 4);
+        report_rate("train_mlp", &r, TRAIN_BATCH, 1.0, "images/s");
+    } else {
+        failed = 1;
+    }
+    optimizer_destroy(t.opt);
+    trainer_destroy(t.trainer);
+    mlp_destroy(model);
+    kfree(images);
+    kfree(labels);
+    return failed;
+}
+
+uint32_t bench_run(void) {
+    static const char line[] =
+        "0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ01234567";
+    rng_t rng;
+    bench_result_t r;
+    uint32_t failed = 0;
+    
+    random_seed(&rng, BENCH_SEED);
+    bench_line("cpus", smp_cpu_count(), "count", 1, 0);
+    bench_line("tsc", clock_tsc_khz(), "kHz", 1, 0);
+    
+    failed += run_memory(&rng);
+    
+    r = bench_time(bench_vga, (void*)line, 64);
+    report_ns("vga_line", &r);
+    
+    failed += run_math(&rng);
+    failed += run_disk();
+    failed += run_train(&rng);
+    
+    kprintf("BENCH {\"name\":\"done\",\"value\":%u,\"unit\":\"failed\",\"iters\":1,\"ns\":0}\n",
+            failed);
+    return failed;
+}
+
+void bench_exit(uint32_t code) {
+    serial_flush();
+    port_byte_out(BENCH_EXIT_PORT, (uint8_t)code);
+    
+    // Still here: not QEMU, or no isa-debug-exit device
+    __asm__ volatile("cli");
+    for (;;) {
+        __asm__ volatile("hlt");
+    }
+}
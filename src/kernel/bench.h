@@ -0,0 +1,31 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+// Fixed benchmark suite, run at boot by a kernel built with BENCH=1
+// ('make bench'). Each result is one console line, mirrored to COM1:
+//
+//   BENCH {"name":"memcpy_64k","value":5120.000,"unit":"MB/s","iters":4096,"ns":52428800}
+//
+// value is derived from iters runs taking ns in total. Numbers are only
+// comparable between runs on the same host and QEMU settings.
+
+#define BENCH_MIN_NS 100000000ULL       // Each benchmark runs at least 100ms
+#define BENCH_MAX_ITERS (1u << 24)
+
+// QEMU -device isa-debug-exit,iobase=0xf4: the VM exits with status
+// (code << 1) | 1, so a clean run ends with status 1
+#define BENCH_EXIT_PORT 0xF4
+#define BENCH_EXIT_OK 0
+#define BENCH_EXIT_FAILED 1
+
+// Run the suite after thread_init. Returns the number of benchmarks that
+// could not run (no disk, allocation failure).
+uint32_t bench_run(void);
+
+// Flush the serial port and leave QEMU. Halts where there is no
+// isa-debug-exit device.
+void bench_exit(uint32_t code);
+
+#endif
@@ -0,0 +1,23 @@
+[bits 32]
+
+; void context_switch(uint32_t* save_esp, uint32_t new_esp)
+; Save the callee-saved registers on the current stack, store its esp,
+; then resume the other thread from the frame on its stack. New threads
+; get a prepared frame whose return address is their start routine.
+global context_switch
+context_switch:
+    mov eax, [esp + 4]      ; Where to save the outgoing esp
+    mov edx, [esp + 8]      ; Incoming thread's saved esp
+    
+    push ebp
+    push ebx
+    push esi
+    push edi
+    mov [eax], esp
+    
+    mov esp, edx
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
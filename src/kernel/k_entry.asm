@@ -1,7 +1,17 @@
 [bits 32]
 [extern kmain]
+[extern _bss_start]
+[extern _kernel_end]
 
 global _start
 _start:
+    ; The boot sector only loads the file-backed sections, so zero .bss here
+    mov edi, _bss_start
+    mov ecx, _kernel_end
+    sub ecx, edi
+    xor eax, eax
+    cld
+    rep stosb
+
     call kmain          ; Call the C function
     jmp $               ; Infinite loop if C returns
@@ -1,59 +1,99 @@
 #include "../drivers/screen.h"
 #include "../drivers/timer.h"
 #include "../drivers/keyboard.h"
+#include "../drivers/ata.h"
+#include "../drivers/block.h"
+#include "../drivers/console.h"
+#include "../drivers/serial.h"
 #include "../memory/memory.h"
 #include "../interrupt/idt.h"
+#include "../interrupt/isr.h"
+#include "../interrupt/defer.h"
+#include "../cpu/cpu.h"
+#include "../cpu/smp.h"
+#include "thread.h"
+#include "prof.h"
+#include "sample.h"
+#include "trace.h"
+#include "bench.h"
+#include "../math/random.h"
+#include "../math/tune.h"
+#include "../nn/checkpoint.h"
+#include "../libc/string.h"
+#include <stddef.h>
 
-// Helper function to convert int to string
-static void int_to_str(int num, char* str) {
-    int i = 0;
-    int is_negative = 0;
-    
-    if (num == 0) {
-        str[0] = '0';
-        str[1] = '\0';
-        return;
-    }
-    
-    if (num < 0) {
-        is_negative = 1;
-        num = -num;
-    }
-    
-    while (num > 0) {
-        str[i++] = '0' + (num % 10);
-        num /= 10;
-    }
-    
-    if (is_negative) {
-        str[i++] = '-';
-    }
-    
-    str[i] = '\0';
-    
-    // Reverse string
-    int start = 0;
-    int end = i - 1;
-    while (start < end) {
-        char temp = str[start];
-        str[start] = str[end];
-        str[end] = temp;
-        start++;
-        end--;
-    }
+static void dump_interrupts(void* arg) {
+    (void)arg;
+    irq_stats_dump();
+}
+
+#ifdef PROFILE
+static void dump_samples(void* arg) {
+    (void)arg;
+    sample_dump();
+    kprint("Samples written to the debug console\n");
 }
 
+static void dump_trace(void* arg) {
+    (void)arg;
+    trace_dump();
+    kprint("Trace written to the debug console\n");
+}
+#endif
+
 void kmain() {
     clear_screen();
     
     // Initialize 
     idt_init();
+    defer_init();
+    
+    // Mirror the console to COM1 so the host can capture logs
+    if (serial_init(SERIAL_CLOCK)) {
+        console_set_outputs(CONSOLE_VGA | CONSOLE_SERIAL);
+    }
     memory_init();
+    cpu_init();
+    mem_init();
     timer_init(100);
+    prof_init();
     keyboard_init();
+    random_init();
+    ata_init();
     __asm__ volatile("sti");
+    smp_init();
+    thread_init();
+    
+    // Pick the GEMM blocking for this CPU (cached at the end of the disk)
+    tune_init(block_get(0));
+    
+    // Report a saved model so a run can resume instead of retraining
+    ckpt_header_t header;
+    if (checkpoint_probe(block_get(0), CKPT_DEFAULT_LBA, &header)) {
+        checkpoint_print(&header);
+    }
+    
+    // F10 prints interrupt counts and handler times
+    keyboard_set_hotkey(SC_F10, dump_interrupts, 0);
+    
+#ifdef BENCH
+    // 'make bench': run the suite, then power the VM off
+    bench_exit(bench_run() ? BENCH_EXIT_FAILED : BENCH_EXIT_OK);
+#endif
+    
+#ifdef PROFILE
+    prof_report();
+    
+    // Sample and trace from here on; F12 dumps the samples (see
+    // tools/sample_report.py), F11 the trace (tools/trace_to_chrome.py)
+    sample_start(SAMPLE_DEFAULT_HZ);
+    keyboard_set_hotkey(SC_F12, dump_samples, 0);
+    trace_start();
+    keyboard_set_hotkey(SC_F11, dump_trace, 0);
+#endif
     
+    // Idle: run work deferred by interrupt handlers, then sleep
     while (1) {
-        __asm__ volatile("hlt");
+        defer_idle();
     }
 }
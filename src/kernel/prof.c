@@ -0,0 +1,236 @@
+#include "prof.h"
+#include "../cpu/cpu.h"
+#include "../cpu/smp.h"
+#include "../cpu/spinlock.h"
+#include "../drivers/clock.h"
+#include "../drivers/screen.h"
+#include "../libc/printf.h"
+#include "../math/math.h"
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    uint64_t total;             // Cycles including nested sections
+    uint64_t self;              // Cycles excluding nested sections
+    uint64_t min;
+    uint64_t max;
+    uint32_t calls;
+    uint32_t max_depth;         // Deepest nesting seen, 1 = outermost
+} prof_stat_t;
+
+typedef struct {
+    int32_t id;                 // -1: a site that got no table slot
+    uint64_t start;
+    uint64_t child;             // Cycles spent in nested sections
+} prof_frame_t;
+
+// Each CPU only touches its own table, so no locking on the hot path
+typedef struct {
+    prof_frame_t stack[PROF_MAX_DEPTH];
+    uint32_t depth;
+    uint32_t skipped;           // Opened past PROF_MAX_DEPTH, not recorded
+    prof_stat_t stats[PROF_MAX_SECTIONS];
+} __attribute__((aligned(64))) prof_cpu_t;
+
+static prof_cpu_t cpus[SMP_MAX_CPUS];
+static const char* names[PROF_MAX_SECTIONS];
+static uint32_t num_sections = 0;
+static spinlock_t register_lock = SPINLOCK_INIT;
+static uint8_t enabled = 0;
+
+static void clear_stats(prof_stat_t* stats) {
+    for (uint32_t i = 0; i < PROF_MAX_SECTIONS; i++) {
+        stats[i].total = 0;
+        stats[i].self = 0;
+        stats[i].min = ~0ULL;
+        stats[i].max = 0;
+        stats[i].calls = 0;
+        stats[i].max_depth = 0;
+    }
+}
+
+void prof_init(void) {
+    for (uint32_t c = 0; c < SMP_MAX_CPUS; c++) {
+        cpus[c].depth = 0;
+        cpus[c].skipped = 0;
+        clear_stats(cpus[c].stats);
+    }
+    enabled = 1;
+}
+
+void prof_reset(void) {
+    // Open frames are left alone so their prof_end still balances
+    for (uint32_t c = 0; c < SMP_MAX_CPUS; c++) {
+        uint32_t flags = cpu_irq_save();
+        clear_stats(cpus[c].stats);
+        cpu_irq_restore(flags);
+    }
+}
+
+// Give a site its table slot the first time it is reached
+static int32_t prof_register(prof_site_t* site) {
+    spin_lock(&register_lock);
+    if (site->id == 0) {
+        if (num_sections < PROF_MAX_SECTIONS) {
+            names[num_sections] = site->name;
+            site->id = (int32_t)++num_sections;
+        } else {
+            site->id = -1;
+        }
+    }
+    spin_unlock(&register_lock);
+    return site->id;
+}
+
+prof_site_t* prof_begin(prof_site_t* site) {
+    if (!enabled) {
+        return site;
+    }
+    int32_t id = site->id;
+    if (id == 0) {
+        id = prof_register(site);
+    }
+    
+    // Interrupt handlers have sections too; keep them off a half-built frame
+    uint32_t flags = cpu_irq_save();
+    uint32_t cpu;
+    uint64_t now = smp_tsc(&cpu);
+    prof_cpu_t* pc = &cpus[cpu];
+    // A site without a slot still gets a frame, so its prof_end pops
+    // that frame wherever it sits; only overflow past the stack (always
+    // the innermost scopes) is counted instead
+    if (pc->depth == PROF_MAX_DEPTH) {
+        pc->skipped++;
+    } else {
+        prof_frame_t* frame = &pc->stack[pc->depth++];
+        frame->id = id;
+        frame->child = 0;
+        frame->start = now;
+    }
+    cpu_irq_restore(flags);
+    return site;
+}
+
+void prof_end(prof_site_t* site) {
+    if (!enabled) {
+        return;
+    }
+    uint32_t flags = cpu_irq_save();
+    uint32_t cpu;
+    uint64_t now = smp_tsc(&cpu);
+    prof_cpu_t* pc = &cpus[cpu];
+    
+    // Overflowed scopes are the innermost ones, opened on a full stack
+    if (pc->skipped && pc->depth == PROF_MAX_DEPTH) {
+        pc->skipped--;
+        cpu_irq_restore(flags);
+        return;
+    }
+    
+    // Find the frame; a site that never got a slot has none
+    int32_t top = (int32_t)pc->depth - 1;
+    int32_t f = top;
+    if (site) {
+        while (f >= 0 && pc->stack[f].id != site->id) {
+            f--;
+        }
+    }
+    if (f < 0) {
+        cpu_irq_restore(flags);
+        return;
+    }
+    
+    prof_frame_t* frame = &pc->stack[f];
+    uint64_t elapsed = now - frame->start;
+    if (frame->id < 0) {
+        // Unrecorded: its own time counts as the parent's self time
+        if (f > 0) {
+            pc->stack[f - 1].child += frame->child;
+        }
+    } else {
+        prof_stat_t* stat = &pc->stats[frame->id - 1];
+        stat->total += elapsed;
+        stat->self += elapsed > frame->child ? elapsed - frame->child : 0;
+        if (elapsed < stat->min) {
+            stat->min = elapsed;
+        }
+        if (elapsed > stat->max) {
+            stat->max = elapsed;
+        }
+        stat->calls++;
+        if ((uint32_t)f + 1 > stat->max_depth) {
+            stat->max_depth = (uint32_t)f + 1;
+        }
+        if (f > 0) {
+            pc->stack[f - 1].child += elapsed;
+        }
+    }
+    
+    // Frames another thread left open above this one move down a level
+    for (; f < top; f++) {
+        pc->stack[f] = pc->stack[f + 1];
+    }
+    pc->depth--;
+    cpu_irq_restore(flags);
+}
+
+// Cycles converted to ns and divided by 'unit'
+static uint64_t prof_time(uint64_t cycles, uint32_t unit) {
+    return k_udiv64(clock_tsc_to_ns(cycles), unit);
+}
+
+void prof_report(void) {
+    static prof_stat_t merged[PROF_MAX_SECTIONS];
+    uint32_t order[PROF_MAX_SECTIONS];
+    uint32_t count = num_sections;
+    
+    // Sum the per-CPU tables
+    clear_stats(merged);
+    for (uint32_t c = 0; c < SMP_MAX_CPUS; c++) {
+        for (uint32_t i = 0; i < count; i++) {
+            const prof_stat_t* stat = &cpus[c].stats[i];
+            if (!stat->calls) {
+                continue;
+            }
+            merged[i].total += stat->total;
+            merged[i].self += stat->self;
+            merged[i].calls += stat->calls;
+            if (stat->min < merged[i].min) {
+                merged[i].min = stat->min;
+            }
+            if (stat->max > merged[i].max) {
+                merged[i].max = stat->max;
+            }
+            if (stat->max_depth > merged[i].max_depth) {
+                merged[i].max_depth = stat->max_depth;
+            }
+        }
+    }
+    
+    // Insertion sort by self time, largest first
+    uint32_t shown = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!merged[i].calls) {
+            continue;
+        }
+        uint32_t j = shown++;
+        while (j > 0 && merged[order[j - 1]].self < merged[i].self) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    
+    kprintf("Profile (TSC at %u kHz)\n", clock_tsc_khz());
+    kprintf("%-20s%-10s%-10s%-10s%-10s%-10sdepth\n",
+            "section", "calls", "self_us", "total_us", "min_ns", "max_ns");
+    for (uint32_t s = 0; s < shown; s++) {
+        const prof_stat_t* stat = &merged[order[s]];
+        kprintf("%-20s%-10u%-10llu%-10llu%-10llu%-10llu%u\n", names[order[s]], stat->calls,
+                prof_time(stat->self, 1000), prof_time(stat->total, 1000),
+                prof_time(stat->min, 1), prof_time(stat->max, 1), stat->max_depth);
+    }
+    if (!shown) {
+        kprint("  no sections recorded\n");
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+
+// Scoped cycle profiler. Sections are timed with the TSC and accumulated
+// per CPU into a fixed table (calls, total/self/min/max cycles, deepest
+// nesting). Build with PROFILE=1 to enable it; otherwise every marker
+// compiles to nothing.
+//
+//   void f(void) {
+//       PROF_SCOPE("f");          // Ends when the enclosing block exits
+//       ...
+//       PROF_BEGIN("f.inner");    // Explicit pair for part of a block
+//       ...
+//       PROF_END();
+//   }
+//
+// Time is attributed per CPU, not per thread: a scope held across a
+// thread switch also counts what the other thread ran. PROF_SCOPE closes
+// its own frame even if another thread's are still open above it, so
+// the table stays consistent; PROF_BEGIN/PROF_END pairs close whatever
+// is innermost and must not span a switch.
+
+#define PROF_MAX_SECTIONS 64
+#define PROF_MAX_DEPTH 16
+
+// One per marker, statically allocated; id is assigned on first use
+typedef struct {
+    const char* name;
+    volatile int32_t id;        // 0 until registered, -1 if the table is full
+} prof_site_t;
+
+// Start recording (needs cpu_init and clock_init done)
+void prof_init(void);
+
+// Clear all counters
+void prof_reset(void);
+
+// Print every section, sorted by self time, summed over CPUs
+void prof_report(void);
+
+// Open a section; returns the site for prof_scope_end
+prof_site_t* prof_begin(prof_site_t* site);
+
+// Close the innermost open frame of 'site' (NULL: the innermost frame)
+void prof_end(prof_site_t* site);
+
+static inline void prof_scope_end(prof_site_t** site) {
+    prof_end(*site);
+}
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT_(a, b)
+
+#ifdef PROFILE
+
+#define PROF_SCOPE(name) \
+    static prof_site_t PROF_CONCAT(prof_site_, __LINE__) = { name, 0 }; \
+    prof_site_t* PROF_CONCAT(prof_scope_, __LINE__) \
+        __attribute__((cleanup(prof_scope_end), unused)) = \
+        prof_begin(&PROF_CONCAT(prof_site_, __LINE__))
+
+#define PROF_BEGIN(name) do { \
+        static prof_site_t prof_site_ = { name, 0 }; \
+        prof_begin(&prof_site_); \
+    } while (0)
+
+#define PROF_END() prof_end(0)
+
+#else
+
+#define PROF_SCOPE(name) do { } while (0)
+#define PROF_BEGIN(name) do { } while (0)
+#define PROF_END() do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+#include "sample.h"
+#include "thread.h"
+#include "../cpu/cpu.h"
+#include "../drivers/debugcon.h"
+#include "../drivers/timer.h"
+#include "../interrupt/isr.h"
+#include "../libc/printf.h"
+#include "../memory/memory.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define SAMPLE_CAPACITY (SAMPLE_BUFFER_PAGES * PAGE_SIZE / sizeof(sample_t))
+
+extern uint32_t _kernel_start;
+extern uint32_t _kernel_end;
+
+static sample_t* samples = NULL;
+static uint32_t head = 0;               // Next slot to write
+static uint32_t count = 0;
+static uint32_t overwritten = 0;
+static uint32_t rate_hz = 0;
+static uint8_t running = 0;
+static volatile uint8_t paused = 0;
+static timer_event_t sample_event;
+
+static int in_kernel(uint32_t addr) {
+    return addr >= (uint32_t)&_kernel_start && addr < (uint32_t)&_kernel_end;
+}
+
+// Follow saved EBPs up the interrupted stack. Every frame must lie above
+// the previous one and within SAMPLE_STACK_SPAN of the interrupted ESP,
+// so a clobbered EBP ends the chain instead of faulting.
+static uint32_t sample_walk(const registers_t* regs, uint32_t* pc) {
+    uint32_t depth = 0;
+    uint32_t low = regs->esp;
+    uint32_t high = regs->esp + SAMPLE_STACK_SPAN;
+    uint32_t fp = regs->ebp;
+    
+    pc[depth++] = regs->eip;
+    while (depth < SAMPLE_MAX_DEPTH && fp >= low && fp + 8 <= high && !(fp & 3)) {
+        const uint32_t* frame = (const uint32_t*)fp;
+        if (!in_kernel(frame[1])) {
+            break;
+        }
+        pc[depth++] = frame[1];
+        low = fp + 8;
+        fp = frame[0];
+    }
+    return depth;
+}
+
+// Timer event: runs inside timer_callback, which has the interrupted state
+static void sample_tick(void* arg) {
+    (void)arg;
+    registers_t* regs = timer_irq_regs();
+    if (!regs || paused) {
+        return;
+    }
+    
+    sample_t* s = &samples[head];
+    thread_t* thread = thread_current();
+    s->thread = thread ? thread->name : "boot";
+    s->depth = sample_walk(regs, s->pc);
+    
+    head = head + 1 == SAMPLE_CAPACITY ? 0 : head + 1;
+    if (count < SAMPLE_CAPACITY) {
+        count++;
+    } else {
+        overwritten++;
+    }
+}
+
+int sample_start(uint32_t hz) {
+    if (hz == 0 || hz > 100000) {
+        return 0;
+    }
+    if (!samples) {
+        samples = (sample_t*)pmm_alloc_pages(SAMPLE_BUFFER_PAGES);
+        if (!samples) {
+            return 0;
+        }
+    }
+    
+    sample_stop();
+    uint32_t flags = cpu_irq_save();
+    head = 0;
+    count = 0;
+    overwritten = 0;
+    paused = 0;
+    rate_hz = hz;
+    running = 1;
+    timer_event_init(&sample_event, sample_tick, NULL);
+    timer_add_periodic(&sample_event, 1000000000U / hz);
+    cpu_irq_restore(flags);
+    return 1;
+}
+
+void sample_stop(void) {
+    if (running) {
+        timer_cancel(&sample_event);
+        running = 0;
+    }
+}
+
+uint32_t sample_count(void) {
+    return count;
+}
+
+uint32_t sample_overwritten(void) {
+    return overwritten;
+}
+
+void sample_dump(void) {
+    char buffer[64];
+    
+    paused = 1;
+    ksnprintf(buffer, sizeof(buffer), "# samples hz=%u count=%u overwritten=%u\n",
+              rate_hz, count, overwritten);
+    debugcon_write(buffer);
+    
+    // One line per sample: thread name, then EIP and callers in the
+    // fixed-width hex tools/sample_report.py expects
+    uint32_t index = (head + SAMPLE_CAPACITY - count) % SAMPLE_CAPACITY;
+    for (uint32_t i = 0; i < count; i++) {
+        const sample_t* s = &samples[index];
+        debugcon_write(s->thread);
+        for (uint32_t d = 0; d < s->depth; d++) {
+            ksnprintf(buffer, sizeof(buffer), " %08x", s->pc[d]);
+            debugcon_write(buffer);
+        }
+        debugcon_putc('\n');
+        index = index + 1 == SAMPLE_CAPACITY ? 0 : index + 1;
+    }
+    debugcon_write("# end\n");
+    paused = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include <stdint.h>
+
+// Statistical profiler: a periodic timer event records the interrupted
+// EIP and its frame-pointer call chain into a ring buffer (the newest
+// samples win). The dump goes to the debug console as text and
+// tools/sample_report.py turns it into a flat profile and folded stacks.
+//
+// Only the BSP takes timer interrupts, so only code running there is
+// sampled. Call chains need frame pointers; PROFILE=1 builds keep them
+// in the -O2 kernels too (without them a chain may skip callers).
+
+#define SAMPLE_MAX_DEPTH 14             // EIP plus return addresses
+#define SAMPLE_BUFFER_PAGES 256         // 1MB: 16384 samples
+#define SAMPLE_DEFAULT_HZ 997           // Prime, so it does not beat with periodic events
+#define SAMPLE_STACK_SPAN (16 * 1024)   // Largest kernel stack a chain may walk
+
+typedef struct {
+    const char* thread;                 // Name of the interrupted thread
+    uint32_t depth;
+    uint32_t pc[SAMPLE_MAX_DEPTH];      // pc[0] is EIP, then callers outward
+} sample_t;
+
+// Start sampling at 'hz' (restarts with a cleared buffer if running).
+// Needs timer_init; allocates the buffer on first use. Returns 0 if it
+// cannot be allocated or hz is out of range.
+int sample_start(uint32_t hz);
+
+void sample_stop(void);
+
+// Samples in the buffer, and how many older ones were overwritten
+uint32_t sample_count(void);
+uint32_t sample_overwritten(void);
+
+// Write the buffer to the debug console, oldest first. Sampling pauses
+// meanwhile. Slow (one port write per byte): call outside interrupts.
+void sample_dump(void);
+
+#endif
@@ -0,0 +1,247 @@
+#include "thread.h"
+#include "../cpu/cpu.h"
+#include "../cpu/smp.h"
+#include "../drivers/timer.h"
+#include "../interrupt/defer.h"
+#include "../memory/memory.h"
+#include <stdint.h>
+#include <stddef.h>
+
+extern void context_switch(uint32_t* save_esp, uint32_t new_esp);
+
+static thread_t main_thread;
+static thread_t* current = NULL;
+static thread_t* idle_thread = NULL;
+static uint32_t next_id = 0;
+
+// FIFO of READY threads (the idle thread is never queued)
+static thread_t* run_head = NULL;
+static thread_t* run_tail = NULL;
+
+// Exited threads whose stacks are freed once we are off them
+static thread_t* zombies = NULL;
+
+static volatile uint8_t need_resched = 0;
+static timer_event_t timeslice_event;
+static uint8_t timeslice_started = 0;
+
+static void runq_push(thread_t* thread) {
+    thread->next = NULL;
+    if (run_tail) {
+        run_tail->next = thread;
+    } else {
+        run_head = thread;
+    }
+    run_tail = thread;
+}
+
+static thread_t* runq_pop(void) {
+    thread_t* thread = run_head;
+    if (thread) {
+        run_head = thread->next;
+        if (!run_head) {
+            run_tail = NULL;
+        }
+    }
+    return thread;
+}
+
+// Free exited threads; never called on a zombie's own stack
+static void reap_zombies(void) {
+    while (zombies) {
+        thread_t* thread = zombies;
+        zombies = thread->next;
+        pmm_free_pages(thread->stack, THREAD_STACK_PAGES);
+        kfree(thread);
+    }
+}
+
+// Switch to the next ready thread. Called with interrupts disabled after
+// the caller has set current->state; a RUNNING caller is requeued.
+static void schedule(void) {
+    thread_t* prev = current;
+    thread_t* next = runq_pop();
+    if (!next) {
+        if (prev->state == THREAD_RUNNING) {
+            return;
+        }
+        next = idle_thread;
+    }
+    
+    if (prev->state == THREAD_RUNNING) {
+        prev->state = THREAD_READY;
+        if (prev != idle_thread) {
+            runq_push(prev);
+        }
+    } else if (prev->state == THREAD_ZOMBIE) {
+        prev->next = zombies;
+        zombies = prev;
+    }
+    
+    need_resched = 0;
+    next->state = THREAD_RUNNING;
+    current = next;
+    context_switch(&prev->esp, next->esp);
+    
+    // Back on prev's stack
+    reap_zombies();
+}
+
+// First code a new thread runs (entered from context_switch's ret, with
+// interrupts still disabled by the switching thread)
+static void thread_start(void) {
+    reap_zombies();
+    __asm__ volatile("sti");
+    current->entry(current->arg);
+    thread_exit();
+}
+
+static thread_t* thread_alloc(const char* name, thread_fn_t fn, void* arg) {
+    thread_t* thread = (thread_t*)kmalloc(sizeof(thread_t));
+    void* stack = pmm_alloc_pages(THREAD_STACK_PAGES);
+    if (!thread || !stack) {
+        kfree(thread);
+        if (stack) {
+            pmm_free_pages(stack, THREAD_STACK_PAGES);
+        }
+        return 0;
+    }
+    
+    thread->id = ++next_id;
+    thread->name = name;
+    thread->state = THREAD_READY;
+    thread->entry = fn;
+    thread->arg = arg;
+    thread->stack = stack;
+    thread->next = NULL;
+    
+    // Initial frame popped by context_switch: edi, esi, ebx, ebp, then
+    // the return into thread_start. The top slot stands in for
+    // thread_start's own return address, which leaves esp + 4 16-byte
+    // aligned at its entry as the ABI expects.
+    uint32_t* sp = (uint32_t*)((uint8_t*)stack + THREAD_STACK_PAGES * PAGE_SIZE);
+    *--sp = 0;                          // thread_start's return address
+    *--sp = (uint32_t)thread_start;
+    *--sp = 0;                          // ebp
+    *--sp = 0;                          // ebx
+    *--sp = 0;                          // esi
+    *--sp = 0;                          // edi
+    thread->esp = (uint32_t)sp;
+    return thread;
+}
+
+// Runs when nothing else is ready: drain deferred work, then halt until
+// an interrupt makes something runnable
+static void idle_loop(void* arg) {
+    (void)arg;
+    for (;;) {
+        defer_run();
+        __asm__ volatile("cli");
+        if (!run_head && !defer_pending()) {
+            __asm__ volatile("sti; hlt; cli" ::: "memory");
+        }
+        if (run_head) {
+            current->state = THREAD_RUNNING;
+            schedule();
+        }
+        __asm__ volatile("sti");
+    }
+}
+
+static void timeslice_callback(void* arg) {
+    (void)arg;
+    if (run_head) {
+        need_resched = 1;
+    }
+}
+
+void thread_init(void) {
+    main_thread.id = 0;
+    main_thread.name = "main";
+    main_thread.state = THREAD_RUNNING;
+    main_thread.stack = NULL;
+    main_thread.next = NULL;
+    current = &main_thread;
+    
+    idle_thread = thread_alloc("idle", idle_loop, NULL);
+}
+
+thread_t* thread_create(const char* name, thread_fn_t fn, void* arg) {
+    thread_t* thread = thread_alloc(name, fn, arg);
+    if (!thread) {
+        return 0;
+    }
+    
+    // Timeslices only matter once there is something to share the CPU with
+    if (!timeslice_started) {
+        timeslice_started = 1;
+        timer_event_init(&timeslice_event, timeslice_callback, NULL);
+        timer_add_periodic(&timeslice_event, THREAD_TIMESLICE_NS);
+    }
+    
+    uint32_t flags = cpu_irq_save();
+    runq_push(thread);
+    cpu_irq_restore(flags);
+    return thread;
+}
+
+thread_t* thread_current(void) {
+    return current;
+}
+
+void thread_yield(void) {
+    if (!current || !run_head || smp_cpu_index() != 0) {
+        return;
+    }
+    uint32_t flags = cpu_irq_save();
+    schedule();
+    cpu_irq_restore(flags);
+}
+
+void thread_preempt_point(void) {
+    if (need_resched) {
+        thread_yield();
+    }
+}
+
+void thread_block(void) {
+    uint32_t flags = cpu_irq_save();
+    current->state = THREAD_BLOCKED;
+    schedule();
+    cpu_irq_restore(flags);
+}
+
+void thread_wake(thread_t* thread) {
+    uint32_t flags = cpu_irq_save();
+    if (thread->state == THREAD_BLOCKED) {
+        thread->state = THREAD_READY;
+        runq_push(thread);
+    }
+    cpu_irq_restore(flags);
+}
+
+static void sleep_callback(void* arg) {
+    thread_wake((thread_t*)arg);
+}
+
+void thread_sleep_ns(uint64_t ns) {
+    timer_event_t ev;
+    timer_event_init(&ev, sleep_callback, current);
+    
+    // Arm and block with interrupts off so the wakeup cannot come first
+    uint32_t flags = cpu_irq_save();
+    timer_add(&ev, ns);
+    while (timer_pending(&ev)) {
+        thread_block();
+    }
+    cpu_irq_restore(flags);
+}
+
+void thread_exit(void) {
+    cpu_irq_save();
+    current->state = THREAD_ZOMBIE;
+    schedule();
+    for (;;) {
+        __asm__ volatile("hlt");
+    }
+}
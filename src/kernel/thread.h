@@ -0,0 +1,63 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdint.h>
+
+// Cooperative kernel threads on the BSP. A thread runs until it yields,
+// blocks, sleeps or exits; the timer only marks the running thread's
+// timeslice as used up (thread_preempt_point then yields). Switches
+// happen at call boundaries, so no FPU/SSE state needs saving. APs keep
+// running the work-stealing loop and never switch threads.
+
+#define THREAD_STACK_PAGES 4                // 16KB, from the PMM
+#define THREAD_TIMESLICE_NS 10000000ULL     // 10ms
+
+typedef enum {
+    THREAD_READY,
+    THREAD_RUNNING,
+    THREAD_BLOCKED,
+    THREAD_ZOMBIE
+} thread_state_t;
+
+typedef void (*thread_fn_t)(void* arg);
+
+typedef struct thread {
+    uint32_t esp;               // Saved stack pointer while switched out
+    uint32_t id;
+    const char* name;
+    volatile thread_state_t state;
+    thread_fn_t entry;
+    void* arg;
+    void* stack;                // PMM pages (NULL for the boot thread)
+    struct thread* next;        // Run queue / zombie list link
+} thread_t;
+
+// Adopt the boot flow as the "main" thread and create the idle thread.
+// Needs the heap and timer_init.
+void thread_init(void);
+
+// Start a thread; it is queued READY. Returns 0 on allocation failure.
+thread_t* thread_create(const char* name, thread_fn_t fn, void* arg);
+
+thread_t* thread_current(void);
+
+// Let other ready threads run; returns at once if there are none
+void thread_yield(void);
+
+// Yield if the timeslice has run out (cheap enough for inner loops)
+void thread_preempt_point(void);
+
+// Stop running until thread_wake. To avoid lost wakeups, check the wait
+// condition and block with interrupts disabled (cpu_irq_save).
+void thread_block(void);
+
+// Make a blocked thread ready. Safe from interrupt handlers.
+void thread_wake(thread_t* thread);
+
+// Block the calling thread for at least ns nanoseconds
+void thread_sleep_ns(uint64_t ns);
+
+// Terminate the calling thread (returning from its function does too)
+void thread_exit(void);
+
+#endif
@@ -0,0 +1,124 @@
+#include "trace.h"
+#include "thread.h"
+#include "../cpu/cpu.h"
+#include "../cpu/smp.h"
+#include "../drivers/clock.h"
+#include "../drivers/debugcon.h"
+#include "../memory/memory.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRACE_RING_EVENTS (TRACE_RING_PAGES * PAGE_SIZE / sizeof(trace_record_t))
+
+// Binary dump: header, event names, then each CPU's ring oldest first
+#define TRACE_MAGIC 0x31435254  // "TRC1"
+
+typedef struct {
+    trace_record_t* events;
+    uint32_t head;              // Records ever written; the slot is head % size
+} __attribute__((aligned(64))) trace_ring_t;
+
+volatile uint8_t trace_on = 0;
+static trace_ring_t rings[SMP_MAX_CPUS];
+static uint32_t num_rings = 0;
+
+static const char* event_names[TRACE_EV_COUNT] = {
+    "irq",
+    "exception",
+    "kmalloc",
+    "kfree",
+    "block_read",
+    "block_write",
+    "block_request",
+    "block_dispatch",
+    "train_step",
+    "train_slice",
+    "train_reduce",
+    "optimizer",
+    "loader_wait",
+    "loader_read",
+    "loader_ready",
+};
+
+int trace_start(void) {
+    uint32_t cpus = smp_cpu_count();
+    for (uint32_t c = num_rings; c < cpus; c++) {
+        rings[c].events = (trace_record_t*)pmm_alloc_pages(TRACE_RING_PAGES);
+        if (!rings[c].events) {
+            return 0;
+        }
+        num_rings = c + 1;
+    }
+    for (uint32_t c = 0; c < num_rings; c++) {
+        rings[c].head = 0;
+    }
+    trace_on = 1;
+    return 1;
+}
+
+void trace_stop(void) {
+    trace_on = 0;
+}
+
+void trace_emit(uint32_t type, uint32_t id, uint32_t arg) {
+    // The ring is per CPU; masking interrupts keeps a nested tracepoint
+    // from taking the same slot
+    uint32_t flags = cpu_irq_save();
+    uint32_t cpu;
+    uint64_t now = smp_tsc(&cpu);
+    trace_ring_t* ring = &rings[cpu];
+    if (cpu < num_rings) {
+        trace_record_t* rec = &ring->events[ring->head % TRACE_RING_EVENTS];
+        thread_t* thread = cpu == 0 ? thread_current() : NULL;
+        rec->tsc = now;
+        rec->type = (uint8_t)type;
+        rec->thread = thread ? (uint8_t)thread->id : 0;
+        rec->id = (uint16_t)id;
+        rec->arg = arg;
+        ring->head++;
+    }
+    cpu_irq_restore(flags);
+}
+
+static void put_bytes(const void* data, uint32_t size) {
+    const char* bytes = (const char*)data;
+    for (uint32_t i = 0; i < size; i++) {
+        debugcon_putc(bytes[i]);
+    }
+}
+
+static void put_u32(uint32_t value) {
+    put_bytes(&value, sizeof(value));
+}
+
+void trace_dump(void) {
+    uint8_t was_on = trace_on;
+    trace_on = 0;
+    
+    // Marker line so the converter can find the blob in a console log
+    debugcon_write("\n# trace\n");
+    put_u32(TRACE_MAGIC);
+    put_u32(clock_tsc_khz());
+    put_u32(TRACE_EV_COUNT);
+    put_u32(num_rings);
+    for (uint32_t e = 0; e < TRACE_EV_COUNT; e++) {
+        uint32_t len = 0;
+        while (event_names[e][len]) {
+            len++;
+        }
+        put_u32(len);
+        put_bytes(event_names[e], len);
+    }
+    
+    for (uint32_t c = 0; c < num_rings; c++) {
+        trace_ring_t* ring = &rings[c];
+        uint32_t count = ring->head < TRACE_RING_EVENTS ? ring->head : TRACE_RING_EVENTS;
+        put_u32(c);
+        put_u32(count);
+        for (uint32_t i = ring->head - count; i != ring->head; i++) {
+            put_bytes(&ring->events[i % TRACE_RING_EVENTS], sizeof(trace_record_t));
+        }
+    }
+    debugcon_write("\n# end\n");
+    trace_on = was_on;
+}
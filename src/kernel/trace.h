@@ -0,0 +1,114 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Event tracing for timelines. Each CPU appends 16-byte records with a
+// TSC timestamp to its own ring (the newest events win); trace_dump sends
+// the rings to the debug console and tools/trace_to_chrome.py converts
+// them to Chrome/Perfetto trace JSON.
+//
+// Tracepoints are compiled in with PROFILE=1 and cost a load and a
+// branch until trace_start. BEGIN/END pairs must nest within a thread;
+// work that completes elsewhere (a disk request finishing in an IRQ)
+// uses the ASYNC pair, matched by its argument.
+
+#define TRACE_RING_PAGES 64             // Per CPU: 16384 events
+
+// Record types
+#define TRACE_TYPE_BEGIN        0
+#define TRACE_TYPE_END          1
+#define TRACE_TYPE_INSTANT      2
+#define TRACE_TYPE_COUNTER      3
+#define TRACE_TYPE_ASYNC_BEGIN  4
+#define TRACE_TYPE_ASYNC_END    5
+
+// Tracepoints; names are in trace.c
+typedef enum {
+    TRACE_EV_IRQ,               // arg: vector
+    TRACE_EV_EXCEPTION,         // arg: vector
+    TRACE_EV_KMALLOC,           // arg: size
+    TRACE_EV_KFREE,
+    TRACE_EV_BLOCK_READ,        // arg: LBA
+    TRACE_EV_BLOCK_WRITE,       // arg: LBA
+    TRACE_EV_BLOCK_REQUEST,     // Async, submit to completion; arg: LBA
+    TRACE_EV_BLOCK_DISPATCH,    // arg: LBA
+    TRACE_EV_TRAIN_STEP,        // arg: step
+    TRACE_EV_TRAIN_SLICE,       // arg: slice
+    TRACE_EV_TRAIN_REDUCE,      // arg: chunk
+    TRACE_EV_OPTIMIZER,
+    TRACE_EV_LOADER_WAIT,       // Trainer stalled on the loader
+    TRACE_EV_LOADER_READ,       // arg: first sample
+    TRACE_EV_LOADER_READY,      // Counter: batches waiting for the trainer
+    TRACE_EV_COUNT
+} trace_event_id_t;
+
+typedef struct {
+    uint64_t tsc;
+    uint8_t type;
+    uint8_t thread;             // Thread id on the BSP (threads run there), else 0
+    uint16_t id;
+    uint32_t arg;
+} __attribute__((packed)) trace_record_t;
+
+// Set while recording; read inline by every tracepoint
+extern volatile uint8_t trace_on;
+
+// Allocate a ring per online CPU (after smp_init) and start recording.
+// Returns 0 if the rings cannot be allocated.
+int trace_start(void);
+
+void trace_stop(void);
+
+// Append a record on the calling CPU; use the macros below
+void trace_emit(uint32_t type, uint32_t id, uint32_t arg);
+
+// Closes a TRACE_SCOPE
+typedef struct {
+    uint32_t id;
+    uint32_t arg;
+} trace_scope_t;
+
+static inline void trace_scope_end(trace_scope_t* scope) {
+    if (trace_on) {
+        trace_emit(TRACE_TYPE_END, scope->id, scope->arg);
+    }
+}
+
+// Send every ring to the debug console in the binary format read by
+// tools/trace_to_chrome.py. Recording pauses meanwhile. Slow: call
+// outside interrupts.
+void trace_dump(void);
+
+#ifdef PROFILE
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_EMIT(type, id, arg) do { \
+        if (trace_on) { \
+            trace_emit((type), (id), (uint32_t)(arg)); \
+        } \
+    } while (0)
+
+// BEGIN now, END when the enclosing block exits
+#define TRACE_SCOPE(id, arg) \
+    trace_scope_t TRACE_CONCAT(trace_scope_, __LINE__) \
+        __attribute__((cleanup(trace_scope_end))) = { (id), (uint32_t)(arg) }; \
+    TRACE_EMIT(TRACE_TYPE_BEGIN, id, arg)
+
+#else
+
+#define TRACE_EMIT(type, id, arg) do { } while (0)
+#define TRACE_SCOPE(id, arg) do { } while (0)
+
+#endif
+
+#define TRACE_BEGIN(id, arg) TRACE_EMIT(TRACE_TYPE_BEGIN, id, arg)
+#define TRACE_END(id, arg) TRACE_EMIT(TRACE_TYPE_END, id, arg)
+#define TRACE_INSTANT(id, arg) TRACE_EMIT(TRACE_TYPE_INSTANT, id, arg)
+#define TRACE_COUNTER(id, value) TRACE_EMIT(TRACE_TYPE_COUNTER, id, value)
+#define TRACE_ASYNC_BEGIN(id, key) TRACE_EMIT(TRACE_TYPE_ASYNC_BEGIN, id, key)
+#define TRACE_ASYNC_END(id, key) TRACE_EMIT(TRACE_TYPE_ASYNC_END, id, key)
+
+#endif
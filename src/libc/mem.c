@@ -0,0 +1,219 @@
+#include "string.h"
+#include "../cpu/cpu.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Copies and fills at least this large bypass the cache with SSE2
+// non-temporal stores: the destination would not fit in L2 anyway, and
+// going through the cache would evict everything the caller is using
+#define MEM_NT_THRESHOLD (256 * 1024)
+
+// With ERMS a plain REP MOVSB/STOSB beats the dword versions once its
+// startup cost is paid
+#define MEM_ERMS_THRESHOLD 128
+
+static uint8_t use_erms = 0;
+static uint8_t use_nt = 0;
+
+void mem_init(void) {
+    use_erms = cpu_has_leaf7_ebx(CPUID_7_EBX_ERMS);
+    
+    // cpu_init has enabled SSE if the CPU has it
+    use_nt = cpu_has_edx(CPUID_EDX_SSE2) && cpu_has_edx(CPUID_EDX_FXSR);
+}
+
+// Align the destination to a dword, move dwords, then the odd tail bytes
+static void copy_forward(uint8_t* d, const uint8_t* s, size_t n) {
+    if (use_erms && n >= MEM_ERMS_THRESHOLD) {
+        __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+        return;
+    }
+    
+    size_t head = (0 - (uintptr_t)d) & 3;
+    if (head > n) {
+        head = n;
+    }
+    size_t dwords = (n - head) >> 2;
+    size_t tail = (n - head) & 3;
+    __asm__ volatile("rep movsb\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep movsl\n\t"
+                     "mov %4, %%ecx\n\t"
+                     "rep movsb"
+                     : "+D"(d), "+S"(s), "+c"(head)
+                     : "r"(dwords), "r"(tail)
+                     : "memory");
+}
+
+// Stream 64-byte blocks to a 16-byte aligned destination with MOVNTDQ.
+// xmm0-3 are saved and restored, since an interrupted kernel may be
+// holding values in them.
+static void copy_nt(uint8_t* d, const uint8_t* s, size_t n) {
+    uint8_t saved[64];
+    size_t head = (0 - (uintptr_t)d) & 15;
+    copy_forward(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    
+    size_t blocks = n >> 6;
+    __asm__ volatile("movdqu %%xmm0, 0(%3)\n\t"
+                     "movdqu %%xmm1, 16(%3)\n\t"
+                     "movdqu %%xmm2, 32(%3)\n\t"
+                     "movdqu %%xmm3, 48(%3)\n"
+                     "1:\n\t"
+                     "movdqu 0(%1), %%xmm0\n\t"
+                     "movdqu 16(%1), %%xmm1\n\t"
+                     "movdqu 32(%1), %%xmm2\n\t"
+                     "movdqu 48(%1), %%xmm3\n\t"
+                     "movntdq %%xmm0, 0(%0)\n\t"
+                     "movntdq %%xmm1, 16(%0)\n\t"
+                     "movntdq %%xmm2, 32(%0)\n\t"
+                     "movntdq %%xmm3, 48(%0)\n\t"
+                     "add $64, %1\n\t"
+                     "add $64, %0\n\t"
+                     "dec %2\n\t"
+                     "jnz 1b\n\t"
+                     "sfence\n\t"
+                     "movdqu 0(%3), %%xmm0\n\t"
+                     "movdqu 16(%3), %%xmm1\n\t"
+                     "movdqu 32(%3), %%xmm2\n\t"
+                     "movdqu 48(%3), %%xmm3"
+                     : "+r"(d), "+r"(s), "+r"(blocks)
+                     : "r"(saved)
+                     : "memory");
+    copy_forward(d, s, n & 63);
+}
+
+// Overlapping copy to a higher address: run the string ops downwards.
+// DF must be clear in interrupt handlers, so mask interrupts meanwhile.
+static void copy_backward(uint8_t* d, const uint8_t* s, size_t n) {
+    uint8_t* dl = d + n - 1;
+    const uint8_t* sl = s + n - 1;
+    size_t tail = n & 3;
+    size_t dwords = n >> 2;
+    uint32_t flags = cpu_irq_save();
+    __asm__ volatile("std\n\t"
+                     "rep movsb\n\t"
+                     "sub $3, %%edi\n\t"
+                     "sub $3, %%esi\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep movsl\n\t"
+                     "cld"
+                     : "+D"(dl), "+S"(sl), "+c"(tail)
+                     : "r"(dwords)
+                     : "memory");
+    cpu_irq_restore(flags);
+}
+
+void* memcpy(void* dst, const void* src, size_t n) {
+    if (use_nt && n >= MEM_NT_THRESHOLD) {
+        copy_nt((uint8_t*)dst, (const uint8_t*)src, n);
+    } else {
+        copy_forward((uint8_t*)dst, (const uint8_t*)src, n);
+    }
+    return dst;
+}
+
+void* memmove(void* dst, const void* src, size_t n) {
+    uint8_t* d = (uint8_t*)dst;
+    const uint8_t* s = (const uint8_t*)src;
+    
+    // Copying forwards is safe unless the destination starts inside the source
+    if (d <= s || d >= s + n) {
+        return memcpy(dst, src, n);
+    }
+    copy_backward(d, s, n);
+    return dst;
+}
+
+// Fill with a dword pattern, aligning the destination first
+static void fill_forward(uint8_t* d, uint32_t pattern, size_t n) {
+    if (use_erms && n >= MEM_ERMS_THRESHOLD) {
+        __asm__ volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(pattern) : "memory");
+        return;
+    }
+    
+    size_t head = (0 - (uintptr_t)d) & 3;
+    if (head > n) {
+        head = n;
+    }
+    size_t dwords = (n - head) >> 2;
+    size_t tail = (n - head) & 3;
+    __asm__ volatile("rep stosb\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep stosl\n\t"
+                     "mov %4, %%ecx\n\t"
+                     "rep stosb"
+                     : "+D"(d), "+c"(head)
+                     : "a"(pattern), "r"(dwords), "r"(tail)
+                     : "memory");
+}
+
+static void fill_nt(uint8_t* d, uint32_t pattern, size_t n) {
+    uint8_t saved[16];
+    size_t head = (0 - (uintptr_t)d) & 15;
+    fill_forward(d, pattern, head);
+    d += head;
+    n -= head;
+    
+    size_t blocks = n >> 6;
+    __asm__ volatile("movdqu %%xmm0, (%3)\n\t"
+                     "movd %2, %%xmm0\n\t"
+                     "pshufd $0, %%xmm0, %%xmm0\n"
+                     "1:\n\t"
+                     "movntdq %%xmm0, 0(%0)\n\t"
+                     "movntdq %%xmm0, 16(%0)\n\t"
+                     "movntdq %%xmm0, 32(%0)\n\t"
+                     "movntdq %%xmm0, 48(%0)\n\t"
+                     "add $64, %0\n\t"
+                     "dec %1\n\t"
+                     "jnz 1b\n\t"
+                     "sfence\n\t"
+                     "movdqu (%3), %%xmm0"
+                     : "+r"(d), "+r"(blocks)
+                     : "r"(pattern), "r"(saved)
+                     : "memory");
+    fill_forward(d, pattern, n & 63);
+}
+
+void* memset(void* dst, int c, size_t n) {
+    uint32_t pattern = (uint8_t)c * 0x01010101u;
+    if (use_nt && n >= MEM_NT_THRESHOLD) {
+        fill_nt((uint8_t*)dst, pattern, n);
+    } else {
+        fill_forward((uint8_t*)dst, pattern, n);
+    }
+    return dst;
+}
+
+void* memset16(void* dst, uint16_t value, size_t count) {
+    uint16_t* d = (uint16_t*)dst;
+    if (count && ((uintptr_t)d & 2)) {
+        *d++ = value;
+        count--;
+    }
+    
+    // Pairs of cells as dwords; video memory is slow to write, so fewer
+    // and wider stores matter more than usual
+    size_t pairs = count >> 1;
+    __asm__ volatile("rep stosl"
+                     : "+D"(d), "+c"(pairs)
+                     : "a"((uint32_t)value | ((uint32_t)value << 16))
+                     : "memory");
+    if (count & 1) {
+        *d = value;
+    }
+    return dst;
+}
+
+int memcmp(const void* a, const void* b, size_t n) {
+    const uint8_t* x = (const uint8_t*)a;
+    const uint8_t* y = (const uint8_t*)b;
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] != y[i]) {
+            return x[i] - y[i];
+        }
+    }
+    return 0;
+}
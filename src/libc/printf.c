@@ -0,0 +1,276 @@
+#include "printf.h"
+#include "../drivers/console.h"
+#include "../math/math.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#define FLAG_LEFT   0x01
+#define FLAG_ZERO   0x02
+#define FLAG_PLUS   0x04
+#define FLAG_SPACE  0x08
+
+#define FLOAT_MAX_PRECISION 9
+
+// Output cursor: counts every character, stores those that fit
+typedef struct {
+    char* buf;
+    size_t size;
+    size_t len;
+} out_t;
+
+static void out_char(out_t* out, char c) {
+    if (out->len + 1 < out->size) {
+        out->buf[out->len] = c;
+    }
+    out->len++;
+}
+
+static void out_repeat(out_t* out, char c, int count) {
+    for (; count > 0; count--) {
+        out_char(out, c);
+    }
+}
+
+// Emit sign/prefix and digits padded to 'width'. Zero padding goes between
+// the prefix and the digits; 'min_digits' comes from an integer precision.
+static void out_field(out_t* out, const char* prefix, const char* digits, int len,
+                      int min_digits, int width, uint32_t flags) {
+    int prefix_len = 0;
+    while (prefix[prefix_len]) {
+        prefix_len++;
+    }
+    int zeros = min_digits > len ? min_digits - len : 0;
+    int pad = width - prefix_len - zeros - len;
+    
+    if ((flags & FLAG_ZERO) && !(flags & FLAG_LEFT) && min_digits < 0) {
+        zeros += pad > 0 ? pad : 0;
+        pad = 0;
+    }
+    if (!(flags & FLAG_LEFT)) {
+        out_repeat(out, ' ', pad);
+    }
+    for (int i = 0; i < prefix_len; i++) {
+        out_char(out, prefix[i]);
+    }
+    out_repeat(out, '0', zeros);
+    for (int i = 0; i < len; i++) {
+        out_char(out, digits[i]);
+    }
+    if (flags & FLAG_LEFT) {
+        out_repeat(out, ' ', pad);
+    }
+}
+
+// Digits of 'value' in 'base', written backwards from the end of buf
+static int format_unsigned(uint64_t value, uint32_t base, int upper, char* end) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    int len = 0;
+    do {
+        uint64_t q = k_udiv64(value, base);
+        *--end = digits[(uint32_t)(value - q * base)];
+        value = q;
+        len++;
+    } while (value);
+    return len;
+}
+
+static const char* sign_prefix(int negative, uint32_t flags) {
+    if (negative) {
+        return "-";
+    }
+    if (flags & FLAG_PLUS) {
+        return "+";
+    }
+    return (flags & FLAG_SPACE) ? " " : "";
+}
+
+static void out_float(out_t* out, double x, int precision, int width, uint32_t flags) {
+    char digits[32];
+    char* end = digits + sizeof(digits);
+    int negative = x < 0;
+    
+    if (precision < 0) {
+        precision = 6;
+    }
+    if (precision > FLOAT_MAX_PRECISION) {
+        precision = FLOAT_MAX_PRECISION;
+    }
+    if (x != x) {
+        out_field(out, "", "nan", 3, -1, width, flags & ~FLAG_ZERO);
+        return;
+    }
+    if (negative) {
+        x = -x;
+    }
+    
+    uint32_t scale = 1;
+    for (int i = 0; i < precision; i++) {
+        scale *= 10;
+    }
+    x += 0.5 / scale;
+    if (x >= 9223372036854775808.0) {
+        out_field(out, sign_prefix(negative, flags), "inf", 3, -1, width, flags & ~FLAG_ZERO);
+        return;
+    }
+    
+    uint64_t whole = (uint64_t)(int64_t)x;
+    uint32_t frac = (uint32_t)((x - (double)(int64_t)whole) * scale);
+    if (frac >= scale) {
+        frac = scale - 1;
+    }
+    
+    // Fraction digits (with leading zeros), the point, then the integer part
+    int len = 0;
+    for (int i = 0; i < precision; i++) {
+        *--end = '0' + frac % 10;
+        frac /= 10;
+        len++;
+    }
+    if (precision) {
+        *--end = '.';
+        len++;
+    }
+    len += format_unsigned(whole, 10, 0, end);
+    out_field(out, sign_prefix(negative, flags), digits + sizeof(digits) - len, len, -1, width, flags);
+}
+
+int kvsnprintf(char* buf, size_t size, const char* fmt, va_list args) {
+    out_t out = { buf, size, 0 };
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') {
+            out_char(&out, *fmt);
+            continue;
+        }
+        fmt++;
+        
+        uint32_t flags = 0;
+        for (;; fmt++) {
+            if (*fmt == '-') {
+                flags |= FLAG_LEFT;
+            } else if (*fmt == '0') {
+                flags |= FLAG_ZERO;
+            } else if (*fmt == '+') {
+                flags |= FLAG_PLUS;
+            } else if (*fmt == ' ') {
+                flags |= FLAG_SPACE;
+            } else {
+                break;
+            }
+        }
+        
+        int width = 0;
+        if (*fmt == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= FLAG_LEFT;
+                width = -width;
+            }
+            fmt++;
+        }
+        for (; *fmt >= '0' && *fmt <= '9'; fmt++) {
+            width = width * 10 + (*fmt - '0');
+        }
+        
+        int precision = -1;
+        if (*fmt == '.') {
+            fmt++;
+            precision = 0;
+            if (*fmt == '*') {
+                precision = va_arg(args, int);
+                fmt++;
+            }
+            for (; *fmt >= '0' && *fmt <= '9'; fmt++) {
+                precision = precision * 10 + (*fmt - '0');
+            }
+        }
+        
+        int wide = 0;
+        for (; *fmt == 'l'; fmt++) {
+            wide++;
+        }
+        
+        switch (*fmt) {
+        case 'd':
+        case 'i': {
+            int64_t value = wide >= 2 ? va_arg(args, int64_t) : va_arg(args, int32_t);
+            uint64_t mag = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+            int len = format_unsigned(mag, 10, 0, end);
+            out_field(&out, sign_prefix(value < 0, flags), end - len, len, precision, width, flags);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X': {
+            uint64_t value = wide >= 2 ? va_arg(args, uint64_t) : va_arg(args, uint32_t);
+            int len = format_unsigned(value, *fmt == 'u' ? 10 : 16, *fmt == 'X', end);
+            out_field(&out, "", end - len, len, precision, width, flags);
+            break;
+        }
+        case 'p': {
+            uint32_t value = (uint32_t)(uintptr_t)va_arg(args, void*);
+            int len = format_unsigned(value, 16, 0, end);
+            out_field(&out, "0x", end - len, len, 8, width, flags);
+            break;
+        }
+        case 'c': {
+            char c = (char)va_arg(args, int);
+            out_field(&out, "", &c, 1, -1, width, flags & ~FLAG_ZERO);
+            break;
+        }
+        case 's': {
+            const char* s = va_arg(args, const char*);
+            int len = 0;
+            if (!s) {
+                s = "(null)";
+            }
+            while (s[len] && (precision < 0 || len < precision)) {
+                len++;
+            }
+            out_field(&out, "", s, len, -1, width, flags & ~FLAG_ZERO);
+            break;
+        }
+        case 'f':
+            out_float(&out, va_arg(args, double), precision, width, flags);
+            break;
+        case '%':
+            out_char(&out, '%');
+            break;
+        default:
+            // Unknown conversion: print it as written
+            out_char(&out, '%');
+            if (!*fmt) {
+                fmt--;
+            } else {
+                out_char(&out, *fmt);
+            }
+            break;
+        }
+    }
+    
+    if (size) {
+        buf[out.len < size ? out.len : size - 1] = '\0';
+    }
+    return (int)out.len;
+}
+
+int ksnprintf(char* buf, size_t size, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = kvsnprintf(buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+int kprintf(const char* fmt, ...) {
+    char buffer[KPRINTF_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    int len = kvsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    console_write(buffer);
+    return len;
+}
@@ -0,0 +1,25 @@
+#ifndef PRINTF_H
+#define PRINTF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// Longest kprintf output; anything beyond is cut off
+#define KPRINTF_BUFFER_SIZE 512
+
+// Conversions: %d %i %u %x %X %p %s %c %f %%
+// Flags '-' (left align), '0' (zero pad), '+' and ' ' (sign); a width and
+// '.precision' may be given as digits or '*'. 'l' is accepted and ignored,
+// 'll' reads a 64-bit integer. %f prints |x| >= 2^63 as "inf" and defaults
+// to 6 decimals (at most 9); it uses the FPU, so not before cpu_init.
+
+// Format into buf (always NUL terminated if size > 0). Returns the length
+// the full output would have had, like snprintf.
+int kvsnprintf(char* buf, size_t size, const char* fmt, va_list args);
+int ksnprintf(char* buf, size_t size, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// Format and send to the console with a single console_write
+int kprintf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef STRING_H
+#define STRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Memory routines (libc/mem.c). GCC also emits calls to these for struct
+// copies and large initialisers, so they must exist even if unused here.
+void* memcpy(void* dst, const void* src, size_t n);
+void* memmove(void* dst, const void* src, size_t n);
+void* memset(void* dst, int c, size_t n);
+int memcmp(const void* a, const void* b, size_t n);
+
+// Fill 'count' 16-bit cells (VGA text attributes and characters)
+void* memset16(void* dst, uint16_t value, size_t count);
+
+// Pick the fastest variants for this CPU. Call after cpu_init; until then
+// the plain REP MOVSD/STOSD versions are used.
+void mem_init(void);
+
+#endif
@@ -0,0 +1,231 @@
+#include "gemm.h"
+#include "simd.h"
+#include "../memory/memory.h"
+#include "../cpu/smp.h"
+#include "../cpu/spinlock.h"
+#include "../kernel/prof.h"
+#include <stdint.h>
+
+static gemm_blocking_t blocking = {GEMM_DEFAULT_MC, GEMM_DEFAULT_KC, GEMM_DEFAULT_NC};
+
+// Bumped around every change of 'blocking' (odd while one is in
+// progress) so readers can take a consistent copy without a lock
+static volatile uint32_t blocking_gen = 0;
+static spinlock_t blocking_lock = SPINLOCK_INIT;
+
+// Packing buffers are per CPU so sgemm can run on several cores at once.
+// Only the owning CPU allocates or frees them: each sgemm call compares
+// the generation its buffers were sized for with blocking_gen and
+// reallocates when the blocking has changed.
+typedef struct {
+    float* a;                   // MC x KC, MR-row slivers
+    float* b;                   // KC x NC, NR-column slivers
+    gemm_blocking_t blocking;   // What a and b are sized for
+    uint32_t gen;
+} gemm_packs_t;
+
+static gemm_packs_t packs[SMP_MAX_CPUS];
+
+static int gemm_alloc_packs(gemm_packs_t* p, const gemm_blocking_t* blk, uint32_t gen) {
+    float* a = (float*)kmalloc_aligned(blk->mc * blk->kc * sizeof(float), 16);
+    float* b = (float*)kmalloc_aligned(blk->kc * blk->nc * sizeof(float), 16);
+    if (!a || !b) {
+        kfree(a);
+        kfree(b);
+        return 0;
+    }
+    kfree(p->a);
+    kfree(p->b);
+    p->a = a;
+    p->b = b;
+    p->blocking = *blk;
+    p->gen = gen;
+    return 1;
+}
+
+// Copy of the current blocking and its generation
+static gemm_blocking_t gemm_snapshot(uint32_t* gen) {
+    gemm_blocking_t blk;
+    uint32_t g;
+    
+    do {
+        g = __atomic_load_n(&blocking_gen, __ATOMIC_ACQUIRE);
+        blk = blocking;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((g & 1) || g != __atomic_load_n(&blocking_gen, __ATOMIC_RELAXED));
+    *gen = g;
+    return blk;
+}
+
+int gemm_set_blocking(uint32_t mc, uint32_t kc, uint32_t nc) {
+    gemm_blocking_t blk;
+    blk.mc = (mc + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+    blk.kc = kc;
+    blk.nc = (nc + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+    if (blk.mc == 0 || blk.kc == 0 || blk.nc == 0) {
+        return 0;
+    }
+    
+    // Allocate for the calling CPU now so failure leaves things unchanged;
+    // the other CPUs reallocate their own at their next sgemm
+    spin_lock(&blocking_lock);
+    uint32_t gen = blocking_gen + 2;
+    if (!gemm_alloc_packs(&packs[smp_cpu_index()], &blk, gen)) {
+        spin_unlock(&blocking_lock);
+        return 0;
+    }
+    __atomic_store_n(&blocking_gen, gen - 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    blocking = blk;
+    __atomic_store_n(&blocking_gen, gen, __ATOMIC_RELEASE);
+    spin_unlock(&blocking_lock);
+    return 1;
+}
+
+const gemm_blocking_t* gemm_get_blocking(void) {
+    return &blocking;
+}
+
+// Pack rows [0, mc) x cols [0, kc) of op(A) starting at (i0, p0) into
+// MR-row slivers, each stored k-major: sliver[p * MR + i]. Rows past M
+// are zero so the micro-kernel never needs an edge case.
+static void pack_a_block(int trans, const float* a, uint32_t lda, uint32_t i0, uint32_t p0,
+                         uint32_t mc, uint32_t kc, uint32_t m, float* dst) {
+    for (uint32_t ir = 0; ir < mc; ir += GEMM_MR) {
+        for (uint32_t p = 0; p < kc; p++) {
+            for (uint32_t i = 0; i < GEMM_MR; i++) {
+                uint32_t row = i0 + ir + i;
+                float v = 0.0f;
+                if (row < m) {
+                    v = trans ? a[(p0 + p) * lda + row] : a[row * lda + p0 + p];
+                }
+                *dst++ = v;
+            }
+        }
+    }
+}
+
+// Pack op(B) into NR-column slivers, each stored k-major: sliver[p * NR + j]
+static void pack_b_panel(int trans, const float* b, uint32_t ldb, uint32_t p0, uint32_t j0,
+                         uint32_t kc, uint32_t nc, uint32_t n, float* dst) {
+    for (uint32_t jr = 0; jr < nc; jr += GEMM_NR) {
+        uint32_t col = j0 + jr;
+        if (!trans && col + GEMM_NR <= n) {
+            // Common case: four contiguous floats per k
+            for (uint32_t p = 0; p < kc; p++) {
+                v4sf_store(dst, v4sf_load(b + (p0 + p) * ldb + col));
+                dst += GEMM_NR;
+            }
+            continue;
+        }
+        for (uint32_t p = 0; p < kc; p++) {
+            for (uint32_t j = 0; j < GEMM_NR; j++) {
+                float v = 0.0f;
+                if (col + j < n) {
+                    v = trans ? b[(col + j) * ldb + p0 + p] : b[(p0 + p) * ldb + col + j];
+                }
+                *dst++ = v;
+            }
+        }
+    }
+}
+
+// 4x4 micro-kernel: acc = sum_p A[:, p] * B[p, :] over packed slivers,
+// then C_tile += alpha * acc (only mr x nr of it at the edges)
+static void micro_kernel(uint32_t kc, const float* a, const float* b, float alpha,
+                         float* c, uint32_t ldc, uint32_t mr, uint32_t nr) {
+    v4sf c0 = v4sf_set1(0.0f);
+    v4sf c1 = c0, c2 = c0, c3 = c0;
+    
+    for (uint32_t p = 0; p < kc; p++) {
+        v4sf vb = *(const v4sf*)b;
+        c0 += v4sf_set1(a[0]) * vb;
+        c1 += v4sf_set1(a[1]) * vb;
+        c2 += v4sf_set1(a[2]) * vb;
+        c3 += v4sf_set1(a[3]) * vb;
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    
+    v4sf valpha = v4sf_set1(alpha);
+    if (mr == GEMM_MR && nr == GEMM_NR) {
+        v4sf_store(c, v4sf_load(c) + valpha * c0);
+        v4sf_store(c + ldc, v4sf_load(c + ldc) + valpha * c1);
+        v4sf_store(c + 2 * ldc, v4sf_load(c + 2 * ldc) + valpha * c2);
+        v4sf_store(c + 3 * ldc, v4sf_load(c + 3 * ldc) + valpha * c3);
+        return;
+    }
+    
+    v4sf rows[GEMM_MR] = {c0, c1, c2, c3};
+    for (uint32_t i = 0; i < mr; i++) {
+        for (uint32_t j = 0; j < nr; j++) {
+            c[i * ldc + j] += alpha * rows[i][j];
+        }
+    }
+}
+
+int sgemm(int trans_a, int trans_b, uint32_t m, uint32_t n, uint32_t k,
+          float alpha, const float* a, uint32_t lda, const float* b, uint32_t ldb,
+          float beta, float* c, uint32_t ldc) {
+    PROF_SCOPE("sgemm");
+    gemm_packs_t* p = &packs[smp_cpu_index()];
+    uint32_t gen;
+    gemm_blocking_t blk = gemm_snapshot(&gen);
+    
+    // A CPU that cannot grow its buffers to a new blocking keeps working
+    // at the old one
+    if (p->gen != gen || !p->a) {
+        if (!gemm_alloc_packs(p, &blk, gen) && !p->a) {
+            return 0;
+        }
+    }
+    float* pa = p->a;
+    float* pb = p->b;
+    
+    // C = beta * C up front; the blocked loops then only accumulate
+    if (beta != 1.0f) {
+        for (uint32_t i = 0; i < m; i++) {
+            float* row = c + i * ldc;
+            for (uint32_t j = 0; j < n; j++) {
+                row[j] = beta == 0.0f ? 0.0f : beta * row[j];
+            }
+        }
+    }
+    if (k == 0 || alpha == 0.0f) {
+        return 1;
+    }
+    
+    uint32_t mc_max = p->blocking.mc;
+    uint32_t kc_max = p->blocking.kc;
+    uint32_t nc_max = p->blocking.nc;
+    
+    for (uint32_t jc = 0; jc < n; jc += nc_max) {
+        uint32_t nc = n - jc < nc_max ? n - jc : nc_max;
+        uint32_t nc_padded = (nc + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+        
+        for (uint32_t pc = 0; pc < k; pc += kc_max) {
+            uint32_t kc = k - pc < kc_max ? k - pc : kc_max;
+            pack_b_panel(trans_b, b, ldb, pc, jc, kc, nc_padded, n, pb);
+            
+            for (uint32_t ic = 0; ic < m; ic += mc_max) {
+                uint32_t mc = m - ic < mc_max ? m - ic : mc_max;
+                uint32_t mc_padded = (mc + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+                pack_a_block(trans_a, a, lda, ic, pc, mc_padded, kc, m, pa);
+                
+                // Macro-kernel over the packed block and panel
+                for (uint32_t jr = 0; jr < nc; jr += GEMM_NR) {
+                    uint32_t nr = nc - jr < GEMM_NR ? nc - jr : GEMM_NR;
+                    const float* bp = pb + jr * kc;
+                    
+                    for (uint32_t ir = 0; ir < mc; ir += GEMM_MR) {
+                        uint32_t mr = mc - ir < GEMM_MR ? mc - ir : GEMM_MR;
+                        micro_kernel(kc, pa + ir * kc, bp, alpha,
+                                     c + (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+    
+    return 1;
+}
@@ -0,0 +1,40 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stdint.h>
+
+// Register tile computed by the micro-kernel (4x4 fits the eight XMM
+// registers available in 32-bit mode)
+#define GEMM_MR 4
+#define GEMM_NR 4
+
+// Cache blocking: op(A) is packed in MC x KC blocks, op(B) in KC x NC
+// panels. MC and NC are multiples of MR and NR.
+typedef struct {
+    uint32_t mc;
+    uint32_t kc;
+    uint32_t nc;
+} gemm_blocking_t;
+
+#define GEMM_DEFAULT_MC 64
+#define GEMM_DEFAULT_KC 256
+#define GEMM_DEFAULT_NC 512
+
+// Set the blocking used by sgemm (rounded to tile multiples) and resize
+// the calling CPU's packing buffers. Returns 0 if they cannot be
+// allocated, in which case the previous blocking stays in effect. Safe
+// while other CPUs are inside sgemm: calls already running finish at the
+// old blocking, and each CPU resizes its own buffers on its next call.
+int gemm_set_blocking(uint32_t mc, uint32_t kc, uint32_t nc);
+const gemm_blocking_t* gemm_get_blocking(void);
+
+// Row-major single precision GEMM:
+//   C = alpha * op(A) * op(B) + beta * C
+// op(A) is M x K (A is K x M when trans_a), op(B) is K x N (B is N x K
+// when trans_b). Returns 0 if the packing buffers cannot be allocated.
+// Safe to call on several CPUs at once (packing buffers are per CPU).
+int sgemm(int trans_a, int trans_b, uint32_t m, uint32_t n, uint32_t k,
+          float alpha, const float* a, uint32_t lda, const float* b, uint32_t ldb,
+          float beta, float* c, uint32_t ldc);
+
+#endif
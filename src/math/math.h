@@ -0,0 +1,29 @@
+#ifndef MATH_H
+#define MATH_H
+
+#include <stdint.h>
+
+// Scalar floating point helpers (no libm in the kernel)
+
+static inline float k_sqrtf(float x) {
+    float r;
+    __asm__("fsqrt" : "=t"(r) : "0"(x));
+    return r;
+}
+
+static inline float k_fabsf(float x) {
+    return x < 0.0f ? -x : x;
+}
+
+// 64 by 32 bit unsigned division (no libgcc in the kernel, so plain
+// uint64_t division would not link)
+static inline uint64_t k_udiv64(uint64_t n, uint32_t d) {
+    uint32_t hi = (uint32_t)(n >> 32);
+    uint32_t q_hi = hi / d;
+    uint32_t r = hi % d;
+    uint32_t q_lo;
+    __asm__("divl %2" : "=a"(q_lo), "=d"(r) : "rm"(d), "a"((uint32_t)n), "d"(r));
+    return ((uint64_t)q_hi << 32) | q_lo;
+}
+
+#endif
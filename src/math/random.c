@@ -0,0 +1,247 @@
+#include "random.h"
+#include "simd.h"
+#include "vmath.h"
+#include "../cpu/cpu.h"
+#include <stdint.h>
+
+static rng_t kernel_rng;
+
+#define TWO_PI 6.28318530717958647692f
+#define HALF_PI 1.57079632679489661923f
+
+// 2^-24: scales a 24-bit integer to [0, 1)
+#define INV_2_24 (1.0f / 16777216.0f)
+
+static inline v4su rotl(v4su x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+// One xoshiro128** step on all four lanes
+static inline v4su xoshiro_next(v4su* s0, v4su* s1, v4su* s2, v4su* s3) {
+    // s1 * 5 and * 9 with shifts: SSE2 has no 32-bit lane multiply
+    v4su x = (*s1 << 2) + *s1;
+    x = rotl(x, 7);
+    v4su result = (x << 3) + x;
+    
+    v4su t = *s1 << 9;
+    *s2 ^= *s0;
+    *s3 ^= *s1;
+    *s1 ^= *s2;
+    *s0 ^= *s3;
+    *s2 ^= t;
+    *s3 = rotl(*s3, 11);
+    
+    return result;
+}
+
+#define RNG_LOAD(rng) \
+    v4su s0 = *(v4su*)(rng)->s[0], s1 = *(v4su*)(rng)->s[1], \
+         s2 = *(v4su*)(rng)->s[2], s3 = *(v4su*)(rng)->s[3]
+
+#define RNG_STORE(rng) \
+    *(v4su*)(rng)->s[0] = s0; *(v4su*)(rng)->s[1] = s1; \
+    *(v4su*)(rng)->s[2] = s2; *(v4su*)(rng)->s[3] = s3
+
+// Uniform (0, 1] from the top 24 bits (never 0, safe for log)
+static inline v4sf to_unit_open(v4su x) {
+    return __builtin_convertvector((v4si)((x >> 8) + 1), v4sf) * v4sf_set1(INV_2_24);
+}
+
+// Uniform [0, 1) from the top 24 bits
+static inline v4sf to_unit(v4su x) {
+    return __builtin_convertvector((v4si)(x >> 8), v4sf) * v4sf_set1(INV_2_24);
+}
+
+// splitmix64, used to expand a seed into generator state
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void random_seed(rng_t* rng, uint64_t seed) {
+    for (int lane = 0; lane < RNG_LANES; lane++) {
+        for (int w = 0; w < 4; w += 2) {
+            uint64_t z = splitmix64(&seed);
+            rng->s[w][lane] = (uint32_t)z;
+            rng->s[w + 1][lane] = (uint32_t)(z >> 32) | 1;  // Never all-zero
+        }
+    }
+    rng->buffer_pos = RNG_BUFFER_SIZE;
+}
+
+// The TSC count at boot varies with firmware and device timing; that is
+// the only entropy. (Timer ticks are derived from the TSC, and are still
+// 0 when random_init runs before interrupts are on.)
+void random_seed_entropy(rng_t* rng) {
+    random_seed(rng, rdtsc());
+}
+
+void random_init(void) {
+    random_seed_entropy(&kernel_rng);
+}
+
+rng_t* random_default(void) {
+    return &kernel_rng;
+}
+
+void random_fill_u32(rng_t* rng, uint32_t* out, uint32_t n) {
+    RNG_LOAD(rng);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        *(v4su_u*)(out + i) = xoshiro_next(&s0, &s1, &s2, &s3);
+    }
+    if (i < n) {
+        v4su r = xoshiro_next(&s0, &s1, &s2, &s3);
+        for (uint32_t l = 0; i < n; i++, l++) {
+            out[i] = r[l];
+        }
+    }
+    
+    RNG_STORE(rng);
+}
+
+uint32_t random_u32(rng_t* rng) {
+    if (rng->buffer_pos >= RNG_BUFFER_SIZE) {
+        random_fill_u32(rng, rng->buffer, RNG_BUFFER_SIZE);
+        rng->buffer_pos = 0;
+    }
+    return rng->buffer[rng->buffer_pos++];
+}
+
+// Lemire's multiply-shift: unbiased, no division on the fast path
+uint32_t random_range(rng_t* rng, uint32_t range) {
+    uint64_t m = (uint64_t)random_u32(rng) * range;
+    uint32_t low = (uint32_t)m;
+    
+    if (low < range) {
+        uint32_t threshold = -range % range;
+        while (low < threshold) {
+            m = (uint64_t)random_u32(rng) * range;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+float random_float(rng_t* rng) {
+    return (float)(random_u32(rng) >> 8) * INV_2_24;
+}
+
+void random_fill_uniform(rng_t* rng, float* out, uint32_t n, float lo, float hi) {
+    RNG_LOAD(rng);
+    v4sf vlo = v4sf_set1(lo);
+    v4sf vscale = v4sf_set1(hi - lo);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4sf_store(out + i, vlo + vscale * to_unit(xoshiro_next(&s0, &s1, &s2, &s3)));
+    }
+    if (i < n) {
+        v4sf r = vlo + vscale * to_unit(xoshiro_next(&s0, &s1, &s2, &s3));
+        for (uint32_t l = 0; i < n; i++, l++) {
+            out[i] = r[l];
+        }
+    }
+    
+    RNG_STORE(rng);
+}
+
+// cos/sin of 2*pi*u for u in [0, 1). The angle is split into a quadrant
+// and an offset in [0, pi/2), where short Taylor series are accurate to
+// ~4e-6, then rotated back into place.
+static inline void sincos_turn(v4sf u, v4sf* c, v4sf* s) {
+    v4sf t = u * v4sf_set1(4.0f);
+    v4si q = __builtin_convertvector(t, v4si);  // Truncates, t >= 0
+    v4sf x = (t - __builtin_convertvector(q, v4sf)) * v4sf_set1(HALF_PI);
+    v4sf x2 = x * x;
+    
+    v4sf sp = v4sf_set1(-1.0f / 39916800.0f);
+    sp = sp * x2 + v4sf_set1(1.0f / 362880.0f);
+    sp = sp * x2 + v4sf_set1(-1.0f / 5040.0f);
+    sp = sp * x2 + v4sf_set1(1.0f / 120.0f);
+    sp = sp * x2 + v4sf_set1(-1.0f / 6.0f);
+    sp = (sp * x2 + v4sf_set1(1.0f)) * x;
+    
+    v4sf cp = v4sf_set1(-1.0f / 3628800.0f);
+    cp = cp * x2 + v4sf_set1(1.0f / 40320.0f);
+    cp = cp * x2 + v4sf_set1(-1.0f / 720.0f);
+    cp = cp * x2 + v4sf_set1(1.0f / 24.0f);
+    cp = cp * x2 + v4sf_set1(-0.5f);
+    cp = cp * x2 + v4sf_set1(1.0f);
+    
+    // Quadrants 1 and 3 swap sin/cos; quadrants 1,2 negate cos, 2,3 negate sin
+    v4si swap = (q & 1) != 0;
+    v4sf cc = (v4sf)(((v4si)cp & ~swap) | ((v4si)sp & swap));
+    v4sf ss = (v4sf)(((v4si)sp & ~swap) | ((v4si)cp & swap));
+    v4si neg_c = ((q + 1) & 2) << 30;
+    v4si neg_s = (q & 2) << 30;
+    *c = (v4sf)((v4si)cc ^ neg_c);
+    *s = (v4sf)((v4si)ss ^ neg_s);
+}
+
+// Box-Muller: each step turns 4 (u1, u2) pairs into 8 normals
+void random_fill_normal(rng_t* rng, float* out, uint32_t n, float mean, float stddev) {
+    RNG_LOAD(rng);
+    v4sf vmean = v4sf_set1(mean);
+    v4sf vstd = v4sf_set1(stddev);
+    uint32_t i = 0;
+    
+    while (i < n) {
+        v4sf u1 = to_unit_open(xoshiro_next(&s0, &s1, &s2, &s3));
+        v4sf u2 = to_unit(xoshiro_next(&s0, &s1, &s2, &s3));
+        v4sf r = v4sf_sqrt(v4sf_set1(-2.0f) * v4sf_log(u1)) * vstd;
+        v4sf c, s;
+        sincos_turn(u2, &c, &s);
+        v4sf z0 = vmean + r * c;
+        v4sf z1 = vmean + r * s;
+        
+        if (i + 8 <= n) {
+            v4sf_store(out + i, z0);
+            v4sf_store(out + i + 4, z1);
+            i += 8;
+        } else {
+            for (uint32_t l = 0; l < 4 && i < n; l++) {
+                out[i++] = z0[l];
+            }
+            for (uint32_t l = 0; l < 4 && i < n; l++) {
+                out[i++] = z1[l];
+            }
+        }
+    }
+    
+    RNG_STORE(rng);
+}
+
+void random_fill_bernoulli(rng_t* rng, float* out, uint32_t n, float p, float value) {
+    RNG_LOAD(rng);
+    // Compare the top 24 bits against p * 2^24 as integers
+    v4si threshold = (v4si){0, 0, 0, 0} + (int32_t)(p * 16777216.0f);
+    v4si vvalue = (v4si)v4sf_set1(value);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4si r = (v4si)(xoshiro_next(&s0, &s1, &s2, &s3) >> 8);
+        v4sf_store(out + i, (v4sf)((r < threshold) & vvalue));
+    }
+    if (i < n) {
+        v4si r = (v4si)(xoshiro_next(&s0, &s1, &s2, &s3) >> 8);
+        v4sf m = (v4sf)((r < threshold) & vvalue);
+        for (uint32_t l = 0; i < n; i++, l++) {
+            out[i] = m[l];
+        }
+    }
+    
+    RNG_STORE(rng);
+}
+
+void random_shuffle(rng_t* rng, uint32_t* array, uint32_t n) {
+    for (uint32_t i = n; i > 1; i--) {
+        uint32_t j = random_range(rng, i);
+        uint32_t tmp = array[i - 1];
+        array[i - 1] = array[j];
+        array[j] = tmp;
+    }
+}
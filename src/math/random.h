@@ -0,0 +1,46 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// Number of interleaved xoshiro128** streams, one per SSE lane
+#define RNG_LANES 4
+
+// Outputs generated per refill of the scalar buffer
+#define RNG_BUFFER_SIZE 64
+
+// Generator state. Four independent xoshiro128** streams are stepped in
+// lockstep, so bulk fills produce four values per SSE step. The struct is
+// plain data and can be saved/restored by copying it.
+typedef struct {
+    uint32_t s[4][RNG_LANES];           // s[word][lane]
+    uint32_t buffer[RNG_BUFFER_SIZE];   // Pre-generated outputs for scalar calls
+    uint32_t buffer_pos;                // Next unused entry in buffer
+} __attribute__((aligned(16))) rng_t;
+
+// Seeding
+void random_seed(rng_t* rng, uint64_t seed);    // Reproducible sequence
+void random_seed_entropy(rng_t* rng);           // Seed from the TSC
+
+// Kernel-wide generator, seeded from entropy by random_init()
+void random_init(void);
+rng_t* random_default(void);
+
+// Scalar draws (served from a bulk-filled buffer)
+uint32_t random_u32(rng_t* rng);
+uint32_t random_range(rng_t* rng, uint32_t range);  // Uniform in [0, range)
+float random_float(rng_t* rng);                     // Uniform in [0, 1)
+
+// Bulk fills
+void random_fill_u32(rng_t* rng, uint32_t* out, uint32_t n);
+void random_fill_uniform(rng_t* rng, float* out, uint32_t n, float lo, float hi);
+void random_fill_normal(rng_t* rng, float* out, uint32_t n, float mean, float stddev);
+
+// out[i] = value with probability p, else 0 (dropout masks: p = keep
+// probability, value = 1 / p)
+void random_fill_bernoulli(rng_t* rng, float* out, uint32_t n, float p, float value);
+
+// Fisher-Yates shuffle of an index array
+void random_shuffle(rng_t* rng, uint32_t* array, uint32_t n);
+
+#endif
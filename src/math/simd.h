@@ -0,0 +1,50 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdint.h>
+
+// SSE vector types built on GCC vector extensions. Only include this from
+// files compiled with SIMD_CFLAGS (-msse2), see the Makefile.
+typedef float    v4sf __attribute__((vector_size(16)));
+typedef int32_t  v4si __attribute__((vector_size(16)));
+typedef uint32_t v4su __attribute__((vector_size(16)));
+typedef int16_t  v8hi __attribute__((vector_size(16)));
+typedef char     v16qi __attribute__((vector_size(16)));   // char, as the SSE builtins expect
+
+// Same types without the 16-byte alignment requirement (movups/movdqu)
+typedef float    v4sf_u __attribute__((vector_size(16), aligned(4)));
+typedef int32_t  v4si_u __attribute__((vector_size(16), aligned(4)));
+typedef uint32_t v4su_u __attribute__((vector_size(16), aligned(4)));
+typedef int16_t  v8hi_u __attribute__((vector_size(16), aligned(2)));
+typedef char     v16qi_u __attribute__((vector_size(16), aligned(1)));
+
+static inline v4sf v4sf_set1(float x) {
+    return (v4sf){x, x, x, x};
+}
+
+static inline v4sf v4sf_load(const float* p) {
+    return *(const v4sf_u*)p;
+}
+
+static inline void v4sf_store(float* p, v4sf v) {
+    *(v4sf_u*)p = v;
+}
+
+static inline v4sf v4sf_sqrt(v4sf x) {
+    return __builtin_ia32_sqrtps(x);
+}
+
+static inline v4sf v4sf_max(v4sf a, v4sf b) {
+    return __builtin_ia32_maxps(a, b);
+}
+
+static inline v4sf v4sf_min(v4sf a, v4sf b) {
+    return __builtin_ia32_minps(a, b);
+}
+
+// Horizontal sum of the four lanes
+static inline float v4sf_hsum(v4sf v) {
+    return (v[0] + v[1]) + (v[2] + v[3]);
+}
+
+#endif
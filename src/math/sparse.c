@@ -0,0 +1,125 @@
+#include "sparse.h"
+#include "simd.h"
+#include "../memory/memory.h"
+#include <stdint.h>
+
+// Element (r, c) of the source is a[r * row_stride + c * col_stride]
+static csr_matrix_t* csr_build(const float* a, uint32_t rows, uint32_t cols,
+                               uint32_t row_stride, uint32_t col_stride) {
+    uint32_t nnz = 0;
+    for (uint32_t i = 0; i < rows * cols; i++) {
+        nnz += (a[i] != 0.0f);
+    }
+    
+    csr_matrix_t* m = (csr_matrix_t*)kmalloc(sizeof(csr_matrix_t));
+    if (!m) {
+        return 0;
+    }
+    m->rows = rows;
+    m->cols = cols;
+    m->nnz = nnz;
+    m->row_ptr = (uint32_t*)kmalloc((rows + 1) * sizeof(uint32_t));
+    m->col_idx = (uint16_t*)kmalloc((nnz ? nnz : 1) * sizeof(uint16_t));
+    m->values = (float*)kmalloc((nnz ? nnz : 1) * sizeof(float));
+    if (!m->row_ptr || !m->col_idx || !m->values) {
+        csr_destroy(m);
+        return 0;
+    }
+    
+    uint32_t k = 0;
+    for (uint32_t r = 0; r < rows; r++) {
+        m->row_ptr[r] = k;
+        for (uint32_t c = 0; c < cols; c++) {
+            float v = a[r * row_stride + c * col_stride];
+            if (v != 0.0f) {
+                m->col_idx[k] = (uint16_t)c;
+                m->values[k] = v;
+                k++;
+            }
+        }
+    }
+    m->row_ptr[rows] = k;
+    
+    return m;
+}
+
+csr_matrix_t* csr_from_dense(const float* a, uint32_t rows, uint32_t cols) {
+    return csr_build(a, rows, cols, cols, 1);
+}
+
+csr_matrix_t* csr_from_dense_transposed(const float* weights, uint32_t in, uint32_t out) {
+    return csr_build(weights, out, in, 1, out);
+}
+
+void csr_destroy(csr_matrix_t* m) {
+    if (!m) {
+        return;
+    }
+    kfree(m->row_ptr);
+    kfree(m->col_idx);
+    kfree(m->values);
+    kfree(m);
+}
+
+uint32_t csr_bytes(const csr_matrix_t* m) {
+    return (m->rows + 1) * sizeof(uint32_t) + m->nnz * (sizeof(uint16_t) + sizeof(float));
+}
+
+void csr_spmv(const csr_matrix_t* a, const float* x, const float* bias, float* y) {
+    for (uint32_t r = 0; r < a->rows; r++) {
+        uint32_t k = a->row_ptr[r];
+        uint32_t end = a->row_ptr[r + 1];
+        
+        // Four independent accumulators hide the gather/add latency
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        for (; k + 4 <= end; k += 4) {
+            s0 += a->values[k] * x[a->col_idx[k]];
+            s1 += a->values[k + 1] * x[a->col_idx[k + 1]];
+            s2 += a->values[k + 2] * x[a->col_idx[k + 2]];
+            s3 += a->values[k + 3] * x[a->col_idx[k + 3]];
+        }
+        for (; k < end; k++) {
+            s0 += a->values[k] * x[a->col_idx[k]];
+        }
+        
+        y[r] = (s0 + s1) + (s2 + s3) + (bias ? bias[r] : 0.0f);
+    }
+}
+
+void csr_axpy_rows(const csr_matrix_t* a, const uint16_t* index, const float* value,
+                   uint32_t nnz, float* y) {
+    for (uint32_t n = 0; n < nnz; n++) {
+        float v = value[n];
+        uint32_t end = a->row_ptr[index[n] + 1];
+        for (uint32_t k = a->row_ptr[index[n]]; k < end; k++) {
+            y[a->col_idx[k]] += v * a->values[k];
+        }
+    }
+}
+
+void csr_spmm(const csr_matrix_t* a, const float* x, const float* bias, float* y, uint32_t n) {
+    for (uint32_t r = 0; r < a->rows; r++) {
+        float* yr = y + r * n;
+        v4sf vb = v4sf_set1(bias ? bias[r] : 0.0f);
+        uint32_t c = 0;
+        
+        for (; c + 4 <= n; c += 4) {
+            v4sf_store(yr + c, vb);
+        }
+        for (; c < n; c++) {
+            yr[c] = vb[0];
+        }
+        
+        // Each nonzero scales one whole input row into the output row
+        for (uint32_t k = a->row_ptr[r]; k < a->row_ptr[r + 1]; k++) {
+            const float* xr = x + a->col_idx[k] * n;
+            v4sf vw = v4sf_set1(a->values[k]);
+            for (c = 0; c + 4 <= n; c += 4) {
+                v4sf_store(yr + c, v4sf_load(yr + c) + vw * v4sf_load(xr + c));
+            }
+            for (; c < n; c++) {
+                yr[c] += vw[0] * xr[c];
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stdint.h>
+
+// Compressed sparse row matrix. Column indices are 16 bits, enough for
+// any layer width in this kernel.
+typedef struct {
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t nnz;
+    uint32_t* row_ptr;      // rows + 1; row r is [row_ptr[r], row_ptr[r + 1])
+    uint16_t* col_idx;      // nnz
+    float* values;          // nnz
+} csr_matrix_t;
+
+// Build the CSR form of a dense row-major (rows x cols) matrix, dropping
+// zeros. Returns 0 on allocation failure.
+csr_matrix_t* csr_from_dense(const float* a, uint32_t rows, uint32_t cols);
+
+// Same for the transpose of an input-major (in x out) weight matrix, i.e.
+// one row per output
+csr_matrix_t* csr_from_dense_transposed(const float* weights, uint32_t in, uint32_t out);
+void csr_destroy(csr_matrix_t* m);
+
+// Bytes used by the CSR arrays
+uint32_t csr_bytes(const csr_matrix_t* m);
+
+// y = A x (+ bias if not 0)
+void csr_spmv(const csr_matrix_t* a, const float* x, const float* bias, float* y);
+
+// y += sum over k of value[k] * (row index[k] of A): a sparse vector
+// times a sparse matrix, touching only the rows the vector selects
+void csr_axpy_rows(const csr_matrix_t* a, const uint16_t* index, const float* value,
+                   uint32_t nnz, float* y);
+
+// Y = A X (+ bias broadcast over columns if not 0), with X (cols x n) and
+// Y (rows x n) row-major, i.e. one column per sample
+void csr_spmm(const csr_matrix_t* a, const float* x, const float* bias, float* y, uint32_t n);
+
+#endif
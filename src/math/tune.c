@@ -0,0 +1,277 @@
+#include "tune.h"
+#include "gemm.h"
+#include "random.h"
+#include "../cpu/cpu.h"
+#include "../drivers/clock.h"
+#include "../libc/printf.h"
+#include "../libc/string.h"
+#include "../memory/memory.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define TUNE_SEED 0x7E57
+#define TUNE_CHASE_STRIDE 64            // One node per cache line
+
+_Static_assert(sizeof(tune_config_t) % 4 == 0, "tune_config_t must be whole words");
+_Static_assert(sizeof(tune_config_t) <= BLOCK_SECTOR_SIZE, "tune_config_t must fit in a sector");
+
+static volatile uint32_t tune_sink;     // Keeps the chase from being optimized out
+
+static double tune_ns(uint64_t start) {
+    uint64_t ns = clock_tsc_to_ns(rdtsc() - start);
+    return ns ? (double)(int64_t)ns : 1.0;
+}
+
+// Same Fletcher-style sum as the checkpoint header
+static uint32_t tune_checksum(const tune_config_t* config) {
+    const uint32_t* w = (const uint32_t*)config;
+    uint32_t a = 1, b = 0;
+    for (uint32_t i = 0; i < sizeof(tune_config_t) / 4; i++) {
+        a += w[i];
+        b += a;
+    }
+    return a ^ ((b << 16) | (b >> 16));
+}
+
+static uint32_t cache_size(uint32_t level) {
+    const cpu_cache_t* cache = cpu_data_cache(level);
+    return cache ? cache->size : 0;
+}
+
+// Fill in the fields that identify this machine
+static void tune_identify(tune_config_t* config) {
+    const cpu_info_t* info = cpu_get_info();
+    
+    memset(config, 0, sizeof(tune_config_t));
+    config->magic = TUNE_MAGIC;
+    config->version = TUNE_VERSION;
+    config->signature = info->signature;
+    memcpy(config->vendor, info->vendor, sizeof(config->vendor));
+    for (uint32_t i = 0; i < 3; i++) {
+        config->cache_sizes[i] = cache_size(i + 1);
+    }
+}
+
+// a[i] = b[i] + s * c[i] over three arrays sharing 'bytes'
+static uint32_t probe_triad(float* buf, uint32_t bytes) {
+    uint32_t n = bytes / (3 * sizeof(float));
+    float* a = buf;
+    float* b = buf + n;
+    float* c = buf + 2 * n;
+    uint32_t reps = TUNE_TRIAD_BYTES / bytes;
+    
+    for (uint32_t i = 0; i < n; i++) {
+        b[i] = 1.0f;
+        c[i] = 2.0f;
+    }
+    uint64_t start = rdtsc();
+    for (uint32_t r = 0; r < reps; r++) {
+        for (uint32_t i = 0; i < n; i++) {
+            a[i] = b[i] + 3.0f * c[i];
+        }
+    }
+    return (uint32_t)(3.0 * sizeof(float) * n * reps * 1e3 / tune_ns(start));
+}
+
+// Walk a random cycle through every line of the buffer, so each load
+// depends on the previous one and the prefetchers cannot guess the next
+static float probe_latency(uint8_t* buf, uint32_t bytes, rng_t* rng) {
+    uint32_t nodes = bytes / TUNE_CHASE_STRIDE;
+    uint32_t* order = (uint32_t*)kmalloc(nodes * sizeof(uint32_t));
+    if (!order) {
+        return 0;
+    }
+    
+    for (uint32_t i = 0; i < nodes; i++) {
+        order[i] = i;
+    }
+    random_shuffle(rng, order, nodes);
+    for (uint32_t i = 0; i < nodes; i++) {
+        uint32_t next = order[(i + 1) % nodes];
+        *(uint8_t**)(buf + order[i] * TUNE_CHASE_STRIDE) = buf + next * TUNE_CHASE_STRIDE;
+    }
+    kfree(order);
+    
+    uint8_t* p = buf;
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < TUNE_CHASE_LOADS; i++) {
+        p = *(uint8_t**)p;
+    }
+    double ns = tune_ns(start);
+    tune_sink = (uint32_t)(uintptr_t)p;
+    return (float)(ns / TUNE_CHASE_LOADS);
+}
+
+uint32_t tune_probe_memory(tune_probe_t* probes) {
+    uint32_t count = TUNE_PROBE_SIZES;
+    uint8_t* buf = 0;
+    rng_t rng;
+    
+    // Largest working set that fits in the heap
+    while (count && !buf) {
+        buf = (uint8_t*)kmalloc_aligned(TUNE_PROBE_MIN << (2 * (count - 1)), 64);
+        if (!buf) {
+            count--;
+        }
+    }
+    
+    random_seed(&rng, TUNE_SEED);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bytes = TUNE_PROBE_MIN << (2 * i);
+        probes[i].bytes = bytes;
+        probes[i].triad_mbps = probe_triad((float*)buf, bytes);
+        probes[i].latency_ns = probe_latency(buf, bytes, &rng);
+    }
+    kfree(buf);
+    return count;
+}
+
+static uint32_t clamp(uint32_t v, uint32_t lo, uint32_t hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+// Blockings worth timing: the defaults, one derived from the cache sizes
+// and that one with each dimension halved or doubled. The derivation
+// keeps a KC x NR sliver of B in a quarter of L1, the MC x KC block of A
+// in half of L2 and the KC x NC panel of B in half of L3 (or of 4 x L2
+// where there is no L3).
+static uint32_t tune_candidates(gemm_blocking_t* out) {
+    uint32_t l1 = cache_size(1) ? cache_size(1) : 32 * 1024;
+    uint32_t l2 = cache_size(2) ? cache_size(2) : 256 * 1024;
+    uint32_t l3 = cache_size(3) ? cache_size(3) : 4 * l2;
+    gemm_blocking_t base;
+    uint32_t count = 0;
+    
+    base.kc = clamp(l1 / (4 * GEMM_NR * sizeof(float)) & ~15u, 64, 1024);
+    base.mc = clamp(l2 / (2 * base.kc * sizeof(float)) & ~(GEMM_MR - 1), 16, 512);
+    base.nc = clamp(l3 / (2 * base.kc * sizeof(float)) & ~(GEMM_NR - 1), 64, 1024);
+    
+    gemm_blocking_t all[7] = {
+        { GEMM_DEFAULT_MC, GEMM_DEFAULT_KC, GEMM_DEFAULT_NC },
+        base,
+        { base.mc / 2, base.kc, base.nc },
+        { base.mc * 2, base.kc, base.nc },
+        { base.mc, base.kc / 2, base.nc },
+        { base.mc, base.kc * 2, base.nc },
+        { base.mc, base.kc, base.nc / 2 },
+    };
+    for (uint32_t i = 0; i < 7 && count < TUNE_MAX_CANDIDATES; i++) {
+        uint32_t j = 0;
+        while (j < count && memcmp(&out[j], &all[i], sizeof(gemm_blocking_t))) {
+            j++;
+        }
+        if (j == count) {
+            out[count++] = all[i];
+        }
+    }
+    return count;
+}
+
+int tune_gemm(tune_config_t* config) {
+    gemm_blocking_t candidates[TUNE_MAX_CANDIDATES];
+    uint32_t count = tune_candidates(candidates);
+    uint32_t n = TUNE_GEMM_N;
+    uint32_t bytes = n * n * sizeof(float);
+    float* a = (float*)kmalloc_aligned(bytes, 16);
+    float* b = (float*)kmalloc_aligned(bytes, 16);
+    float* c = (float*)kmalloc_aligned(bytes, 16);
+    double best_ns = 0;
+    gemm_blocking_t best = { 0, 0, 0 };
+    rng_t rng;
+    
+    if (a && b && c) {
+        random_seed(&rng, TUNE_SEED);
+        random_fill_uniform(&rng, a, n * n, -1.0f, 1.0f);
+        random_fill_uniform(&rng, b, n * n, -1.0f, 1.0f);
+        
+        // Warm run, then best of two
+        for (uint32_t i = 0; i < count; i++) {
+            if (!gemm_set_blocking(candidates[i].mc, candidates[i].kc, candidates[i].nc) ||
+                !sgemm(0, 0, n, n, n, 1.0f, a, n, b, n, 0.0f, c, n)) {
+                continue;
+            }
+            for (uint32_t run = 0; run < 2; run++) {
+                uint64_t start = rdtsc();
+                sgemm(0, 0, n, n, n, 1.0f, a, n, b, n, 0.0f, c, n);
+                double ns = tune_ns(start);
+                if (!best_ns || ns < best_ns) {
+                    best_ns = ns;
+                    best = *gemm_get_blocking();
+                }
+            }
+        }
+    }
+    kfree(a);
+    kfree(b);
+    kfree(c);
+    
+    if (!best_ns || !gemm_set_blocking(best.mc, best.kc, best.nc)) {
+        gemm_set_blocking(GEMM_DEFAULT_MC, GEMM_DEFAULT_KC, GEMM_DEFAULT_NC);
+        return 0;
+    }
+    config->mc = best.mc;
+    config->kc = best.kc;
+    config->nc = best.nc;
+    config->gflops = (float)(2.0 * n * n * n / best_ns);
+    return 1;
+}
+
+// A saved config applies if it is intact and was tuned on the same CPU
+static int tune_load(block_device_t* dev, const tune_config_t* expect, tune_config_t* config) {
+    if (!dev || dev->sector_count < TUNE_SECTORS) {
+        return 0;
+    }
+    uint32_t lba = dev->sector_count - TUNE_SECTORS;
+    if (!block_read_bytes(dev, lba, config, sizeof(tune_config_t))) {
+        return 0;
+    }
+    uint32_t checksum = config->checksum;
+    config->checksum = 0;
+    if (config->magic != TUNE_MAGIC || config->version != TUNE_VERSION ||
+        tune_checksum(config) != checksum) {
+        return 0;
+    }
+    config->checksum = checksum;
+    return config->signature == expect->signature &&
+           !memcmp(config->vendor, expect->vendor, sizeof(config->vendor)) &&
+           !memcmp(config->cache_sizes, expect->cache_sizes, sizeof(config->cache_sizes)) &&
+           gemm_set_blocking(config->mc, config->kc, config->nc);
+}
+
+static int tune_save(block_device_t* dev, tune_config_t* config) {
+    config->checksum = 0;
+    config->checksum = tune_checksum(config);
+    if (!dev || dev->sector_count < TUNE_SECTORS) {
+        return 0;
+    }
+    uint32_t lba = dev->sector_count - TUNE_SECTORS;
+    return block_write_bytes(dev, lba, config, sizeof(tune_config_t)) && block_flush(dev);
+}
+
+void tune_init(block_device_t* dev) {
+    tune_config_t expect, config;
+    tune_probe_t probes[TUNE_PROBE_SIZES];
+    
+    tune_identify(&expect);
+    kprintf("Tune: L1d %uKB, L2 %uKB, L3 %uKB\n", expect.cache_sizes[0] / 1024,
+            expect.cache_sizes[1] / 1024, expect.cache_sizes[2] / 1024);
+    if (tune_load(dev, &expect, &config)) {
+        kprintf("Tune: sgemm mc=%u kc=%u nc=%u (%.2f GFLOP/s, saved)\n",
+                config.mc, config.kc, config.nc, config.gflops);
+        return;
+    }
+    
+    uint32_t count = tune_probe_memory(probes);
+    for (uint32_t i = 0; i < count; i++) {
+        kprintf("Tune: %6uKB  triad %6u MB/s  latency %.1f ns\n",
+                probes[i].bytes / 1024, probes[i].triad_mbps, probes[i].latency_ns);
+    }
+    
+    config = expect;
+    if (!tune_gemm(&config)) {
+        kprintf("Tune: no blocking could be timed, keeping the defaults\n");
+        return;
+    }
+    kprintf("Tune: sgemm mc=%u kc=%u nc=%u (%.2f GFLOP/s)%s\n", config.mc, config.kc, config.nc,
+            config.gflops, tune_save(dev, &config) ? "" : ", not saved");
+}
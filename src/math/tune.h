@@ -0,0 +1,61 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stdint.h>
+#include "../drivers/block.h"
+
+// Boot-time calibration. The memory probe measures STREAM triad
+// bandwidth and pointer-chase load latency over a range of working sets.
+// The GEMM tuner derives candidate blockings from the CPUID cache sizes,
+// times each on a square sgemm and installs the fastest. The winner is
+// kept in the last sector of the disk, keyed by CPU signature and cache
+// sizes, so later boots on the same machine (and QEMU -cpu model) load
+// it instead of searching again.
+
+#define TUNE_MAGIC 0x454E5554           // "TUNE"
+#define TUNE_VERSION 1
+
+// Sectors reserved at the end of the disk for the saved config;
+// checkpoints stop short of them
+#define TUNE_SECTORS 1
+
+#define TUNE_PROBE_SIZES 6              // Working sets 8KB, 32KB, ... 8MB
+#define TUNE_PROBE_MIN 8192
+#define TUNE_TRIAD_BYTES (32 * 1024 * 1024)    // Traffic per bandwidth point
+#define TUNE_CHASE_LOADS (1 << 20)      // Dependent loads per latency point
+
+#define TUNE_MAX_CANDIDATES 8
+#define TUNE_GEMM_N 256                 // Square problem timed per candidate
+
+typedef struct {
+    uint32_t bytes;                     // Working set
+    uint32_t triad_mbps;                // 10^6 bytes per second
+    float latency_ns;                   // Per dependent load, 64-byte stride
+} tune_probe_t;
+
+// The on-disk block, zero padded to a sector
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t checksum;                  // Of this struct with this field zero
+    uint32_t signature;                 // CPUID leaf 1 EAX
+    char vendor[12];
+    uint32_t cache_sizes[3];            // L1d, L2, L3 in bytes (0 if unknown)
+    uint32_t mc, kc, nc;
+    float gflops;                       // Winner at TUNE_GEMM_N
+} tune_config_t;
+
+// Load a matching config from dev, or probe, tune and save one (dev may
+// be NULL: nothing is saved). Either way the blocking is installed and a
+// summary printed. Needs the heap, cpu_init and the calibrated TSC.
+void tune_init(block_device_t* dev);
+
+// Fill probes[TUNE_PROBE_SIZES]; returns how many sizes could be
+// allocated and measured
+uint32_t tune_probe_memory(tune_probe_t* probes);
+
+// Time candidate blockings for this CPU, install the fastest and record
+// it in config. Returns 0 if no candidate could be allocated.
+int tune_gemm(tune_config_t* config);
+
+#endif
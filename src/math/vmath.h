@@ -0,0 +1,73 @@
+#ifndef VMATH_H
+#define VMATH_H
+
+#include "simd.h"
+
+// Vectorised transcendental functions (Cephes-style polynomial
+// approximations, ~1 ulp over the normal float range). Same restriction
+// as simd.h: only for files compiled with SIMD_CFLAGS.
+
+// Natural logarithm for x > 0
+static inline v4sf v4sf_log(v4sf x) {
+    const v4sf one = v4sf_set1(1.0f);
+    
+    x = v4sf_max(x, (v4sf)((v4si){0x00800000, 0x00800000, 0x00800000, 0x00800000}));
+    
+    // Split x = m * 2^e with m in [0.5, 1)
+    v4si xi = (v4si)x;
+    v4sf e = __builtin_convertvector(((xi >> 23) & 0xff) - 0x7e, v4sf);
+    x = (v4sf)((xi & ~0x7f800000) | 0x3f000000);
+    
+    // Shift m into [sqrt(1/2), sqrt(2)) and adjust e to match
+    v4si small = x < v4sf_set1(0.707106781186547524f);
+    v4sf tmp = (v4sf)((v4si)x & small);
+    x = x - one;
+    e = e - (v4sf)((v4si)one & small);
+    x = x + tmp;
+    
+    v4sf z = x * x;
+    v4sf y = v4sf_set1(7.0376836292e-2f);
+    y = y * x + v4sf_set1(-1.1514610310e-1f);
+    y = y * x + v4sf_set1(1.1676998740e-1f);
+    y = y * x + v4sf_set1(-1.2420140846e-1f);
+    y = y * x + v4sf_set1(1.4249322787e-1f);
+    y = y * x + v4sf_set1(-1.6668057665e-1f);
+    y = y * x + v4sf_set1(2.0000714765e-1f);
+    y = y * x + v4sf_set1(-2.4999993993e-1f);
+    y = y * x + v4sf_set1(3.3333331174e-1f);
+    y = y * x * z;
+    
+    y = y + e * v4sf_set1(-2.12194440e-4f);
+    y = y - v4sf_set1(0.5f) * z;
+    x = x + y;
+    return x + e * v4sf_set1(0.693359375f);
+}
+
+// e^x, clamped to the finite float range
+static inline v4sf v4sf_exp(v4sf x) {
+    const v4sf one = v4sf_set1(1.0f);
+    
+    x = v4sf_min(x, v4sf_set1(88.3762626647949f));
+    x = v4sf_max(x, v4sf_set1(-88.3762626647949f));
+    
+    // x = n * ln2 + r, n = floor(x / ln2 + 0.5)
+    v4sf fx = x * v4sf_set1(1.44269504088896341f) + v4sf_set1(0.5f);
+    v4sf t = __builtin_convertvector(__builtin_convertvector(fx, v4si), v4sf);
+    fx = t - (v4sf)((v4si)one & (t > fx));
+    x = x - fx * v4sf_set1(0.693359375f) - fx * v4sf_set1(-2.12194440e-4f);
+    
+    v4sf z = x * x;
+    v4sf y = v4sf_set1(1.9875691500e-4f);
+    y = y * x + v4sf_set1(1.3981999507e-3f);
+    y = y * x + v4sf_set1(8.3334519073e-3f);
+    y = y * x + v4sf_set1(4.1665795894e-2f);
+    y = y * x + v4sf_set1(1.6666665459e-1f);
+    y = y * x + v4sf_set1(5.0000001201e-1f);
+    y = y * z + x + one;
+    
+    // Scale by 2^n through the exponent bits
+    v4si n = __builtin_convertvector(fx, v4si);
+    return y * (v4sf)((n + 0x7f) << 23);
+}
+
+#endif
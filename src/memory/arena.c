@@ -0,0 +1,48 @@
+#include "arena.h"
+#include "memory.h"
+#include <stdint.h>
+
+#define ARENA_ALIGN 16
+
+arena_t* arena_create(uint32_t size) {
+    arena_t* arena = (arena_t*)kmalloc(sizeof(arena_t));
+    if (!arena) {
+        return 0;
+    }
+    
+    arena->base = (uint8_t*)kmalloc_aligned(size, ARENA_ALIGN);
+    if (!arena->base) {
+        kfree(arena);
+        return 0;
+    }
+    arena->size = size;
+    arena->used = 0;
+    arena->peak = 0;
+    return arena;
+}
+
+void arena_destroy(arena_t* arena) {
+    if (!arena) {
+        return;
+    }
+    kfree(arena->base);
+    kfree(arena);
+}
+
+void* arena_alloc(arena_t* arena, uint32_t size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (size > arena->size - arena->used) {
+        return 0;
+    }
+    
+    void* ptr = arena->base + arena->used;
+    arena->used += size;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return ptr;
+}
+
+void arena_reset(arena_t* arena) {
+    arena->used = 0;
+}
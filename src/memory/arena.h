@@ -0,0 +1,27 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+
+// Bump allocator over one heap block. Allocations are 16-byte aligned and
+// are all released at once by arena_reset(), which suits per-batch
+// scratch buffers (im2col patches, activations, argmax indices).
+typedef struct {
+    uint8_t* base;
+    uint32_t size;
+    uint32_t used;
+    uint32_t peak;          // Highest 'used' seen, for sizing
+} arena_t;
+
+// Create an arena of 'size' bytes from the kernel heap. Returns 0 on
+// allocation failure.
+arena_t* arena_create(uint32_t size);
+void arena_destroy(arena_t* arena);
+
+// Allocate from the arena; returns 0 when it is full
+void* arena_alloc(arena_t* arena, uint32_t size);
+
+// Release every allocation
+void arena_reset(arena_t* arena);
+
+#endif
@@ -1,4 +1,8 @@
 #include "memory.h"
+#include "../cpu/spinlock.h"
+#include "../kernel/prof.h"
+#include "../kernel/trace.h"
+#include "../libc/string.h"
 
 static uint8_t* pmm_bitmap;
 static uint32_t pmm_bitmap_size;
@@ -6,6 +10,7 @@ static uint32_t total_pages;
 static uint32_t free_pages;
 static uint32_t pmm_highest_page;
 
+extern uint32_t _kernel_start;
 extern uint32_t _kernel_end;
 
 // Bitmap manipulation
@@ -89,9 +94,7 @@ void pmm_init(void) {
     pmm_bitmap = (uint8_t*)kernel_end;
     
     // Initialize bitmap - mark all as used
-    for (uint32_t i = 0; i < pmm_bitmap_size; i++) {
-        pmm_bitmap[i] = 0xFF;
-    }
+    memset(pmm_bitmap, 0xFF, pmm_bitmap_size);
     free_pages = 0;
     
     // Mark usable regions as free based on E820 map
@@ -115,8 +118,9 @@ void pmm_init(void) {
     // 1. First 1MB
     pmm_mark_region_used(0x0, 0x100000);
     
-    // 2. Kernel region (from 0x1000 to end of kernel)
-    pmm_mark_region_used(0x1000, kernel_end - 0x1000);
+    // 2. Kernel region (from load address to end of kernel)
+    uint32_t kernel_start = (uint32_t)&_kernel_start;
+    pmm_mark_region_used(kernel_start, kernel_end - kernel_start);
     
     // 3. Bitmap
     pmm_mark_region_used((uint32_t)pmm_bitmap, pmm_bitmap_size);
@@ -155,6 +159,36 @@ void pmm_free_page(void* ptr) {
     }
 }
 
+void* pmm_alloc_pages(uint32_t count) {
+    if (count == 0 || free_pages < count) {
+        return 0;
+    }
+    
+    // First fit over the bitmap
+    uint32_t run = 0;
+    for (uint32_t i = 0; i < total_pages; i++) {
+        if (pmm_test_bit(i)) {
+            run = 0;
+            continue;
+        }
+        if (++run == count) {
+            uint32_t first = i + 1 - count;
+            for (uint32_t p = first; p <= i; p++) {
+                pmm_set_bit(p);
+            }
+            free_pages -= count;
+            return (void*)(first * PAGE_SIZE);
+        }
+    }
+    return 0;
+}
+
+void pmm_free_pages(void* ptr, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        pmm_free_page((uint8_t*)ptr + i * PAGE_SIZE);
+    }
+}
+
 uint32_t pmm_get_free_pages(void) {
     return free_pages;
 }
@@ -173,12 +207,20 @@ typedef struct heap_block {
 #define HEAP_BLOCK_HEADER_SIZE sizeof(heap_block_t)
 #define MIN_ALLOC_SIZE 16
 
+// Header is 16 bytes, so rounding sizes to 16 keeps every payload
+// 16-byte aligned for SSE loads/stores
+#define HEAP_ALIGN 16
+
 static heap_block_t* heap_start = 0;
 static uint32_t heap_size = 0;
 
+// Serialises the allocator across CPUs. Interrupt handlers never allocate,
+// so holding it with interrupts enabled is safe.
+static spinlock_t heap_lock = SPINLOCK_INIT;
+
 void heap_init(uint32_t start, uint32_t size) {
-    // Align start to 8-byte boundary
-    start = (start + 7) & ~7;
+    // Align start to HEAP_ALIGN boundary
+    start = (start + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
     
     heap_start = (heap_block_t*)start;
     heap_size = size;
@@ -211,13 +253,13 @@ static void heap_coalesce(heap_block_t* block) {
     }
 }
 
-void* kmalloc(uint32_t size) {
+static void* heap_alloc(uint32_t size) {
     if (!heap_start || size == 0) {
         return 0;
     }
     
-    // Align size to 8 bytes
-    size = (size + 7) & ~7;
+    // Align size to HEAP_ALIGN bytes
+    size = (size + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1);
     
     // Ensure minimum allocation size
     if (size < MIN_ALLOC_SIZE) {
@@ -252,10 +294,22 @@ void* kmalloc(uint32_t size) {
     return 0;  // No suitable block found
 }
 
+void* kmalloc(uint32_t size) {
+    PROF_SCOPE("kmalloc");
+    TRACE_SCOPE(TRACE_EV_KMALLOC, size);
+    spin_lock(&heap_lock);
+    void* ptr = heap_alloc(size);
+    spin_unlock(&heap_lock);
+    return ptr;
+}
+
 void kfree(void* ptr) {
     if (!ptr || !heap_start) {
         return;
     }
+    PROF_SCOPE("kfree");
+    TRACE_SCOPE(TRACE_EV_KFREE, 0);
+    spin_lock(&heap_lock);
     
     // Get block header
     heap_block_t* block = (heap_block_t*)((uint8_t*)ptr - HEAP_BLOCK_HEADER_SIZE);
@@ -263,11 +317,13 @@ void kfree(void* ptr) {
     // Validate block is within heap
     if ((uint32_t)block < (uint32_t)heap_start || 
         (uint32_t)block >= (uint32_t)heap_start + heap_size) {
+        spin_unlock(&heap_lock);
         return;
     }
     
     block->is_free = 1;
     heap_coalesce(block);
+    spin_unlock(&heap_lock);
 }
 
 void* kmalloc_aligned(uint32_t size, uint32_t alignment) {
@@ -275,10 +331,17 @@ void* kmalloc_aligned(uint32_t size, uint32_t alignment) {
         return 0;  // Alignment must be power of 2
     }
     
-    // Allocate extra space for alignment adjustment
-    uint32_t total_size = size + alignment + HEAP_BLOCK_HEADER_SIZE;
-    void* ptr = kmalloc(total_size);
+    // Every payload is already HEAP_ALIGN aligned
+    if (alignment <= HEAP_ALIGN) {
+        return kmalloc(size);
+    }
+    
+    // Allocate extra space so a free block can be carved off the front
+    uint32_t total_size = size + alignment + HEAP_BLOCK_HEADER_SIZE + MIN_ALLOC_SIZE;
+    spin_lock(&heap_lock);
+    void* ptr = heap_alloc(total_size);
     if (!ptr) {
+        spin_unlock(&heap_lock);
         return 0;
     }
     
@@ -288,24 +351,57 @@ void* kmalloc_aligned(uint32_t size, uint32_t alignment) {
     
     // If already aligned, return as-is
     if (aligned_addr == addr) {
+        spin_unlock(&heap_lock);
         return ptr;
     }
     
-    return ptr;
+    // Leave room for a minimum-sized free block in front of the aligned block
+    if (aligned_addr - addr < HEAP_BLOCK_HEADER_SIZE + MIN_ALLOC_SIZE) {
+        aligned_addr += alignment;
+    }
+    
+    // Split: [front (free)] [aligned block (allocated)]
+    heap_block_t* front = (heap_block_t*)((uint8_t*)ptr - HEAP_BLOCK_HEADER_SIZE);
+    heap_block_t* block = (heap_block_t*)(aligned_addr - HEAP_BLOCK_HEADER_SIZE);
+    uint32_t front_size = (uint32_t)block - addr;
+    
+    block->size = front->size - front_size - HEAP_BLOCK_HEADER_SIZE;
+    block->is_free = 0;
+    block->next = front->next;
+    block->prev = front;
+    if (block->next) {
+        block->next->prev = block;
+    }
+    
+    front->size = front_size;
+    front->next = block;
+    front->is_free = 1;
+    heap_coalesce(front);
+    spin_unlock(&heap_lock);
+    
+    return (void*)aligned_addr;
 }
 
 void memory_init(void) {
     // Initialize Physical Memory Manager
     pmm_init();
     
-    // Calculate heap start (after bitmap)
+    // Calculate heap start (after bitmap, but never below 1MB where the
+    // stack, VGA memory and BIOS areas live)
     uint32_t kernel_end = (uint32_t)&_kernel_end;
     kernel_end = (kernel_end + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
     uint32_t heap_start_addr = kernel_end + pmm_bitmap_size;
     heap_start_addr = (heap_start_addr + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    if (heap_start_addr < HEAP_MIN_ADDR) {
+        heap_start_addr = HEAP_MIN_ADDR;
+    }
     
-    // Allocate 1MB for heap
-    uint32_t heap_sz = 1024 * 1024;
+    // Allocate HEAP_SIZE for heap, clamped to the top of usable memory
+    uint32_t heap_sz = HEAP_SIZE;
+    uint32_t mem_top = pmm_highest_page * PAGE_SIZE;
+    if (heap_start_addr + heap_sz > mem_top) {
+        heap_sz = mem_top > heap_start_addr ? (mem_top - heap_start_addr) / 2 : 0;
+    }
     heap_init(heap_start_addr, heap_sz);
     
     // Mark heap region as used in PMM
@@ -5,9 +5,11 @@
 
 #define PAGE_SIZE 4096
 
-// Memory map addresses (set by bootloader)
+// Memory map addresses (set by bootloader; the hosted build moves them)
+#ifndef MEMORY_MAP_ADDR
 #define MEMORY_MAP_ADDR 0x0500
 #define MEMORY_MAP_COUNT_ADDR 0x04FC
+#endif
 
 // E820 memory map entry structure
 typedef struct {
@@ -28,10 +30,15 @@ typedef struct {
 void pmm_init(void);
 void* pmm_alloc_page(void);
 void pmm_free_page(void* ptr);
+void* pmm_alloc_pages(uint32_t count);             // Physically contiguous
+void pmm_free_pages(void* ptr, uint32_t count);
 uint32_t pmm_get_free_pages(void);
 uint32_t pmm_get_total_pages(void);
 
 // Heap Allocator
+#define HEAP_MIN_ADDR 0x100000          // Heap lives above the first 1MB
+#define HEAP_SIZE (32 * 1024 * 1024)    // Room for model weights and optimizer state
+
 void heap_init(uint32_t start, uint32_t size);
 void* kmalloc(uint32_t size);
 void kfree(void* ptr);
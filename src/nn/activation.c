@@ -0,0 +1,66 @@
+#include "activation.h"
+#include "../math/simd.h"
+#include "../math/vmath.h"
+#include <stdint.h>
+
+void relu_forward(float* x, uint32_t n) {
+    v4sf zero = v4sf_set1(0.0f);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4sf_store(x + i, v4sf_max(v4sf_load(x + i), zero));
+    }
+    for (; i < n; i++) {
+        if (x[i] < 0.0f) {
+            x[i] = 0.0f;
+        }
+    }
+}
+
+void relu_backward(const float* y, float* dy, uint32_t n) {
+    v4sf zero = v4sf_set1(0.0f);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4si keep = v4sf_load(y + i) > zero;
+        v4sf_store(dy + i, (v4sf)((v4si)v4sf_load(dy + i) & keep));
+    }
+    for (; i < n; i++) {
+        if (y[i] <= 0.0f) {
+            dy[i] = 0.0f;
+        }
+    }
+}
+
+void softmax(const float* logits, float* probs, uint32_t n) {
+    float max = logits[argmax(logits, n)];
+    v4sf vmax = v4sf_set1(max);
+    v4sf vsum = v4sf_set1(0.0f);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4sf e = v4sf_exp(v4sf_load(logits + i) - vmax);
+        v4sf_store(probs + i, e);
+        vsum += e;
+    }
+    float sum = v4sf_hsum(vsum);
+    for (; i < n; i++) {
+        probs[i] = v4sf_exp(v4sf_set1(logits[i] - max))[0];
+        sum += probs[i];
+    }
+    
+    float inv = 1.0f / sum;
+    for (i = 0; i < n; i++) {
+        probs[i] *= inv;
+    }
+}
+
+uint32_t argmax(const float* x, uint32_t n) {
+    uint32_t best = 0;
+    for (uint32_t i = 1; i < n; i++) {
+        if (x[i] > x[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,18 @@
+#ifndef ACTIVATION_H
+#define ACTIVATION_H
+
+#include <stdint.h>
+
+// In-place ReLU: x = max(x, 0)
+void relu_forward(float* x, uint32_t n);
+
+// ReLU backward: dy[i] = 0 where the forward output y[i] was not positive
+void relu_backward(const float* y, float* dy, uint32_t n);
+
+// Softmax of n logits into probs
+void softmax(const float* logits, float* probs, uint32_t n);
+
+// Index of the largest element
+uint32_t argmax(const float* x, uint32_t n);
+
+#endif
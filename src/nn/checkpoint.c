@@ -0,0 +1,300 @@
+#include "checkpoint.h"
+#include "../drivers/screen.h"
+#include "../libc/string.h"
+#include "../libc/printf.h"
+#include <stdint.h>
+
+_Static_assert(sizeof(ckpt_header_t) <= BLOCK_SECTOR_SIZE, "checkpoint header must fit in one sector");
+
+// Header sector staging buffer
+static uint8_t header_sector[BLOCK_SECTOR_SIZE] __attribute__((aligned(16)));
+
+// Fletcher-style sum over 32-bit words (plus any tail bytes)
+static uint32_t ckpt_checksum(const void* data, uint32_t bytes) {
+    const uint32_t* w = (const uint32_t*)data;
+    uint32_t a = 1, b = 0;
+    for (uint32_t i = 0; i < bytes / 4; i++) {
+        a += w[i];
+        b += a;
+    }
+    const uint8_t* tail = (const uint8_t*)data + (bytes & ~3);
+    for (uint32_t i = 0; i < (bytes & 3); i++) {
+        a += tail[i];
+        b += a;
+    }
+    return a ^ ((b << 16) | (b >> 16));
+}
+
+static void ckpt_header_init(ckpt_header_t* header, uint32_t model_kind) {
+    memset(header, 0, sizeof(ckpt_header_t));
+    header->magic = CKPT_MAGIC;
+    header->version = CKPT_VERSION;
+    header->model_kind = model_kind;
+    header->total_sectors = 1;
+}
+
+// Append a section after the previous one; data[] keeps its source
+static int ckpt_add_section(ckpt_header_t* header, const void** data, uint32_t kind,
+                            uint32_t dtype, uint32_t layer, const void* src, uint32_t bytes) {
+    if (header->num_sections >= CKPT_MAX_SECTIONS) {
+        return 0;
+    }
+    ckpt_section_t* sec = &header->sections[header->num_sections];
+    sec->kind = kind;
+    sec->dtype = dtype;
+    sec->layer = layer;
+    sec->sector = header->total_sectors;
+    sec->bytes = bytes;
+    sec->checksum = ckpt_checksum(src, bytes);
+    data[header->num_sections++] = src;
+    header->total_sectors += (bytes + BLOCK_SECTOR_SIZE - 1) / BLOCK_SECTOR_SIZE;
+    return 1;
+}
+
+static const ckpt_section_t* ckpt_find(const ckpt_header_t* header, uint32_t kind, uint32_t layer) {
+    for (uint32_t i = 0; i < header->num_sections; i++) {
+        if (header->sections[i].kind == kind && header->sections[i].layer == layer) {
+            return &header->sections[i];
+        }
+    }
+    return 0;
+}
+
+static int ckpt_write_header_sector(block_device_t* dev, uint32_t lba, const ckpt_header_t* header) {
+    memcpy(header_sector, header, sizeof(ckpt_header_t));
+    memset(header_sector + sizeof(ckpt_header_t), 0, BLOCK_SECTOR_SIZE - sizeof(ckpt_header_t));
+    return block_write(dev, lba, 1, header_sector);
+}
+
+// Invalidate, write the sections, then commit the header
+static int ckpt_write(block_device_t* dev, uint32_t lba, ckpt_header_t* header, const void** data) {
+    if (!dev || dev->sector_count < TUNE_SECTORS) {
+        return 0;
+    }
+    uint32_t usable = dev->sector_count - TUNE_SECTORS;
+    if (lba > usable || header->total_sectors > usable - lba) {
+        return 0;
+    }
+    
+    ckpt_header_t empty;
+    memset(&empty, 0, sizeof(empty));
+    if (!ckpt_write_header_sector(dev, lba, &empty) || !block_flush(dev)) {
+        return 0;
+    }
+    
+    for (uint32_t i = 0; i < header->num_sections; i++) {
+        const ckpt_section_t* sec = &header->sections[i];
+        if (!block_write_bytes(dev, lba + sec->sector, data[i], sec->bytes)) {
+            return 0;
+        }
+    }
+    if (!block_flush(dev)) {
+        return 0;
+    }
+    
+    header->header_checksum = 0;
+    header->header_checksum = ckpt_checksum(header, sizeof(ckpt_header_t));
+    return ckpt_write_header_sector(dev, lba, header) && block_flush(dev);
+}
+
+// Read a section straight into dst (which must hold sec->bytes) and verify it
+static int ckpt_read_section(block_device_t* dev, uint32_t lba, const ckpt_section_t* sec, void* dst) {
+    return block_read_bytes(dev, lba + sec->sector, dst, sec->bytes)
+        && ckpt_checksum(dst, sec->bytes) == sec->checksum;
+}
+
+// Find a section of the expected size and read it into dst
+static int ckpt_load_section(block_device_t* dev, uint32_t lba, const ckpt_header_t* header,
+                             uint32_t kind, uint32_t layer, void* dst, uint32_t bytes) {
+    const ckpt_section_t* sec = ckpt_find(header, kind, layer);
+    return sec && sec->bytes == bytes && ckpt_read_section(dev, lba, sec, dst);
+}
+
+int checkpoint_probe(block_device_t* dev, uint32_t lba, ckpt_header_t* header) {
+    if (!dev || !block_read(dev, lba, 1, header_sector)) {
+        return 0;
+    }
+    memcpy(header, header_sector, sizeof(ckpt_header_t));
+    
+    if (header->magic != CKPT_MAGIC || header->version != CKPT_VERSION) {
+        return 0;
+    }
+    uint32_t stored = header->header_checksum;
+    header->header_checksum = 0;
+    uint32_t sum = ckpt_checksum(header, sizeof(ckpt_header_t));
+    header->header_checksum = stored;
+    
+    return sum == stored
+        && header->num_sections <= CKPT_MAX_SECTIONS
+        && header->num_sizes >= 2 && header->num_sizes <= MLP_MAX_LAYERS + 1;
+}
+
+int checkpoint_save_mlp(block_device_t* dev, uint32_t lba, const mlp_t* model,
+                        const optimizer_t* opt, const rng_t* rng, uint32_t epoch) {
+    ckpt_header_t header;
+    const void* data[CKPT_MAX_SECTIONS];
+    ckpt_header_init(&header, CKPT_MODEL_MLP);
+    
+    header.num_sizes = model->num_layers + 1;
+    header.sizes[0] = model->layers[0].in;
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        header.sizes[l + 1] = model->layers[l].out;
+    }
+    header.epoch = epoch;
+    ckpt_add_section(&header, data, CKPT_SEC_PARAMS, CKPT_DTYPE_F32, 0,
+                     model->params, model->num_params * sizeof(float));
+    
+    if (opt) {
+        if (opt->count != model->num_params) {
+            return 0;
+        }
+        header.has_optimizer = 1;
+        header.opt_type = opt->type;
+        header.lr = opt->lr;
+        header.momentum = opt->momentum;
+        header.beta1 = opt->beta1;
+        header.beta2 = opt->beta2;
+        header.eps = opt->eps;
+        header.beta1_pow = opt->beta1_pow;
+        header.beta2_pow = opt->beta2_pow;
+        header.opt_step = opt->step;
+        if (opt->m) {
+            ckpt_add_section(&header, data, CKPT_SEC_OPT_M, CKPT_DTYPE_F32, 0, opt->m, opt->count * sizeof(float));
+        }
+        if (opt->v) {
+            ckpt_add_section(&header, data, CKPT_SEC_OPT_V, CKPT_DTYPE_F32, 0, opt->v, opt->count * sizeof(float));
+        }
+    }
+    if (rng) {
+        ckpt_add_section(&header, data, CKPT_SEC_RNG, CKPT_DTYPE_U32, 0, rng, sizeof(rng_t));
+    }
+    
+    return ckpt_write(dev, lba, &header, data);
+}
+
+// Rebuild an optimizer from the saved scalars and state arrays
+static optimizer_t* ckpt_load_optimizer(block_device_t* dev, uint32_t lba,
+                                        const ckpt_header_t* header, uint32_t count) {
+    optimizer_t* opt;
+    switch (header->opt_type) {
+    case OPTIMIZER_SGD:
+        opt = optimizer_create_sgd(count, header->lr, header->momentum);
+        break;
+    case OPTIMIZER_NESTEROV:
+        opt = optimizer_create_nesterov(count, header->lr, header->momentum);
+        break;
+    case OPTIMIZER_ADAM:
+        opt = optimizer_create_adam(count, header->lr, header->beta1, header->beta2, header->eps);
+        break;
+    default:
+        return 0;
+    }
+    if (!opt) {
+        return 0;
+    }
+    
+    opt->beta1_pow = header->beta1_pow;
+    opt->beta2_pow = header->beta2_pow;
+    opt->step = header->opt_step;
+    if ((opt->m && !ckpt_load_section(dev, lba, header, CKPT_SEC_OPT_M, 0, opt->m, count * sizeof(float))) ||
+        (opt->v && !ckpt_load_section(dev, lba, header, CKPT_SEC_OPT_V, 0, opt->v, count * sizeof(float)))) {
+        optimizer_destroy(opt);
+        return 0;
+    }
+    return opt;
+}
+
+mlp_t* checkpoint_load_mlp(block_device_t* dev, uint32_t lba, optimizer_t** opt,
+                           rng_t* rng, uint32_t* epoch) {
+    ckpt_header_t header;
+    if (!checkpoint_probe(dev, lba, &header) || header.model_kind != CKPT_MODEL_MLP) {
+        return 0;
+    }
+    
+    mlp_t* model = mlp_create(header.sizes, header.num_sizes);
+    if (!model) {
+        return 0;
+    }
+    if (!ckpt_load_section(dev, lba, &header, CKPT_SEC_PARAMS, 0,
+                           model->params, model->num_params * sizeof(float))) {
+        mlp_destroy(model);
+        return 0;
+    }
+    
+    if (opt) {
+        *opt = 0;
+        if (header.has_optimizer) {
+            *opt = ckpt_load_optimizer(dev, lba, &header, model->num_params);
+            if (!*opt) {
+                mlp_destroy(model);
+                return 0;
+            }
+        }
+    }
+    
+    // Restore into a scratch copy so a bad section leaves rng untouched
+    if (rng && ckpt_find(&header, CKPT_SEC_RNG, 0)) {
+        rng_t saved;
+        if (ckpt_load_section(dev, lba, &header, CKPT_SEC_RNG, 0, &saved, sizeof(rng_t))) {
+            *rng = saved;
+        }
+    }
+    if (epoch) {
+        *epoch = header.epoch;
+    }
+    return model;
+}
+
+int checkpoint_save_qmlp(block_device_t* dev, uint32_t lba, const qmlp_t* qmodel) {
+    ckpt_header_t header;
+    const void* data[CKPT_MAX_SECTIONS];
+    ckpt_header_init(&header, CKPT_MODEL_QMLP);
+    
+    header.num_sizes = qmodel->num_layers + 1;
+    header.sizes[0] = qmodel->layers[0].in;
+    for (uint32_t l = 0; l < qmodel->num_layers; l++) {
+        const qdense_layer_t* q = &qmodel->layers[l];
+        header.sizes[l + 1] = q->out;
+        header.input_scale[l] = q->input_scale;
+        ckpt_add_section(&header, data, CKPT_SEC_QWEIGHTS, CKPT_DTYPE_I8, l, q->weights, q->out * q->in_padded);
+        ckpt_add_section(&header, data, CKPT_SEC_QSCALE, CKPT_DTYPE_F32, l, q->weight_scale, q->out * sizeof(float));
+        ckpt_add_section(&header, data, CKPT_SEC_QBIAS, CKPT_DTYPE_F32, l, q->bias, q->out * sizeof(float));
+    }
+    
+    return ckpt_write(dev, lba, &header, data);
+}
+
+qmlp_t* checkpoint_load_qmlp(block_device_t* dev, uint32_t lba) {
+    ckpt_header_t header;
+    if (!checkpoint_probe(dev, lba, &header) || header.model_kind != CKPT_MODEL_QMLP) {
+        return 0;
+    }
+    
+    qmlp_t* qmodel = quant_alloc(header.sizes, header.num_sizes);
+    if (!qmodel) {
+        return 0;
+    }
+    for (uint32_t l = 0; l < qmodel->num_layers; l++) {
+        qdense_layer_t* q = &qmodel->layers[l];
+        q->input_scale = header.input_scale[l];
+        if (!ckpt_load_section(dev, lba, &header, CKPT_SEC_QWEIGHTS, l, q->weights, q->out * q->in_padded) ||
+            !ckpt_load_section(dev, lba, &header, CKPT_SEC_QSCALE, l, q->weight_scale, q->out * sizeof(float)) ||
+            !ckpt_load_section(dev, lba, &header, CKPT_SEC_QBIAS, l, q->bias, q->out * sizeof(float))) {
+            quant_destroy(qmodel);
+            return 0;
+        }
+    }
+    return qmodel;
+}
+
+void checkpoint_print(const ckpt_header_t* header) {
+    char sizes[(MLP_MAX_LAYERS + 1) * 11];
+    uint32_t len = 0;
+    
+    for (uint32_t i = 0; i < header->num_sizes && len < sizeof(sizes); i++) {
+        len += ksnprintf(sizes + len, sizeof(sizes) - len, i ? "-%u" : "%u", header->sizes[i]);
+    }
+    kprintf("Checkpoint: %s%s, epoch %u, %s%u KB\n",
+            header->model_kind == CKPT_MODEL_QMLP ? "int8 MLP " : "MLP ", sizes, header->epoch,
+            header->has_optimizer ? "with optimizer, " : "", header->total_sectors / 2);
+}
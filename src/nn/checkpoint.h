@@ -0,0 +1,100 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+#include "mlp.h"
+#include "quant.h"
+#include "optimizer.h"
+#include "../drivers/block.h"
+#include "../math/random.h"
+#include "../math/tune.h"
+
+// On-disk layout, starting at a sector boundary:
+//   sector 0    ckpt_header_t (model shape, optimizer scalars, epoch,
+//               section table, checksum), zero padded
+//   sector 1..  sections back to back, each starting on a sector
+//               boundary: raw float / int8 / u32 blobs in memory layout
+// Sections are read straight into the model's tensor memory, so loading
+// is one sequential pass over the disk with no staging copy. A checkpoint
+// must end before the last TUNE_SECTORS of the disk (the saved GEMM
+// tuning, math/tune.h).
+#define CKPT_MAGIC 0x4B434E4D      // "MNCK"
+#define CKPT_VERSION 1
+#define CKPT_MAX_SECTIONS 12
+
+// Default location: start of the first disk (the scratch disk from 'make run')
+#define CKPT_DEFAULT_LBA 0
+
+// Model kinds
+#define CKPT_MODEL_MLP 1
+#define CKPT_MODEL_QMLP 2
+
+// Section kinds
+#define CKPT_SEC_PARAMS 1           // mlp_t.params
+#define CKPT_SEC_OPT_M 2            // optimizer_t.m
+#define CKPT_SEC_OPT_V 3            // optimizer_t.v
+#define CKPT_SEC_RNG 4              // rng_t
+#define CKPT_SEC_QWEIGHTS 5         // qdense_layer_t.weights
+#define CKPT_SEC_QSCALE 6           // qdense_layer_t.weight_scale
+#define CKPT_SEC_QBIAS 7            // qdense_layer_t.bias
+
+// Element types
+#define CKPT_DTYPE_F32 1
+#define CKPT_DTYPE_I8 2
+#define CKPT_DTYPE_U32 3
+
+typedef struct {
+    uint32_t kind;
+    uint32_t dtype;
+    uint32_t layer;                 // Layer index for per-layer sections
+    uint32_t sector;                // Offset from the header sector
+    uint32_t bytes;
+    uint32_t checksum;
+} ckpt_section_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_checksum;       // Of this struct with this field zero
+    uint32_t total_sectors;         // Header included
+    uint32_t model_kind;
+    uint32_t num_sizes;
+    uint32_t sizes[MLP_MAX_LAYERS + 1];
+    float input_scale[MLP_MAX_LAYERS];  // Int8 models only
+    uint32_t epoch;
+    
+    // Optimizer scalars (has_optimizer = 0 when none was saved)
+    uint32_t has_optimizer;
+    uint32_t opt_type;
+    float lr, momentum, beta1, beta2, eps;
+    float beta1_pow, beta2_pow;
+    uint32_t opt_step;
+    
+    uint32_t num_sections;
+    ckpt_section_t sections[CKPT_MAX_SECTIONS];
+} ckpt_header_t;
+
+// Read and validate the header at lba. Returns 1 if a checkpoint of this
+// version is there.
+int checkpoint_probe(block_device_t* dev, uint32_t lba, ckpt_header_t* header);
+
+// Save a float model with optional training state (opt and rng may be 0).
+// The header is invalidated first and written last, so an interrupted
+// save never leaves a header that describes half-written data.
+int checkpoint_save_mlp(block_device_t* dev, uint32_t lba, const mlp_t* model,
+                        const optimizer_t* opt, const rng_t* rng, uint32_t epoch);
+
+// Create a model from a saved one. If opt is not 0 it receives a restored
+// optimizer (or 0 if none was saved); rng and epoch are restored when not
+// 0. Returns 0 if there is no valid checkpoint or memory runs out.
+mlp_t* checkpoint_load_mlp(block_device_t* dev, uint32_t lba, optimizer_t** opt,
+                           rng_t* rng, uint32_t* epoch);
+
+// Save / load an int8 model (weights stay int8 on disk)
+int checkpoint_save_qmlp(block_device_t* dev, uint32_t lba, const qmlp_t* qmodel);
+qmlp_t* checkpoint_load_qmlp(block_device_t* dev, uint32_t lba);
+
+// Print a one-line summary of a probed checkpoint
+void checkpoint_print(const ckpt_header_t* header);
+
+#endif
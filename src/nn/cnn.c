@@ -0,0 +1,247 @@
+#include "cnn.h"
+#include "activation.h"
+#include "../memory/memory.h"
+#include "../math/math.h"
+#include "../libc/string.h"
+#include <stdint.h>
+
+cnn_t* cnn_create(uint32_t max_batch) {
+    if (max_batch == 0) {
+        return 0;
+    }
+    
+    cnn_t* cnn = (cnn_t*)kmalloc(sizeof(cnn_t));
+    if (!cnn) {
+        return 0;
+    }
+    cnn->max_batch = max_batch;
+    cnn->params = 0;
+    cnn->grads = 0;
+    cnn->arena = 0;
+    
+    conv2d_init(&cnn->conv1, 1, MNIST_ROWS, MNIST_COLS, 6, 5, 1, 2);
+    maxpool2d_init(&cnn->pool1, 6, cnn->conv1.out_h, cnn->conv1.out_w, 2);
+    conv2d_init(&cnn->conv2, 6, cnn->pool1.out_h, cnn->pool1.out_w, 16, 5, 1, 0);
+    maxpool2d_init(&cnn->pool2, 16, cnn->conv2.out_h, cnn->conv2.out_w, 2);
+    
+    uint32_t sizes[3] = { CNN_FEATURES, CNN_HIDDEN, MNIST_CLASSES };
+    cnn->head = mlp_create(sizes, 3);
+    
+    // Pad each layer's block to 4 floats so both start 16-byte aligned
+    uint32_t p1 = (conv2d_num_params(&cnn->conv1) + 3) & ~3;
+    uint32_t p2 = (conv2d_num_params(&cnn->conv2) + 3) & ~3;
+    cnn->num_params = p1 + p2;
+    cnn->params = (float*)kmalloc(cnn->num_params * sizeof(float));
+    cnn->grads = (float*)kmalloc(cnn->num_params * sizeof(float));
+    
+    // Activations and their gradients (forward and backward buffers for
+    // each stage), plus the conv and pool workspaces
+    uint32_t c1 = cnn->conv1.out_c * cnn->conv1.out_h * cnn->conv1.out_w;
+    uint32_t q1 = cnn->pool1.channels * cnn->pool1.out_h * cnn->pool1.out_w;
+    uint32_t c2 = cnn->conv2.out_c * cnn->conv2.out_h * cnn->conv2.out_w;
+    uint32_t per_sample = MNIST_PIXELS + 2 * (c1 + q1 + c2 + CNN_FEATURES);
+    uint32_t bytes = max_batch * per_sample * sizeof(float) + 16 * 9
+                   + conv2d_workspace_bytes(&cnn->conv1, max_batch)
+                   + conv2d_workspace_bytes(&cnn->conv2, max_batch)
+                   + maxpool2d_workspace_bytes(&cnn->pool1, max_batch)
+                   + maxpool2d_workspace_bytes(&cnn->pool2, max_batch);
+    cnn->arena = arena_create(bytes);
+    
+    if (!cnn->head || !cnn->params || !cnn->grads || !cnn->arena) {
+        cnn_destroy(cnn);
+        return 0;
+    }
+    
+    conv2d_bind_params(&cnn->conv1, cnn->params, cnn->grads);
+    conv2d_bind_params(&cnn->conv2, cnn->params + p1, cnn->grads + p1);
+    memset(cnn->params, 0, cnn->num_params * sizeof(float));
+    memset(cnn->grads, 0, cnn->num_params * sizeof(float));
+    cnn->head->want_input_grad = 1;
+    
+    return cnn;
+}
+
+void cnn_destroy(cnn_t* cnn) {
+    if (!cnn) {
+        return;
+    }
+    arena_destroy(cnn->arena);
+    kfree(cnn->grads);
+    kfree(cnn->params);
+    mlp_destroy(cnn->head);
+    kfree(cnn);
+}
+
+static void conv_init_weights(conv2d_layer_t* layer, rng_t* rng) {
+    uint32_t fan_in = layer->in_c * layer->kernel * layer->kernel;
+    random_fill_normal(rng, layer->weights, layer->out_c * fan_in, 0.0f, k_sqrtf(2.0f / (float)fan_in));
+    for (uint32_t c = 0; c < layer->out_c; c++) {
+        layer->bias[c] = 0.0f;
+    }
+}
+
+void cnn_init_weights(cnn_t* cnn, rng_t* rng) {
+    conv_init_weights(&cnn->conv1, rng);
+    conv_init_weights(&cnn->conv2, rng);
+    mlp_init_weights(cnn->head, rng);
+}
+
+void cnn_zero_grads(cnn_t* cnn) {
+    memset(cnn->grads, 0, cnn->num_params * sizeof(float));
+    mlp_zero_grads(cnn->head);
+}
+
+// Conv stack over cnn->input; leaves batch x 400 features in pool2_out
+static int cnn_forward_features(cnn_t* cnn, uint32_t batch) {
+    arena_t* arena = cnn->arena;
+    uint32_t c1 = batch * cnn->conv1.out_c * cnn->conv1.out_h * cnn->conv1.out_w;
+    uint32_t q1 = batch * cnn->pool1.channels * cnn->pool1.out_h * cnn->pool1.out_w;
+    uint32_t c2 = batch * cnn->conv2.out_c * cnn->conv2.out_h * cnn->conv2.out_w;
+    
+    cnn->conv1_out = (float*)arena_alloc(arena, c1 * sizeof(float));
+    cnn->pool1_out = (float*)arena_alloc(arena, q1 * sizeof(float));
+    cnn->conv2_out = (float*)arena_alloc(arena, c2 * sizeof(float));
+    cnn->pool2_out = (float*)arena_alloc(arena, batch * CNN_FEATURES * sizeof(float));
+    if (!cnn->conv1_out || !cnn->pool1_out || !cnn->conv2_out || !cnn->pool2_out) {
+        return 0;
+    }
+    
+    if (!conv2d_forward(&cnn->conv1, arena, cnn->input, cnn->conv1_out, batch)) {
+        return 0;
+    }
+    relu_forward(cnn->conv1_out, c1);
+    if (!maxpool2d_forward(&cnn->pool1, arena, cnn->conv1_out, cnn->pool1_out, batch)) {
+        return 0;
+    }
+    if (!conv2d_forward(&cnn->conv2, arena, cnn->pool1_out, cnn->conv2_out, batch)) {
+        return 0;
+    }
+    relu_forward(cnn->conv2_out, c2);
+    return maxpool2d_forward(&cnn->pool2, arena, cnn->conv2_out, cnn->pool2_out, batch);
+}
+
+// Start a batch: reset the arena and convert images to [0, 1] floats
+static int cnn_begin_batch(cnn_t* cnn, uint32_t batch) {
+    arena_reset(cnn->arena);
+    cnn->input = (float*)arena_alloc(cnn->arena, batch * MNIST_PIXELS * sizeof(float));
+    return cnn->input != 0;
+}
+
+static void cnn_load_image(cnn_t* cnn, uint32_t b, const uint8_t* image) {
+    float* dst = cnn->input + b * MNIST_PIXELS;
+    for (uint32_t i = 0; i < MNIST_PIXELS; i++) {
+        dst[i] = (float)image[i] * (1.0f / 255.0f);
+    }
+}
+
+float cnn_train_batch(cnn_t* cnn, const mnist_set_t* set, const uint32_t* indices, uint32_t count) {
+    if (count > cnn->max_batch || !cnn_begin_batch(cnn, count)) {
+        return -1.0f;
+    }
+    for (uint32_t b = 0; b < count; b++) {
+        cnn_load_image(cnn, b, set->images + indices[b] * MNIST_PIXELS);
+    }
+    if (!cnn_forward_features(cnn, count)) {
+        return -1.0f;
+    }
+    
+    arena_t* arena = cnn->arena;
+    uint32_t c1 = count * cnn->conv1.out_c * cnn->conv1.out_h * cnn->conv1.out_w;
+    uint32_t q1 = count * cnn->pool1.channels * cnn->pool1.out_h * cnn->pool1.out_w;
+    uint32_t c2 = count * cnn->conv2.out_c * cnn->conv2.out_h * cnn->conv2.out_w;
+    float* d_pool2 = (float*)arena_alloc(arena, count * CNN_FEATURES * sizeof(float));
+    float* d_conv2 = (float*)arena_alloc(arena, c2 * sizeof(float));
+    float* d_pool1 = (float*)arena_alloc(arena, q1 * sizeof(float));
+    float* d_conv1 = (float*)arena_alloc(arena, c1 * sizeof(float));
+    if (!d_pool2 || !d_conv2 || !d_pool1 || !d_conv1) {
+        return -1.0f;
+    }
+    
+    // The head is small, so it runs per sample and hands back the
+    // feature gradients for the batched conv backward
+    float loss = 0.0f;
+    for (uint32_t b = 0; b < count; b++) {
+        mlp_load_dense(cnn->head, cnn->pool2_out + b * CNN_FEATURES);
+        mlp_forward(cnn->head);
+        loss += mlp_backward(cnn->head, set->labels[indices[b]]);
+        
+        memcpy(d_pool2 + b * CNN_FEATURES, cnn->head->deltas[0], CNN_FEATURES * sizeof(float));
+    }
+    
+    maxpool2d_backward(&cnn->pool2, d_pool2, d_conv2, count);
+    relu_backward(cnn->conv2_out, d_conv2, c2);
+    if (!conv2d_backward(&cnn->conv2, arena, d_conv2, d_pool1)) {
+        return -1.0f;
+    }
+    maxpool2d_backward(&cnn->pool1, d_pool1, d_conv1, count);
+    relu_backward(cnn->conv1_out, d_conv1, c1);
+    if (!conv2d_backward(&cnn->conv1, arena, d_conv1, 0)) {
+        return -1.0f;
+    }
+    return loss;
+}
+
+void cnn_train(cnn_t* cnn, optimizer_t* conv_opt, optimizer_t* head_opt,
+               const mnist_set_t* set, uint32_t batch_size, uint32_t steps, rng_t* rng) {
+    if (batch_size > cnn->max_batch) {
+        batch_size = cnn->max_batch;
+    }
+    uint32_t* order = (uint32_t*)kmalloc(set->count * sizeof(uint32_t));
+    if (!order || set->count < batch_size) {
+        kfree(order);
+        return;
+    }
+    for (uint32_t i = 0; i < set->count; i++) {
+        order[i] = i;
+    }
+    
+    uint32_t pos = set->count;
+    for (uint32_t step = 0; step < steps; step++) {
+        if (pos + batch_size > set->count) {
+            random_shuffle(rng, order, set->count);
+            pos = 0;
+        }
+        if (cnn_train_batch(cnn, set, order + pos, batch_size) < 0.0f) {
+            break;
+        }
+        pos += batch_size;
+        
+        optimizer_step(conv_opt, cnn->params, cnn->grads);
+        optimizer_step(head_opt, cnn->head->params, cnn->head->grads);
+    }
+    
+    kfree(order);
+}
+
+uint32_t cnn_predict(cnn_t* cnn, const uint8_t* image) {
+    if (!cnn_begin_batch(cnn, 1)) {
+        return 0;
+    }
+    cnn_load_image(cnn, 0, image);
+    if (!cnn_forward_features(cnn, 1)) {
+        return 0;
+    }
+    mlp_load_dense(cnn->head, cnn->pool2_out);
+    return argmax(mlp_forward(cnn->head), MNIST_CLASSES);
+}
+
+uint32_t cnn_evaluate(cnn_t* cnn, const uint8_t* images, const uint8_t* labels, uint32_t count) {
+    uint32_t correct = 0;
+    for (uint32_t first = 0; first < count; first += cnn->max_batch) {
+        uint32_t batch = count - first < cnn->max_batch ? count - first : cnn->max_batch;
+        if (!cnn_begin_batch(cnn, batch)) {
+            break;
+        }
+        for (uint32_t b = 0; b < batch; b++) {
+            cnn_load_image(cnn, b, images + (first + b) * MNIST_PIXELS);
+        }
+        if (!cnn_forward_features(cnn, batch)) {
+            break;
+        }
+        for (uint32_t b = 0; b < batch; b++) {
+            mlp_load_dense(cnn->head, cnn->pool2_out + b * CNN_FEATURES);
+            correct += (argmax(mlp_forward(cnn->head), MNIST_CLASSES) == labels[first + b]);
+        }
+    }
+    return correct;
+}
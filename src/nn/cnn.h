@@ -0,0 +1,71 @@
+#ifndef CNN_H
+#define CNN_H
+
+#include <stdint.h>
+#include "conv.h"
+#include "mlp.h"
+#include "mnist.h"
+#include "optimizer.h"
+#include "../memory/arena.h"
+#include "../math/random.h"
+
+// LeNet-class network for 28x28 digits:
+//   conv 1->6 5x5 pad 2, ReLU, pool 2 -> 6x14x14
+//   conv 6->16 5x5,      ReLU, pool 2 -> 16x5x5 = 400 features
+//   MLP head 400 -> 120 -> 10
+// Conv weights live in one flat params/grads pair (like mlp_t) and the
+// head is an ordinary mlp_t, so each half gets its own optimizer.
+// Every per-batch tensor comes from the arena, reset at each batch.
+#define CNN_FEATURES 400
+#define CNN_HIDDEN 120
+
+typedef struct {
+    conv2d_layer_t conv1;
+    maxpool2d_t pool1;
+    conv2d_layer_t conv2;
+    maxpool2d_t pool2;
+    mlp_t* head;
+    
+    uint32_t num_params;        // Conv weights and biases
+    float* params;
+    float* grads;
+    
+    uint32_t max_batch;
+    arena_t* arena;
+    
+    // Activations of the last forward pass (arena)
+    float* input;               // batch x 1 x 28 x 28
+    float* conv1_out;           // batch x 6 x 28 x 28, after ReLU
+    float* pool1_out;           // batch x 6 x 14 x 14
+    float* conv2_out;           // batch x 16 x 10 x 10, after ReLU
+    float* pool2_out;           // batch x 400
+} cnn_t;
+
+// Create a network that processes up to max_batch images per call.
+// Returns 0 on allocation failure.
+cnn_t* cnn_create(uint32_t max_batch);
+void cnn_destroy(cnn_t* cnn);
+
+// He-normal initialisation of conv and head weights, zero biases
+void cnn_init_weights(cnn_t* cnn, rng_t* rng);
+
+// Zero conv and head gradients
+void cnn_zero_grads(cnn_t* cnn);
+
+// Forward + backward over set images indices[0..count), count <= max_batch.
+// Gradients are summed over the batch; returns the summed loss, or a
+// negative value if the arena is too small.
+float cnn_train_batch(cnn_t* cnn, const mnist_set_t* set, const uint32_t* indices, uint32_t count);
+
+// 'steps' minibatches of shuffled training images, stepping conv_opt
+// over cnn->params and head_opt over cnn->head->params
+void cnn_train(cnn_t* cnn, optimizer_t* conv_opt, optimizer_t* head_opt,
+               const mnist_set_t* set, uint32_t batch_size, uint32_t steps, rng_t* rng);
+
+// Classify a 28x28 uint8 image
+uint32_t cnn_predict(cnn_t* cnn, const uint8_t* image);
+
+// Number of correctly classified images, run in batches of max_batch
+uint32_t cnn_evaluate(cnn_t* cnn, const uint8_t* images, const uint8_t* labels, uint32_t count);
+
+#endif
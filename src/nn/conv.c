@@ -0,0 +1,237 @@
+#include "conv.h"
+#include "../math/gemm.h"
+#include "../libc/string.h"
+#include <stdint.h>
+
+void conv2d_init(conv2d_layer_t* layer, uint32_t in_c, uint32_t in_h, uint32_t in_w,
+                 uint32_t out_c, uint32_t kernel, uint32_t stride, uint32_t pad) {
+    layer->in_c = in_c;
+    layer->in_h = in_h;
+    layer->in_w = in_w;
+    layer->out_c = out_c;
+    layer->kernel = kernel;
+    layer->stride = stride;
+    layer->pad = pad;
+    layer->out_h = (in_h + 2 * pad - kernel) / stride + 1;
+    layer->out_w = (in_w + 2 * pad - kernel) / stride + 1;
+    layer->weights = 0;
+    layer->bias = 0;
+    layer->grad_weights = 0;
+    layer->grad_bias = 0;
+    layer->col = 0;
+    layer->batch = 0;
+}
+
+uint32_t conv2d_num_params(const conv2d_layer_t* layer) {
+    return layer->out_c * layer->in_c * layer->kernel * layer->kernel + layer->out_c;
+}
+
+void conv2d_bind_params(conv2d_layer_t* layer, float* params, float* grads) {
+    uint32_t w_size = layer->out_c * layer->in_c * layer->kernel * layer->kernel;
+    layer->weights = params;
+    layer->bias = params + w_size;
+    layer->grad_weights = grads;
+    layer->grad_bias = grads + w_size;
+}
+
+// Round up to the arena's 16-byte granularity
+static uint32_t arena_size(uint32_t bytes) {
+    return (bytes + 15) & ~15;
+}
+
+uint32_t conv2d_workspace_bytes(const conv2d_layer_t* layer, uint32_t batch) {
+    uint32_t ckk = layer->in_c * layer->kernel * layer->kernel;
+    uint32_t cols = batch * layer->out_h * layer->out_w;
+    // Forward: patches + GEMM output; backward: gathered dy + patch gradient
+    return arena_size(ckk * cols * sizeof(float)) + arena_size(layer->out_c * cols * sizeof(float))
+         + arena_size(layer->out_c * cols * sizeof(float)) + arena_size(ckk * cols * sizeof(float));
+}
+
+// Unroll every kernel window of the batch into a column:
+// col[(c, ky, kx)][(b, oy, ox)] = x[b][c][oy * stride - pad + ky][ox * stride - pad + kx]
+static void im2col(const conv2d_layer_t* l, const float* x, float* col, uint32_t batch) {
+    uint32_t hw = l->out_h * l->out_w;
+    uint32_t cols = batch * hw;
+    uint32_t row = 0;
+    
+    for (uint32_t c = 0; c < l->in_c; c++) {
+        for (uint32_t ky = 0; ky < l->kernel; ky++) {
+            for (uint32_t kx = 0; kx < l->kernel; kx++, row++) {
+                float* dst = col + row * cols;
+                for (uint32_t b = 0; b < batch; b++) {
+                    const float* src = x + (b * l->in_c + c) * l->in_h * l->in_w;
+                    for (uint32_t oy = 0; oy < l->out_h; oy++) {
+                        int32_t iy = (int32_t)(oy * l->stride + ky) - (int32_t)l->pad;
+                        for (uint32_t ox = 0; ox < l->out_w; ox++) {
+                            int32_t ix = (int32_t)(ox * l->stride + kx) - (int32_t)l->pad;
+                            *dst++ = (iy >= 0 && iy < (int32_t)l->in_h && ix >= 0 && ix < (int32_t)l->in_w)
+                                   ? src[iy * l->in_w + ix] : 0.0f;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Inverse of im2col: scatter-add patch gradients back to the input
+static void col2im(const conv2d_layer_t* l, const float* col, float* x, uint32_t batch) {
+    uint32_t hw = l->out_h * l->out_w;
+    uint32_t cols = batch * hw;
+    uint32_t row = 0;
+    
+    memset(x, 0, batch * l->in_c * l->in_h * l->in_w * sizeof(float));
+    
+    for (uint32_t c = 0; c < l->in_c; c++) {
+        for (uint32_t ky = 0; ky < l->kernel; ky++) {
+            for (uint32_t kx = 0; kx < l->kernel; kx++, row++) {
+                const float* src = col + row * cols;
+                for (uint32_t b = 0; b < batch; b++) {
+                    float* dst = x + (b * l->in_c + c) * l->in_h * l->in_w;
+                    for (uint32_t oy = 0; oy < l->out_h; oy++) {
+                        int32_t iy = (int32_t)(oy * l->stride + ky) - (int32_t)l->pad;
+                        for (uint32_t ox = 0; ox < l->out_w; ox++, src++) {
+                            int32_t ix = (int32_t)(ox * l->stride + kx) - (int32_t)l->pad;
+                            if (iy >= 0 && iy < (int32_t)l->in_h && ix >= 0 && ix < (int32_t)l->in_w) {
+                                dst[iy * l->in_w + ix] += *src;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int conv2d_forward(conv2d_layer_t* layer, arena_t* arena, const float* x, float* y, uint32_t batch) {
+    uint32_t ckk = layer->in_c * layer->kernel * layer->kernel;
+    uint32_t hw = layer->out_h * layer->out_w;
+    uint32_t cols = batch * hw;
+    
+    layer->col = (float*)arena_alloc(arena, ckk * cols * sizeof(float));
+    float* out = (float*)arena_alloc(arena, layer->out_c * cols * sizeof(float));
+    if (!layer->col || !out) {
+        return 0;
+    }
+    layer->batch = batch;
+    
+    // out (out_c x cols) = W (out_c x ckk) * col (ckk x cols)
+    im2col(layer, x, layer->col, batch);
+    if (!sgemm(0, 0, layer->out_c, cols, ckk, 1.0f, layer->weights, ckk,
+               layer->col, cols, 0.0f, out, cols)) {
+        return 0;
+    }
+    
+    // Reorder channel-major GEMM output to NCHW and add bias
+    for (uint32_t b = 0; b < batch; b++) {
+        for (uint32_t c = 0; c < layer->out_c; c++) {
+            const float* src = out + c * cols + b * hw;
+            float* dst = y + (b * layer->out_c + c) * hw;
+            float bias = layer->bias[c];
+            for (uint32_t i = 0; i < hw; i++) {
+                dst[i] = src[i] + bias;
+            }
+        }
+    }
+    return 1;
+}
+
+int conv2d_backward(conv2d_layer_t* layer, arena_t* arena, const float* dy, float* dx) {
+    uint32_t batch = layer->batch;
+    uint32_t ckk = layer->in_c * layer->kernel * layer->kernel;
+    uint32_t hw = layer->out_h * layer->out_w;
+    uint32_t cols = batch * hw;
+    
+    float* dout = (float*)arena_alloc(arena, layer->out_c * cols * sizeof(float));
+    if (!dout) {
+        return 0;
+    }
+    
+    // Gather NCHW dy into channel-major rows, summing the bias gradient
+    for (uint32_t c = 0; c < layer->out_c; c++) {
+        float sum = 0.0f;
+        for (uint32_t b = 0; b < batch; b++) {
+            const float* src = dy + (b * layer->out_c + c) * hw;
+            float* dst = dout + c * cols + b * hw;
+            for (uint32_t i = 0; i < hw; i++) {
+                dst[i] = src[i];
+                sum += src[i];
+            }
+        }
+        layer->grad_bias[c] += sum;
+    }
+    
+    // dW (out_c x ckk) += dout (out_c x cols) * col^T
+    if (!sgemm(0, 1, layer->out_c, ckk, cols, 1.0f, dout, cols,
+               layer->col, cols, 1.0f, layer->grad_weights, ckk)) {
+        return 0;
+    }
+    
+    if (dx) {
+        // dcol (ckk x cols) = W^T * dout, then fold patches back
+        float* dcol = (float*)arena_alloc(arena, ckk * cols * sizeof(float));
+        if (!dcol) {
+            return 0;
+        }
+        if (!sgemm(1, 0, ckk, cols, layer->out_c, 1.0f, layer->weights, ckk,
+                   dout, cols, 0.0f, dcol, cols)) {
+            return 0;
+        }
+        col2im(layer, dcol, dx, batch);
+    }
+    return 1;
+}
+
+void maxpool2d_init(maxpool2d_t* pool, uint32_t channels, uint32_t in_h, uint32_t in_w, uint32_t size) {
+    pool->channels = channels;
+    pool->in_h = in_h;
+    pool->in_w = in_w;
+    pool->size = size;
+    pool->out_h = in_h / size;
+    pool->out_w = in_w / size;
+    pool->argmax = 0;
+}
+
+uint32_t maxpool2d_workspace_bytes(const maxpool2d_t* pool, uint32_t batch) {
+    return arena_size(batch * pool->channels * pool->out_h * pool->out_w * sizeof(uint32_t));
+}
+
+int maxpool2d_forward(maxpool2d_t* pool, arena_t* arena, const float* x, float* y, uint32_t batch) {
+    uint32_t planes = batch * pool->channels;
+    uint32_t in_plane = pool->in_h * pool->in_w;
+    
+    pool->argmax = (uint32_t*)arena_alloc(arena, planes * pool->out_h * pool->out_w * sizeof(uint32_t));
+    if (!pool->argmax) {
+        return 0;
+    }
+    
+    uint32_t o = 0;
+    for (uint32_t p = 0; p < planes; p++) {
+        const float* src = x + p * in_plane;
+        for (uint32_t oy = 0; oy < pool->out_h; oy++) {
+            for (uint32_t ox = 0; ox < pool->out_w; ox++, o++) {
+                uint32_t best = (oy * pool->size) * pool->in_w + ox * pool->size;
+                for (uint32_t ky = 0; ky < pool->size; ky++) {
+                    for (uint32_t kx = 0; kx < pool->size; kx++) {
+                        uint32_t i = (oy * pool->size + ky) * pool->in_w + ox * pool->size + kx;
+                        if (src[i] > src[best]) {
+                            best = i;
+                        }
+                    }
+                }
+                y[o] = src[best];
+                pool->argmax[o] = p * in_plane + best;
+            }
+        }
+    }
+    return 1;
+}
+
+void maxpool2d_backward(const maxpool2d_t* pool, const float* dy, float* dx, uint32_t batch) {
+    uint32_t outputs = batch * pool->channels * pool->out_h * pool->out_w;
+    
+    memset(dx, 0, batch * pool->channels * pool->in_h * pool->in_w * sizeof(float));
+    for (uint32_t o = 0; o < outputs; o++) {
+        dx[pool->argmax[o]] += dy[o];
+    }
+}
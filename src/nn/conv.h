@@ -0,0 +1,59 @@
+#ifndef CONV_H
+#define CONV_H
+
+#include <stdint.h>
+#include "../memory/arena.h"
+
+// 2D convolution lowered to GEMM with im2col. Tensors are NCHW; weights
+// are out_c x (in_c * kernel * kernel). A whole batch is unrolled into
+// one patch matrix so forward and both backward products are single
+// large GEMMs.
+typedef struct {
+    uint32_t in_c, in_h, in_w;
+    uint32_t out_c, out_h, out_w;
+    uint32_t kernel, stride, pad;
+    float* weights;             // out_c x (in_c * kernel * kernel)
+    float* bias;                // out_c
+    float* grad_weights;
+    float* grad_bias;
+    float* col;                 // Patch matrix from the last forward (arena)
+    uint32_t batch;             // Batch size of the last forward
+} conv2d_layer_t;
+
+// 2x2-style max pooling (window == stride). Forward records the index of
+// each maximum so backward is a scatter.
+typedef struct {
+    uint32_t channels;
+    uint32_t in_h, in_w;
+    uint32_t out_h, out_w;
+    uint32_t size;              // Window and stride
+    uint32_t* argmax;           // Input offset of each output's maximum (arena)
+} maxpool2d_t;
+
+// Set layer geometry (no memory is allocated)
+void conv2d_init(conv2d_layer_t* layer, uint32_t in_c, uint32_t in_h, uint32_t in_w,
+                 uint32_t out_c, uint32_t kernel, uint32_t stride, uint32_t pad);
+
+// Weights + biases, and binding them to (contiguous) caller storage
+uint32_t conv2d_num_params(const conv2d_layer_t* layer);
+void conv2d_bind_params(conv2d_layer_t* layer, float* params, float* grads);
+
+// Arena bytes one forward + backward pass needs for 'batch' samples
+uint32_t conv2d_workspace_bytes(const conv2d_layer_t* layer, uint32_t batch);
+
+// y = conv(x) + bias for a batch; patch buffers come from the arena and
+// stay valid for conv2d_backward. Returns 0 if the arena is full.
+int conv2d_forward(conv2d_layer_t* layer, arena_t* arena, const float* x, float* y, uint32_t batch);
+
+// Accumulate weight/bias gradients for dy and, if dx is not 0, write the
+// input gradient. Uses the batch and patches of the last forward.
+int conv2d_backward(conv2d_layer_t* layer, arena_t* arena, const float* dy, float* dx);
+
+void maxpool2d_init(maxpool2d_t* pool, uint32_t channels, uint32_t in_h, uint32_t in_w, uint32_t size);
+uint32_t maxpool2d_workspace_bytes(const maxpool2d_t* pool, uint32_t batch);
+int maxpool2d_forward(maxpool2d_t* pool, arena_t* arena, const float* x, float* y, uint32_t batch);
+
+// dx is fully overwritten (zero except at each window's maximum)
+void maxpool2d_backward(const maxpool2d_t* pool, const float* dy, float* dx, uint32_t batch);
+
+#endif
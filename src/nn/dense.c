@@ -0,0 +1,87 @@
+#include "dense.h"
+#include "../math/simd.h"
+#include <stdint.h>
+
+// y += a * w over n elements
+static inline void axpy(float* y, const float* w, float a, uint32_t n) {
+    v4sf va = v4sf_set1(a);
+    uint32_t j = 0;
+    
+    for (; j + 4 <= n; j += 4) {
+        v4sf_store(y + j, v4sf_load(y + j) + va * v4sf_load(w + j));
+    }
+    for (; j < n; j++) {
+        y[j] += a * w[j];
+    }
+}
+
+// Dot product of n elements
+static inline float dot(const float* a, const float* b, uint32_t n) {
+    v4sf acc = v4sf_set1(0.0f);
+    uint32_t j = 0;
+    
+    for (; j + 4 <= n; j += 4) {
+        acc += v4sf_load(a + j) * v4sf_load(b + j);
+    }
+    float sum = v4sf_hsum(acc);
+    for (; j < n; j++) {
+        sum += a[j] * b[j];
+    }
+    return sum;
+}
+
+void dense_forward(const dense_layer_t* layer, const float* x, float* y) {
+    uint32_t out = layer->out;
+    
+    for (uint32_t j = 0; j < out; j++) {
+        y[j] = layer->bias[j];
+    }
+    
+    const float* w = layer->weights;
+    for (uint32_t i = 0; i < layer->in; i++, w += out) {
+        axpy(y, w, x[i], out);
+    }
+}
+
+void dense_forward_sparse(const dense_layer_t* layer, const uint16_t* index,
+                          const float* value, uint32_t nnz, float* y) {
+    uint32_t out = layer->out;
+    
+    for (uint32_t j = 0; j < out; j++) {
+        y[j] = layer->bias[j];
+    }
+    
+    for (uint32_t k = 0; k < nnz; k++) {
+        axpy(y, layer->weights + index[k] * out, value[k], out);
+    }
+}
+
+void dense_backward(const dense_layer_t* layer, const float* x, const float* dy, float* dx) {
+    uint32_t out = layer->out;
+    
+    for (uint32_t j = 0; j < out; j++) {
+        layer->grad_bias[j] += dy[j];
+    }
+    
+    const float* w = layer->weights;
+    float* gw = layer->grad_weights;
+    for (uint32_t i = 0; i < layer->in; i++, w += out, gw += out) {
+        if (dx) {
+            dx[i] = dot(w, dy, out);
+        }
+        axpy(gw, dy, x[i], out);
+    }
+}
+
+void dense_backward_sparse(const dense_layer_t* layer, const uint16_t* index,
+                           const float* value, uint32_t nnz, const float* dy) {
+    uint32_t out = layer->out;
+    
+    for (uint32_t j = 0; j < out; j++) {
+        layer->grad_bias[j] += dy[j];
+    }
+    
+    for (uint32_t k = 0; k < nnz; k++) {
+        axpy(layer->grad_weights + index[k] * out, dy, value[k], out);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef DENSE_H
+#define DENSE_H
+
+#include <stdint.h>
+
+// Fully connected layer: y = x W + b
+// W is stored input-major (in x out): row i holds the weights fed by
+// input i, so a forward pass is a sequence of axpy updates over y.
+typedef struct {
+    uint32_t in;            // Input width
+    uint32_t out;           // Output width
+    float* weights;         // in x out
+    float* bias;            // out
+    float* grad_weights;    // Same layout as weights, accumulated by backward
+    float* grad_bias;       // out
+} dense_layer_t;
+
+// Sparse inputs are used when at most this percentage of inputs is nonzero
+#define DENSE_SPARSE_MAX_DENSITY_PCT 60
+
+// Forward pass for one sample
+void dense_forward(const dense_layer_t* layer, const float* x, float* y);
+
+// Forward pass for a sparse input given as nonzero index/value pairs.
+// Only the weight rows of nonzero inputs are read.
+void dense_forward_sparse(const dense_layer_t* layer, const uint16_t* index,
+                          const float* value, uint32_t nnz, float* y);
+
+// Backward pass: accumulate weight/bias gradients for output gradient dy
+// and, if dx is not 0, write the input gradient
+void dense_backward(const dense_layer_t* layer, const float* x, const float* dy, float* dx);
+
+// Backward pass for a sparse input: only the gradient rows of nonzero
+// inputs are updated (no input gradient, this is the first layer)
+void dense_backward_sparse(const dense_layer_t* layer, const uint16_t* index,
+                           const float* value, uint32_t nnz, const float* dy);
+
+#endif
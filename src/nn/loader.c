@@ -0,0 +1,253 @@
+#include "loader.h"
+#include "../cpu/cpu.h"
+#include "../kernel/trace.h"
+#include "../memory/memory.h"
+#include <stdint.h>
+
+static uint32_t read_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Batches filled and not yet handed out (a trace counter)
+static inline uint32_t loader_ready_count(const loader_t* loader) {
+    uint32_t ready = 0;
+    for (uint32_t b = 0; b < LOADER_BUFFERS; b++) {
+        ready += loader->buffers[b].ready;
+    }
+    return ready;
+}
+
+// Sectors spanned by a batch whose first byte is 'skip' into a sector
+static uint32_t batch_sectors(uint32_t skip, uint32_t batch_size) {
+    return (skip + batch_size * MNIST_PIXELS + BLOCK_SECTOR_SIZE - 1) / BLOCK_SECTOR_SIZE;
+}
+
+// Read the batch at window position 'first' into buf. All chunks are
+// queued at once (the elevator merges them into as few commands as the
+// device allows) and the thread sleeps until they complete, leaving the
+// CPU to the trainer.
+static void loader_read(loader_t* loader, loader_buffer_t* buf, uint32_t first) {
+    uint32_t offset = MNIST_IMAGE_HEADER_SIZE + first * MNIST_PIXELS;
+    uint32_t lba = loader->image_lba + offset / BLOCK_SECTOR_SIZE;
+    uint32_t skip = offset % BLOCK_SECTOR_SIZE;
+    uint32_t sectors = batch_sectors(skip, loader->batch_size);
+    TRACE_SCOPE(TRACE_EV_LOADER_READ, first);
+    
+    buf->set.count = loader->batch_size;
+    buf->set.images = buf->staging + skip;
+    buf->set.labels = loader->labels + first;
+    
+    uint32_t chunks = 0;
+    for (uint32_t done = 0; done < sectors; done += LOADER_CHUNK_SECTORS) {
+        block_request_t* req = &loader->requests[chunks++];
+        req->lba = lba + done;
+        req->count = sectors - done < LOADER_CHUNK_SECTORS ? sectors - done : LOADER_CHUNK_SECTORS;
+        req->buf = buf->staging + done * BLOCK_SECTOR_SIZE;
+        req->write = 0;
+        req->done = 0;
+        req->ctx = 0;
+        if (!block_submit(loader->dev, req)) {
+            req->status = BLOCK_REQ_ERROR;
+        }
+    }
+    for (uint32_t c = 0; c < chunks; c++) {
+        if (!block_wait(&loader->requests[c])) {
+            buf->set.count = 0;
+        }
+    }
+}
+
+static void loader_thread(void* arg) {
+    loader_t* loader = (loader_t*)arg;
+    
+    while (!loader->stop) {
+        loader_buffer_t* buf = &loader->buffers[loader->fill];
+        
+        // Wait for the trainer to hand this buffer back
+        uint32_t flags = cpu_irq_save();
+        while (buf->ready && !loader->stop) {
+            loader->filler_waiting = 1;
+            thread_block();
+        }
+        loader->filler_waiting = 0;
+        cpu_irq_restore(flags);
+        if (loader->stop) {
+            break;
+        }
+        
+        if (loader->next_window == loader->num_windows) {
+            random_shuffle(loader->rng, loader->windows, loader->num_windows);
+            loader->next_window = 0;
+        }
+        loader_read(loader, buf, loader->windows[loader->next_window++] * loader->batch_size);
+        
+        flags = cpu_irq_save();
+        buf->ready = 1;
+        loader->fill = (loader->fill + 1) % LOADER_BUFFERS;
+        TRACE_COUNTER(TRACE_EV_LOADER_READY, loader_ready_count(loader));
+        if (loader->waiter) {
+            thread_wake(loader->waiter);
+        }
+        cpu_irq_restore(flags);
+    }
+    
+    loader->exited = 1;
+    if (loader->waiter) {
+        thread_wake(loader->waiter);
+    }
+}
+
+loader_t* loader_create(block_device_t* dev, uint32_t image_lba, uint32_t label_lba,
+                        uint32_t batch_size, rng_t* rng) {
+    uint8_t header[BLOCK_SECTOR_SIZE];
+    if (!dev || batch_size == 0 || !block_read(dev, label_lba, 1, header)) {
+        return 0;
+    }
+    
+    // The label file is small (60KB for the training set); keep all of it
+    if (read_be32(header) != MNIST_LABEL_MAGIC) {
+        return 0;
+    }
+    uint32_t label_count = read_be32(header + 4);
+    uint32_t label_size = MNIST_LABEL_HEADER_SIZE + label_count;
+    uint8_t* label_file = (uint8_t*)kmalloc(label_size);
+    if (!label_file || !block_read_bytes(dev, label_lba, label_file, label_size)
+        || !block_read(dev, image_lba, 1, header)) {
+        kfree(label_file);
+        return 0;
+    }
+    
+    // Validate both headers; the image file is clipped to the device
+    mnist_set_t set;
+    uint32_t image_size = MNIST_IMAGE_HEADER_SIZE + read_be32(header + 4) * MNIST_PIXELS;
+    uint32_t device_bytes = (dev->sector_count - image_lba) * BLOCK_SECTOR_SIZE;
+    if (image_lba >= dev->sector_count
+        || !mnist_parse(&set, header, image_size < device_bytes ? image_size : device_bytes,
+                        label_file, label_size)
+        || set.count < batch_size) {
+        kfree(label_file);
+        return 0;
+    }
+    
+    loader_t* loader = (loader_t*)kmalloc(sizeof(loader_t));
+    if (!loader) {
+        kfree(label_file);
+        return 0;
+    }
+    loader->dev = dev;
+    loader->image_lba = image_lba;
+    loader->batch_size = batch_size;
+    loader->count = set.count;
+    loader->label_file = label_file;
+    loader->labels = label_file + MNIST_LABEL_HEADER_SIZE;
+    loader->num_windows = set.count / batch_size;
+    loader->next_window = loader->num_windows;
+    loader->rng = rng;
+    loader->fill = 0;
+    loader->consume = 0;
+    loader->outstanding = 0;
+    loader->thread = 0;
+    loader->waiter = 0;
+    loader->filler_waiting = 0;
+    loader->stop = 0;
+    loader->exited = 0;
+    
+    loader->indices = (uint32_t*)kmalloc(batch_size * sizeof(uint32_t));
+    loader->windows = (uint32_t*)kmalloc(loader->num_windows * sizeof(uint32_t));
+    uint32_t max_sectors = batch_sectors(BLOCK_SECTOR_SIZE - 1, batch_size);
+    uint32_t staging_size = max_sectors * BLOCK_SECTOR_SIZE;
+    loader->requests = (block_request_t*)kmalloc(
+        (max_sectors + LOADER_CHUNK_SECTORS - 1) / LOADER_CHUNK_SECTORS * sizeof(block_request_t));
+    int ok = loader->indices && loader->windows && loader->requests;
+    for (uint32_t b = 0; b < LOADER_BUFFERS; b++) {
+        loader->buffers[b].staging = (uint8_t*)kmalloc(staging_size);
+        loader->buffers[b].ready = 0;
+        ok = ok && loader->buffers[b].staging;
+    }
+    if (!ok) {
+        loader->exited = 1;
+        loader_destroy(loader);
+        return 0;
+    }
+    
+    for (uint32_t i = 0; i < batch_size; i++) {
+        loader->indices[i] = i;
+    }
+    for (uint32_t w = 0; w < loader->num_windows; w++) {
+        loader->windows[w] = w;
+    }
+    
+    loader->thread = thread_create("loader", loader_thread, loader);
+    if (!loader->thread) {
+        loader->exited = 1;
+        loader_destroy(loader);
+        return 0;
+    }
+    return loader;
+}
+
+void loader_destroy(loader_t* loader) {
+    if (!loader) {
+        return;
+    }
+    
+    // Stop the thread and wait until it is off our buffers
+    uint32_t flags = cpu_irq_save();
+    loader->stop = 1;
+    if (loader->thread && loader->filler_waiting) {
+        thread_wake(loader->thread);
+    }
+    while (!loader->exited) {
+        loader->waiter = thread_current();
+        thread_block();
+    }
+    loader->waiter = 0;
+    cpu_irq_restore(flags);
+    
+    for (uint32_t b = 0; b < LOADER_BUFFERS; b++) {
+        kfree(loader->buffers[b].staging);
+    }
+    kfree(loader->requests);
+    kfree(loader->windows);
+    kfree(loader->indices);
+    kfree(loader->label_file);
+    kfree(loader);
+}
+
+const mnist_set_t* loader_next(loader_t* loader) {
+    uint32_t flags = cpu_irq_save();
+    
+    // Recycle the batch handed out last time
+    if (loader->outstanding) {
+        loader->buffers[loader->consume].ready = 0;
+        loader->consume = (loader->consume + 1) % LOADER_BUFFERS;
+        loader->outstanding = 0;
+        TRACE_COUNTER(TRACE_EV_LOADER_READY, loader_ready_count(loader));
+        if (loader->filler_waiting) {
+            thread_wake(loader->thread);
+        }
+    }
+    
+    // The trainer outran the disk: this wait is the stall to look for
+    loader_buffer_t* buf = &loader->buffers[loader->consume];
+    if (!buf->ready) {
+        TRACE_BEGIN(TRACE_EV_LOADER_WAIT, 0);
+        while (!buf->ready && !loader->exited) {
+            loader->waiter = thread_current();
+            thread_block();
+        }
+        TRACE_END(TRACE_EV_LOADER_WAIT, 0);
+    }
+    loader->waiter = 0;
+    cpu_irq_restore(flags);
+    
+    if (!buf->ready) {
+        return 0;
+    }
+    loader->outstanding = 1;
+    return &buf->set;
+}
+
+const uint32_t* loader_indices(const loader_t* loader) {
+    return loader->indices;
+}
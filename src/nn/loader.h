@@ -0,0 +1,72 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdint.h>
+#include "mnist.h"
+#include "../drivers/block.h"
+#include "../kernel/thread.h"
+#include "../math/random.h"
+
+// Batches in flight: one being trained on, one being read
+#define LOADER_BUFFERS 2
+
+// Sectors per queued read request
+#define LOADER_CHUNK_SECTORS 32
+
+typedef struct {
+    uint8_t* staging;           // Raw sectors covering the batch's images
+    mnist_set_t set;            // View of the batch (images/labels into staging)
+    volatile uint8_t ready;
+} loader_buffer_t;
+
+// Streams training batches from MNIST IDX files on a block device. A
+// kernel thread reads batch N+1 into the spare buffer while the caller
+// trains on batch N. Each batch is a run of consecutive images at a
+// shuffled batch-aligned position (one contiguous read per batch); the
+// order of positions is reshuffled every epoch.
+typedef struct {
+    block_device_t* dev;
+    uint32_t image_lba;
+    uint32_t batch_size;
+    uint32_t count;             // Images available
+    uint8_t* label_file;        // Whole label file, kept in memory
+    const uint8_t* labels;
+    uint32_t* indices;          // 0 .. batch_size - 1, for the trainer
+    block_request_t* requests;  // One per chunk of the batch being read
+    
+    uint32_t* windows;          // Shuffled batch start positions
+    uint32_t num_windows;
+    uint32_t next_window;
+    rng_t* rng;
+    
+    loader_buffer_t buffers[LOADER_BUFFERS];
+    uint32_t fill;              // Buffer the loader thread writes next
+    uint32_t consume;           // Buffer handed to the trainer next
+    uint8_t outstanding;        // Trainer still holds buffers[consume]
+    
+    thread_t* thread;
+    thread_t* volatile waiter;  // Trainer blocked in loader_next
+    volatile uint8_t filler_waiting;
+    volatile uint8_t stop;
+    volatile uint8_t exited;
+} loader_t;
+
+// Open image/label IDX files starting at the given LBAs and start the
+// loader thread. Returns 0 on a bad header, too few images, or
+// allocation failure.
+loader_t* loader_create(block_device_t* dev, uint32_t image_lba, uint32_t label_lba,
+                        uint32_t batch_size, rng_t* rng);
+
+// Stop the thread and free everything
+void loader_destroy(loader_t* loader);
+
+// Next batch, waiting for it if the read has not finished. The batch
+// stays valid until the following call, which recycles its buffer. A
+// batch with count 0 means the read failed; 0 is returned once the
+// loader thread has stopped.
+const mnist_set_t* loader_next(loader_t* loader);
+
+// Identity index list for passing a whole batch to the trainer
+const uint32_t* loader_indices(const loader_t* loader);
+
+#endif
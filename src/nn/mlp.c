@@ -0,0 +1,259 @@
+#include "mlp.h"
+#include "activation.h"
+#include "../memory/memory.h"
+#include "../math/math.h"
+#include "../math/simd.h"
+#include "../math/vmath.h"
+#include "../libc/string.h"
+#include <stdint.h>
+
+mlp_t* mlp_create(const uint32_t* sizes, uint32_t num_sizes) {
+    if (num_sizes < 2 || num_sizes - 1 > MLP_MAX_LAYERS) {
+        return 0;
+    }
+    
+    mlp_t* model = (mlp_t*)kmalloc(sizeof(mlp_t));
+    if (!model) {
+        return 0;
+    }
+    model->num_layers = num_sizes - 1;
+    model->params = 0;
+    model->grads = 0;
+    model->owns_params = 1;
+    model->input_index = 0;
+    model->input_value = 0;
+    
+    // Count parameters and activation storage; pad every array to a
+    // multiple of 4 floats so each one starts 16-byte aligned
+    uint32_t num_params = 0;
+    uint32_t num_acts = 0;
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        num_params += (sizes[l] * sizes[l + 1] + 3) & ~3;
+        num_params += (sizes[l + 1] + 3) & ~3;
+    }
+    for (uint32_t l = 0; l < num_sizes; l++) {
+        num_acts += (sizes[l] + 3) & ~3;
+    }
+    
+    model->num_params = num_params;
+    model->params = (float*)kmalloc(num_params * sizeof(float));
+    model->grads = (float*)kmalloc(num_params * sizeof(float));
+    float* acts = (float*)kmalloc(2 * num_acts * sizeof(float));
+    model->input_index = (uint16_t*)kmalloc(sizes[0] * sizeof(uint16_t));
+    model->input_value = (float*)kmalloc(sizes[0] * sizeof(float));
+    model->activations[0] = acts;
+    if (!model->params || !model->grads || !acts || !model->input_index || !model->input_value) {
+        mlp_destroy(model);
+        return 0;
+    }
+    
+    float* p = model->params;
+    float* g = model->grads;
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        dense_layer_t* layer = &model->layers[l];
+        uint32_t w_size = (sizes[l] * sizes[l + 1] + 3) & ~3;
+        uint32_t b_size = (sizes[l + 1] + 3) & ~3;
+        layer->in = sizes[l];
+        layer->out = sizes[l + 1];
+        layer->weights = p;
+        layer->grad_weights = g;
+        layer->bias = p + w_size;
+        layer->grad_bias = g + w_size;
+        p += w_size + b_size;
+        g += w_size + b_size;
+    }
+    for (uint32_t l = 0; l < num_sizes; l++) {
+        uint32_t size = (sizes[l] + 3) & ~3;
+        model->activations[l] = acts;
+        model->deltas[l] = acts + size;
+        acts += 2 * size;
+    }
+    
+    memset(model->params, 0, num_params * sizeof(float));
+    memset(model->grads, 0, num_params * sizeof(float));
+    model->input_nnz = 0;
+    model->input_dense_valid = 0;
+    model->input_sparse = 0;
+    model->want_input_grad = 0;
+    model->owns_params = 1;
+    
+    return model;
+}
+
+mlp_t* mlp_create_replica(mlp_t* master) {
+    uint32_t sizes[MLP_MAX_LAYERS + 1];
+    sizes[0] = master->layers[0].in;
+    for (uint32_t l = 0; l < master->num_layers; l++) {
+        sizes[l + 1] = master->layers[l].out;
+    }
+    
+    mlp_t* replica = mlp_create(sizes, master->num_layers + 1);
+    if (!replica) {
+        return 0;
+    }
+    kfree(replica->params);
+    replica->params = master->params;
+    replica->owns_params = 0;
+    for (uint32_t l = 0; l < replica->num_layers; l++) {
+        replica->layers[l].weights = master->layers[l].weights;
+        replica->layers[l].bias = master->layers[l].bias;
+    }
+    return replica;
+}
+
+void mlp_destroy(mlp_t* model) {
+    if (!model) {
+        return;
+    }
+    kfree(model->activations[0]);
+    kfree(model->input_index);
+    kfree(model->input_value);
+    kfree(model->grads);
+    if (model->owns_params) {
+        kfree(model->params);
+    }
+    kfree(model);
+}
+
+void mlp_init_weights(mlp_t* model, rng_t* rng) {
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        dense_layer_t* layer = &model->layers[l];
+        float stddev = k_sqrtf(2.0f / (float)layer->in);
+        random_fill_normal(rng, layer->weights, layer->in * layer->out, 0.0f, stddev);
+        for (uint32_t j = 0; j < layer->out; j++) {
+            layer->bias[j] = 0.0f;
+        }
+    }
+}
+
+void mlp_load_image(mlp_t* model, const uint8_t* image) {
+    // Build the dense and compressed forms in the same pass
+    float* x = model->activations[0];
+    uint32_t nnz = 0;
+    for (uint32_t i = 0; i < MNIST_PIXELS; i++) {
+        float v = (float)image[i] * (1.0f / 255.0f);
+        x[i] = v;
+        if (image[i]) {
+            model->input_index[nnz] = (uint16_t)i;
+            model->input_value[nnz] = v;
+            nnz++;
+        }
+    }
+    model->input_nnz = nnz;
+    model->input_dense_valid = 1;
+}
+
+void mlp_load_sparse(mlp_t* model, const uint16_t* index, const float* value, uint32_t nnz) {
+    for (uint32_t k = 0; k < nnz; k++) {
+        model->input_index[k] = index[k];
+        model->input_value[k] = value[k];
+    }
+    model->input_nnz = nnz;
+    model->input_dense_valid = 0;
+}
+
+void mlp_load_dense(mlp_t* model, const float* x) {
+    float* dst = model->activations[0];
+    uint32_t nnz = 0;
+    for (uint32_t i = 0; i < model->layers[0].in; i++) {
+        dst[i] = x[i];
+        if (x[i] != 0.0f) {
+            model->input_index[nnz] = (uint16_t)i;
+            model->input_value[nnz] = x[i];
+            nnz++;
+        }
+    }
+    model->input_nnz = nnz;
+    model->input_dense_valid = 1;
+}
+
+// Expand the compressed input into activations[0] for the dense path
+static void mlp_densify_input(mlp_t* model) {
+    float* x = model->activations[0];
+    memset(x, 0, model->layers[0].in * sizeof(float));
+    for (uint32_t k = 0; k < model->input_nnz; k++) {
+        x[model->input_index[k]] = model->input_value[k];
+    }
+    model->input_dense_valid = 1;
+}
+
+float* mlp_forward(mlp_t* model) {
+    dense_layer_t* first = &model->layers[0];
+    
+    // The first layer costs one weight row per input used, so skip the
+    // zero inputs when there are enough of them to pay for the indexing
+    model->input_sparse = model->input_nnz * 100 <= first->in * DENSE_SPARSE_MAX_DENSITY_PCT;
+    if (model->input_sparse) {
+        dense_forward_sparse(first, model->input_index, model->input_value,
+                             model->input_nnz, model->activations[1]);
+    } else {
+        if (!model->input_dense_valid) {
+            mlp_densify_input(model);
+        }
+        dense_forward(first, model->activations[0], model->activations[1]);
+    }
+    
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        dense_layer_t* layer = &model->layers[l];
+        if (l > 0) {
+            dense_forward(layer, model->activations[l], model->activations[l + 1]);
+        }
+        
+        // ReLU on hidden layers, raw logits on the output
+        if (l + 1 < model->num_layers) {
+            relu_forward(model->activations[l + 1], layer->out);
+        }
+    }
+    return model->activations[model->num_layers];
+}
+
+float mlp_backward(mlp_t* model, uint32_t label) {
+    uint32_t last = model->num_layers;
+    uint32_t classes = model->layers[last - 1].out;
+    float* delta = model->deltas[last];
+    
+    // Softmax cross-entropy: dL/dlogits = softmax - onehot(label)
+    softmax(model->activations[last], delta, classes);
+    float p = delta[label] > 1e-30f ? delta[label] : 1e-30f;
+    float loss = -v4sf_log(v4sf_set1(p))[0];
+    delta[label] -= 1.0f;
+    
+    for (uint32_t l = last - 1; l > 0; l--) {
+        dense_backward(&model->layers[l], model->activations[l], model->deltas[l + 1], model->deltas[l]);
+        relu_backward(model->activations[l], model->deltas[l], model->layers[l].in);
+    }
+    
+    // Unless a layer below asked for it the input needs no gradient, and
+    // a sparse input only touches the gradient rows of its nonzero pixels
+    if (model->want_input_grad) {
+        if (!model->input_dense_valid) {
+            mlp_densify_input(model);
+        }
+        dense_backward(&model->layers[0], model->activations[0], model->deltas[1], model->deltas[0]);
+    } else if (model->input_sparse) {
+        dense_backward_sparse(&model->layers[0], model->input_index, model->input_value,
+                              model->input_nnz, model->deltas[1]);
+    } else {
+        dense_backward(&model->layers[0], model->activations[0], model->deltas[1], 0);
+    }
+    
+    return loss;
+}
+
+void mlp_zero_grads(mlp_t* model) {
+    memset(model->grads, 0, model->num_params * sizeof(float));
+}
+
+uint32_t mlp_predict(mlp_t* model, const uint8_t* image) {
+    mlp_load_image(model, image);
+    float* logits = mlp_forward(model);
+    return argmax(logits, model->layers[model->num_layers - 1].out);
+}
+
+uint32_t mlp_evaluate(mlp_t* model, const uint8_t* images, const uint8_t* labels, uint32_t count) {
+    uint32_t correct = 0;
+    for (uint32_t n = 0; n < count; n++) {
+        correct += (mlp_predict(model, images + n * MNIST_PIXELS) == labels[n]);
+    }
+    return correct;
+}
@@ -0,0 +1,74 @@
+#ifndef MLP_H
+#define MLP_H
+
+#include <stdint.h>
+#include "dense.h"
+#include "mnist.h"
+#include "../math/random.h"
+
+#define MLP_MAX_LAYERS 4
+
+// Multi-layer perceptron: dense layers with ReLU between them. All weights
+// and biases live in one contiguous params array (and their gradients in
+// grads, same layout) so optimizers and checkpoints can treat the model
+// as a single flat vector.
+typedef struct {
+    uint32_t num_layers;
+    dense_layer_t layers[MLP_MAX_LAYERS];
+    uint32_t num_params;
+    float* params;                              // All weights and biases
+    float* grads;                               // Gradients of params
+    float* activations[MLP_MAX_LAYERS + 1];     // activations[0] = input
+    float* deltas[MLP_MAX_LAYERS + 1];          // Loss gradient per activation
+    
+    // Input in compressed nonzero form, filled by both loaders
+    uint16_t* input_index;
+    float* input_value;
+    uint32_t input_nnz;
+    uint8_t input_dense_valid;  // activations[0] holds the input too
+    uint8_t input_sparse;       // Last forward pass used the sparse path
+    uint8_t want_input_grad;    // mlp_backward also writes deltas[0]
+    uint8_t owns_params;        // 0 for replicas sharing another model's params
+} mlp_t;
+
+// Create a model from layer widths, e.g. {784, 128, 10}. Returns 0 on
+// allocation failure or if there are too many layers.
+mlp_t* mlp_create(const uint32_t* sizes, uint32_t num_sizes);
+void mlp_destroy(mlp_t* model);
+
+// A model with its own activations and gradients that reads (and, under
+// Hogwild training, writes) the master's parameters. The master must
+// outlive it. Returns 0 on allocation failure.
+mlp_t* mlp_create_replica(mlp_t* master);
+
+// He-normal weight initialisation, zero biases
+void mlp_init_weights(mlp_t* model, rng_t* rng);
+
+// Load a 28x28 uint8 image, scaled to [0, 1]
+void mlp_load_image(mlp_t* model, const uint8_t* image);
+
+// Load an image already in compressed nonzero form (see mnist_sparsify)
+void mlp_load_sparse(mlp_t* model, const uint16_t* index, const float* value, uint32_t nnz);
+
+// Load an arbitrary float input (e.g. features from a conv stack)
+void mlp_load_dense(mlp_t* model, const float* x);
+
+// Forward pass from the loaded input; returns the output logits. The
+// first layer runs sparse or dense depending on input density.
+float* mlp_forward(mlp_t* model);
+
+// Backward pass after mlp_forward: softmax cross-entropy against label.
+// Accumulates into grads and returns the loss. With want_input_grad set,
+// the loss gradient w.r.t. the input is left in deltas[0].
+float mlp_backward(mlp_t* model, uint32_t label);
+
+// Zero all gradients
+void mlp_zero_grads(mlp_t* model);
+
+// Classify a 28x28 uint8 image
+uint32_t mlp_predict(mlp_t* model, const uint8_t* image);
+
+// Number of correctly classified images in a labelled set
+uint32_t mlp_evaluate(mlp_t* model, const uint8_t* images, const uint8_t* labels, uint32_t count);
+
+#endif
@@ -0,0 +1,107 @@
+#include "mnist.h"
+#include "../memory/memory.h"
+#include "../math/simd.h"
+#include <stdint.h>
+
+// Read a big-endian 32-bit value
+static uint32_t read_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+int mnist_parse(mnist_set_t* set, const uint8_t* image_file, uint32_t image_size,
+                const uint8_t* label_file, uint32_t label_size) {
+    if (image_size < MNIST_IMAGE_HEADER_SIZE || label_size < MNIST_LABEL_HEADER_SIZE) {
+        return 0;
+    }
+    if (read_be32(image_file) != MNIST_IMAGE_MAGIC || read_be32(label_file) != MNIST_LABEL_MAGIC) {
+        return 0;
+    }
+    
+    uint32_t count = read_be32(image_file + 4);
+    uint32_t rows = read_be32(image_file + 8);
+    uint32_t cols = read_be32(image_file + 12);
+    if (rows != MNIST_ROWS || cols != MNIST_COLS || read_be32(label_file + 4) != count) {
+        return 0;
+    }
+    
+    // Allow truncated files: use as many complete images/labels as present
+    uint32_t images_present = (image_size - MNIST_IMAGE_HEADER_SIZE) / MNIST_PIXELS;
+    uint32_t labels_present = label_size - MNIST_LABEL_HEADER_SIZE;
+    if (images_present < count) count = images_present;
+    if (labels_present < count) count = labels_present;
+    
+    set->count = count;
+    set->images = image_file + MNIST_IMAGE_HEADER_SIZE;
+    set->labels = label_file + MNIST_LABEL_HEADER_SIZE;
+    return 1;
+}
+
+mnist_sparse_batch_t* mnist_sparse_create(uint32_t max_images) {
+    mnist_sparse_batch_t* batch = (mnist_sparse_batch_t*)kmalloc(sizeof(mnist_sparse_batch_t));
+    if (!batch) {
+        return 0;
+    }
+    
+    batch->count = 0;
+    batch->max_images = max_images;
+    batch->offsets = (uint32_t*)kmalloc((max_images + 1) * sizeof(uint32_t));
+    batch->index = (uint16_t*)kmalloc(max_images * MNIST_PIXELS * sizeof(uint16_t));
+    batch->value = (float*)kmalloc(max_images * MNIST_PIXELS * sizeof(float));
+    batch->labels = (uint8_t*)kmalloc(max_images);
+    if (!batch->offsets || !batch->index || !batch->value || !batch->labels) {
+        mnist_sparse_destroy(batch);
+        return 0;
+    }
+    batch->offsets[0] = 0;
+    return batch;
+}
+
+void mnist_sparse_destroy(mnist_sparse_batch_t* batch) {
+    if (!batch) {
+        return;
+    }
+    kfree(batch->offsets);
+    kfree(batch->index);
+    kfree(batch->value);
+    kfree(batch->labels);
+    kfree(batch);
+}
+
+// Scan 16 pixels at a time: pcmpeqb/pmovmskb give a bitmask of the
+// nonzero bytes, so all-zero runs (most of the image border) cost one
+// compare per 16 pixels.
+uint32_t mnist_sparsify(const uint8_t* image, uint16_t* index, float* value) {
+    const v16qi zero = {0};
+    uint32_t nnz = 0;
+    
+    for (uint32_t i = 0; i < MNIST_PIXELS; i += 16) {
+        v16qi px = *(const v16qi_u*)(image + i);
+        uint32_t mask = ~__builtin_ia32_pmovmskb128(px == zero) & 0xFFFF;
+        
+        while (mask) {
+            uint32_t bit = __builtin_ctz(mask);
+            mask &= mask - 1;
+            index[nnz] = (uint16_t)(i + bit);
+            value[nnz] = (float)image[i + bit] * (1.0f / 255.0f);
+            nnz++;
+        }
+    }
+    return nnz;
+}
+
+void mnist_sparse_fill(mnist_sparse_batch_t* batch, const mnist_set_t* set,
+                       const uint32_t* indices, uint32_t first, uint32_t count) {
+    if (count > batch->max_images) {
+        count = batch->max_images;
+    }
+    
+    uint32_t offset = 0;
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t n = indices ? indices[first + k] : first + k;
+        offset += mnist_sparsify(set->images + n * MNIST_PIXELS,
+                                 batch->index + offset, batch->value + offset);
+        batch->offsets[k + 1] = offset;
+        batch->labels[k] = set->labels[n];
+    }
+    batch->count = count;
+}
@@ -0,0 +1,53 @@
+#ifndef MNIST_H
+#define MNIST_H
+
+#include <stdint.h>
+
+// MNIST image geometry
+#define MNIST_ROWS 28
+#define MNIST_COLS 28
+#define MNIST_PIXELS (MNIST_ROWS * MNIST_COLS)
+#define MNIST_CLASSES 10
+
+// IDX file magic numbers (big endian in the file)
+#define MNIST_IMAGE_MAGIC 0x00000803
+#define MNIST_LABEL_MAGIC 0x00000801
+#define MNIST_IMAGE_HEADER_SIZE 16
+#define MNIST_LABEL_HEADER_SIZE 8
+
+// A parsed image/label set. Points into the caller's IDX buffers.
+typedef struct {
+    uint32_t count;
+    const uint8_t* images;      // count x MNIST_PIXELS
+    const uint8_t* labels;      // count
+} mnist_set_t;
+
+// A batch of images in compressed nonzero form (CSR over images).
+// Image k's nonzeros are index/value[offsets[k] .. offsets[k + 1]).
+typedef struct {
+    uint32_t count;             // Images currently in the batch
+    uint32_t max_images;
+    uint32_t* offsets;          // max_images + 1
+    uint16_t* index;            // Pixel index of each nonzero
+    float* value;               // Pixel value scaled to [0, 1]
+    uint8_t* labels;            // Label of each image
+} mnist_sparse_batch_t;
+
+// Validate IDX headers and fill in 'set'. Returns 1 on success, 0 if the
+// buffers are not matching MNIST image/label files.
+int mnist_parse(mnist_set_t* set, const uint8_t* image_file, uint32_t image_size,
+                const uint8_t* label_file, uint32_t label_size);
+
+// Sparse batches
+mnist_sparse_batch_t* mnist_sparse_create(uint32_t max_images);
+void mnist_sparse_destroy(mnist_sparse_batch_t* batch);
+
+// Compress one image; returns the number of nonzeros written
+uint32_t mnist_sparsify(const uint8_t* image, uint16_t* index, float* value);
+
+// Compress images indices[first .. first + count) of 'set' into 'batch'
+// (indices may be 0 for images first .. first + count)
+void mnist_sparse_fill(mnist_sparse_batch_t* batch, const mnist_set_t* set,
+                       const uint32_t* indices, uint32_t first, uint32_t count);
+
+#endif
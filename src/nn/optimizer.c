@@ -0,0 +1,205 @@
+#include "optimizer.h"
+#include "../memory/memory.h"
+#include "../math/math.h"
+#include "../math/simd.h"
+#include "../libc/string.h"
+#include <stdint.h>
+
+// Allocate the optimizer and 'state_arrays' state vectors in one block
+static optimizer_t* optimizer_alloc(optimizer_type_t type, uint32_t count, float lr, uint32_t state_arrays) {
+    optimizer_t* opt = (optimizer_t*)kmalloc(sizeof(optimizer_t));
+    if (!opt) {
+        return 0;
+    }
+    
+    opt->type = type;
+    opt->count = count;
+    opt->lr = lr;
+    opt->momentum = 0.0f;
+    opt->beta1 = 0.0f;
+    opt->beta2 = 0.0f;
+    opt->eps = 0.0f;
+    opt->m = 0;
+    opt->v = 0;
+    
+    if (state_arrays > 0) {
+        // Pad each array to a multiple of 4 so both stay 16-byte aligned
+        uint32_t padded = (count + 3) & ~3;
+        float* state = (float*)kmalloc_aligned(padded * state_arrays * sizeof(float), 16);
+        if (!state) {
+            kfree(opt);
+            return 0;
+        }
+        opt->m = state;
+        if (state_arrays > 1) {
+            opt->v = state + padded;
+        }
+    }
+    
+    optimizer_reset(opt);
+    return opt;
+}
+
+optimizer_t* optimizer_create_sgd(uint32_t count, float lr, float momentum) {
+    optimizer_t* opt = optimizer_alloc(OPTIMIZER_SGD, count, lr, momentum > 0.0f ? 1 : 0);
+    if (opt) {
+        opt->momentum = momentum;
+    }
+    return opt;
+}
+
+optimizer_t* optimizer_create_nesterov(uint32_t count, float lr, float momentum) {
+    optimizer_t* opt = optimizer_alloc(OPTIMIZER_NESTEROV, count, lr, 1);
+    if (opt) {
+        opt->momentum = momentum;
+    }
+    return opt;
+}
+
+optimizer_t* optimizer_create_adam(uint32_t count, float lr, float beta1, float beta2, float eps) {
+    optimizer_t* opt = optimizer_alloc(OPTIMIZER_ADAM, count, lr, 2);
+    if (opt) {
+        opt->beta1 = beta1;
+        opt->beta2 = beta2;
+        opt->eps = eps;
+    }
+    return opt;
+}
+
+void optimizer_destroy(optimizer_t* opt) {
+    if (!opt) {
+        return;
+    }
+    kfree(opt->m);
+    kfree(opt);
+}
+
+void optimizer_reset(optimizer_t* opt) {
+    uint32_t padded = (opt->count + 3) & ~3;
+    
+    if (opt->m) {
+        memset(opt->m, 0, padded * sizeof(float));
+    }
+    if (opt->v) {
+        memset(opt->v, 0, padded * sizeof(float));
+    }
+    
+    opt->step = 0;
+    opt->beta1_pow = 1.0f;
+    opt->beta2_pow = 1.0f;
+}
+
+// p -= lr * g; g = 0
+static void sgd_step(float* p, float* g, uint32_t n, float lr) {
+    v4sf vlr = v4sf_set1(lr);
+    v4sf zero = v4sf_set1(0.0f);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4sf vg = v4sf_load(g + i);
+        v4sf_store(p + i, v4sf_load(p + i) - vlr * vg);
+        v4sf_store(g + i, zero);
+    }
+    for (; i < n; i++) {
+        p[i] -= lr * g[i];
+        g[i] = 0.0f;
+    }
+}
+
+// m = mu * m + g; p -= lr * m (heavy ball)
+// m = mu * m + g; p -= lr * (g + mu * m) (Nesterov)
+static void momentum_step(float* p, float* g, float* m, uint32_t n, float lr, float mu, int nesterov) {
+    v4sf vlr = v4sf_set1(lr);
+    v4sf vmu = v4sf_set1(mu);
+    v4sf zero = v4sf_set1(0.0f);
+    uint32_t i = 0;
+    
+    if (nesterov) {
+        for (; i + 4 <= n; i += 4) {
+            v4sf vg = v4sf_load(g + i);
+            v4sf vm = vmu * v4sf_load(m + i) + vg;
+            v4sf_store(m + i, vm);
+            v4sf_store(p + i, v4sf_load(p + i) - vlr * (vg + vmu * vm));
+            v4sf_store(g + i, zero);
+        }
+    } else {
+        for (; i + 4 <= n; i += 4) {
+            v4sf vm = vmu * v4sf_load(m + i) + v4sf_load(g + i);
+            v4sf_store(m + i, vm);
+            v4sf_store(p + i, v4sf_load(p + i) - vlr * vm);
+            v4sf_store(g + i, zero);
+        }
+    }
+    
+    for (; i < n; i++) {
+        float mi = mu * m[i] + g[i];
+        m[i] = mi;
+        p[i] -= lr * (nesterov ? g[i] + mu * mi : mi);
+        g[i] = 0.0f;
+    }
+}
+
+// m = b1 * m + (1 - b1) * g
+// v = b2 * v + (1 - b2) * g^2
+// p -= lr_t * m / (sqrt(v) + eps_t)
+// Bias correction is folded into lr_t and eps_t so the loop body has no
+// per-element division by (1 - b^t).
+static void adam_step(float* p, float* g, float* m, float* v, uint32_t n,
+                      float lr_t, float b1, float b2, float eps_t) {
+    v4sf vlr = v4sf_set1(lr_t);
+    v4sf vb1 = v4sf_set1(b1);
+    v4sf vb2 = v4sf_set1(b2);
+    v4sf vc1 = v4sf_set1(1.0f - b1);
+    v4sf vc2 = v4sf_set1(1.0f - b2);
+    v4sf veps = v4sf_set1(eps_t);
+    v4sf zero = v4sf_set1(0.0f);
+    uint32_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        v4sf vg = v4sf_load(g + i);
+        v4sf vm = vb1 * v4sf_load(m + i) + vc1 * vg;
+        v4sf vv = vb2 * v4sf_load(v + i) + vc2 * vg * vg;
+        v4sf_store(m + i, vm);
+        v4sf_store(v + i, vv);
+        v4sf_store(p + i, v4sf_load(p + i) - vlr * vm / (v4sf_sqrt(vv) + veps));
+        v4sf_store(g + i, zero);
+    }
+    for (; i < n; i++) {
+        float gi = g[i];
+        float mi = b1 * m[i] + (1.0f - b1) * gi;
+        float vi = b2 * v[i] + (1.0f - b2) * gi * gi;
+        m[i] = mi;
+        v[i] = vi;
+        p[i] -= lr_t * mi / (k_sqrtf(vi) + eps_t);
+        g[i] = 0.0f;
+    }
+}
+
+void optimizer_step(optimizer_t* opt, float* params, float* grads) {
+    opt->step++;
+    
+    switch (opt->type) {
+        case OPTIMIZER_SGD:
+            if (opt->m) {
+                momentum_step(params, grads, opt->m, opt->count, opt->lr, opt->momentum, 0);
+            } else {
+                sgd_step(params, grads, opt->count, opt->lr);
+            }
+            break;
+            
+        case OPTIMIZER_NESTEROV:
+            momentum_step(params, grads, opt->m, opt->count, opt->lr, opt->momentum, 1);
+            break;
+            
+        case OPTIMIZER_ADAM: {
+            opt->beta1_pow *= opt->beta1;
+            opt->beta2_pow *= opt->beta2;
+            float c2 = k_sqrtf(1.0f - opt->beta2_pow);
+            float lr_t = opt->lr * c2 / (1.0f - opt->beta1_pow);
+            float eps_t = opt->eps * c2;
+            adam_step(params, grads, opt->m, opt->v, opt->count,
+                      lr_t, opt->beta1, opt->beta2, eps_t);
+            break;
+        }
+    }
+}
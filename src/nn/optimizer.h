@@ -0,0 +1,44 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdint.h>
+
+// Optimizer kinds
+typedef enum {
+    OPTIMIZER_SGD,          // Plain SGD, or heavy-ball momentum when momentum > 0
+    OPTIMIZER_NESTEROV,     // SGD with Nesterov momentum
+    OPTIMIZER_ADAM          // Adam with bias correction
+} optimizer_type_t;
+
+// Optimizer state for one contiguous parameter array. The update kernels
+// read each parameter, gradient and state element once, write them back
+// once and clear the gradient in the same pass.
+typedef struct {
+    optimizer_type_t type;
+    uint32_t count;         // Number of parameters
+    float lr;               // Learning rate
+    float momentum;         // SGD momentum (mu)
+    float beta1;            // Adam first moment decay
+    float beta2;            // Adam second moment decay
+    float eps;              // Adam denominator epsilon
+    float beta1_pow;        // beta1^t for bias correction
+    float beta2_pow;        // beta2^t for bias correction
+    uint32_t step;          // Number of updates applied
+    float* m;               // Momentum / first moment (0 for plain SGD)
+    float* v;               // Second moment (Adam only)
+} optimizer_t;
+
+// Create optimizers over 'count' parameters. State comes from kmalloc and
+// starts at zero. Return 0 on allocation failure.
+optimizer_t* optimizer_create_sgd(uint32_t count, float lr, float momentum);
+optimizer_t* optimizer_create_nesterov(uint32_t count, float lr, float momentum);
+optimizer_t* optimizer_create_adam(uint32_t count, float lr, float beta1, float beta2, float eps);
+void optimizer_destroy(optimizer_t* opt);
+
+// Apply one update to params using grads, then zero grads
+void optimizer_step(optimizer_t* opt, float* params, float* grads);
+
+// Clear the optimizer state (moments and step counter)
+void optimizer_reset(optimizer_t* opt);
+
+#endif
@@ -0,0 +1,286 @@
+#include "prune.h"
+#include "activation.h"
+#include "train.h"
+#include "../memory/memory.h"
+#include "../math/math.h"
+#include "../cpu/cpu.h"
+#include "../drivers/screen.h"
+#include "../libc/printf.h"
+#include <stdint.h>
+
+// k-th smallest value (0-based) of a[0..n), reorders a
+static float select_kth(float* a, uint32_t n, uint32_t k) {
+    uint32_t lo = 0;
+    uint32_t hi = n - 1;
+    
+    while (lo < hi) {
+        float pivot = a[lo + (hi - lo) / 2];
+        uint32_t i = lo;
+        uint32_t j = hi;
+        while (i <= j) {
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j) {
+                float t = a[i];
+                a[i] = a[j];
+                a[j] = t;
+                i++;
+                if (j == 0) break;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+    return a[k];
+}
+
+prune_mask_t* prune_magnitude(mlp_t* model, uint32_t sparsity_pct) {
+    uint32_t max_weights = 0;
+    uint32_t total_pruned = 0;
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        uint32_t n = model->layers[l].in * model->layers[l].out;
+        if (n > max_weights) max_weights = n;
+        total_pruned += (uint32_t)k_udiv64((uint64_t)n * sparsity_pct, 100);
+    }
+    
+    prune_mask_t* mask = (prune_mask_t*)kmalloc(sizeof(prune_mask_t));
+    float* scratch = (float*)kmalloc(max_weights * sizeof(float));
+    if (mask) {
+        mask->count = 0;
+        mask->index = (uint32_t*)kmalloc((total_pruned ? total_pruned : 1) * sizeof(uint32_t));
+    }
+    if (!mask || !scratch || !mask->index) {
+        kfree(scratch);
+        prune_mask_destroy(mask);
+        return 0;
+    }
+    
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        dense_layer_t* layer = &model->layers[l];
+        uint32_t n = layer->in * layer->out;
+        uint32_t prune = (uint32_t)k_udiv64((uint64_t)n * sparsity_pct, 100);
+        if (prune == 0) {
+            continue;
+        }
+        
+        for (uint32_t i = 0; i < n; i++) {
+            scratch[i] = k_fabsf(layer->weights[i]);
+        }
+        float threshold = select_kth(scratch, n, prune - 1);
+        
+        // Remove everything below the threshold, then ties at the
+        // threshold until exactly 'prune' weights are gone
+        uint32_t base = (uint32_t)(layer->weights - model->params);
+        uint32_t removed = 0;
+        for (int pass = 0; pass < 2 && removed < prune; pass++) {
+            for (uint32_t i = 0; i < n && removed < prune; i++) {
+                float a = k_fabsf(layer->weights[i]);
+                if (pass == 0 ? a < threshold : a == threshold) {
+                    layer->weights[i] = 0.0f;
+                    mask->index[mask->count++] = base + i;
+                    removed++;
+                }
+            }
+        }
+    }
+    
+    kfree(scratch);
+    return mask;
+}
+
+void prune_mask_destroy(prune_mask_t* mask) {
+    if (!mask) {
+        return;
+    }
+    kfree(mask->index);
+    kfree(mask);
+}
+
+void prune_apply_mask(mlp_t* model, const prune_mask_t* mask) {
+    for (uint32_t k = 0; k < mask->count; k++) {
+        model->params[mask->index[k]] = 0.0f;
+        model->grads[mask->index[k]] = 0.0f;
+    }
+}
+
+void prune_finetune(mlp_t* model, const prune_mask_t* mask, optimizer_t* opt,
+                    const mnist_set_t* set, uint32_t batch_size, uint32_t steps, rng_t* rng) {
+    uint32_t* order = (uint32_t*)kmalloc(set->count * sizeof(uint32_t));
+    uint32_t* batch = (uint32_t*)kmalloc(batch_size * sizeof(uint32_t));
+    trainer_t* trainer = trainer_create(model);
+    if (!order || !batch || !trainer || set->count == 0) {
+        trainer_destroy(trainer);
+        kfree(batch);
+        kfree(order);
+        return;
+    }
+    for (uint32_t i = 0; i < set->count; i++) {
+        order[i] = i;
+    }
+    
+    uint32_t pos = set->count;
+    for (uint32_t step = 0; step < steps; step++) {
+        for (uint32_t b = 0; b < batch_size; b++) {
+            if (pos >= set->count) {
+                random_shuffle(rng, order, set->count);
+                pos = 0;
+            }
+            batch[b] = order[pos++];
+        }
+        trainer_accumulate(trainer, set, batch, batch_size);
+        
+        // Masked gradients are zeroed first so momentum state stays zero
+        prune_apply_mask(model, mask);
+        optimizer_step(opt, model->params, model->grads);
+        prune_apply_mask(model, mask);
+    }
+    
+    trainer_destroy(trainer);
+    kfree(batch);
+    kfree(order);
+}
+
+sparse_mlp_t* prune_compile(mlp_t* model, uint32_t max_density_pct) {
+    sparse_mlp_t* smodel = (sparse_mlp_t*)kmalloc(sizeof(sparse_mlp_t));
+    if (!smodel) {
+        return 0;
+    }
+    smodel->model = model;
+    smodel->weight_bytes = 0;
+    for (uint32_t l = 0; l < MLP_MAX_LAYERS; l++) {
+        smodel->csr[l] = 0;
+    }
+    
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        dense_layer_t* layer = &model->layers[l];
+        uint32_t n = layer->in * layer->out;
+        uint32_t nnz = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            nnz += (layer->weights[i] != 0.0f);
+        }
+        
+        smodel->weight_bytes += layer->out * sizeof(float);
+        if ((uint64_t)nnz * 100 <= (uint64_t)n * max_density_pct) {
+            smodel->csr[l] = l == 0
+                ? csr_from_dense(layer->weights, layer->in, layer->out)
+                : csr_from_dense_transposed(layer->weights, layer->in, layer->out);
+            if (!smodel->csr[l]) {
+                sparse_mlp_destroy(smodel);
+                return 0;
+            }
+            smodel->weight_bytes += csr_bytes(smodel->csr[l]);
+        } else {
+            smodel->weight_bytes += n * sizeof(float);
+        }
+    }
+    
+    return smodel;
+}
+
+void sparse_mlp_destroy(sparse_mlp_t* smodel) {
+    if (!smodel) {
+        return;
+    }
+    for (uint32_t l = 0; l < MLP_MAX_LAYERS; l++) {
+        csr_destroy(smodel->csr[l]);
+    }
+    kfree(smodel);
+}
+
+uint32_t sparse_mlp_predict(sparse_mlp_t* smodel, const uint8_t* image) {
+    mlp_t* model = smodel->model;
+    mlp_load_image(model, image);
+    
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        dense_layer_t* layer = &model->layers[l];
+        float* x = model->activations[l];
+        float* y = model->activations[l + 1];
+        
+        if (smodel->csr[l] && l == 0) {
+            for (uint32_t j = 0; j < layer->out; j++) {
+                y[j] = layer->bias[j];
+            }
+            csr_axpy_rows(smodel->csr[l], model->input_index, model->input_value, model->input_nnz, y);
+        } else if (smodel->csr[l]) {
+            csr_spmv(smodel->csr[l], x, layer->bias, y);
+        } else if (l == 0 && model->input_nnz * 100 <= layer->in * DENSE_SPARSE_MAX_DENSITY_PCT) {
+            dense_forward_sparse(layer, model->input_index, model->input_value, model->input_nnz, y);
+        } else {
+            dense_forward(layer, x, y);
+        }
+        
+        if (l + 1 < model->num_layers) {
+            relu_forward(y, layer->out);
+        }
+    }
+    
+    uint32_t last = model->num_layers;
+    return argmax(model->activations[last], model->layers[last - 1].out);
+}
+
+void prune_evaluate(sparse_mlp_t* smodel, mlp_t* dense, const uint8_t* images,
+                    const uint8_t* labels, uint32_t count, prune_report_t* report) {
+    mlp_t* model = smodel->model;
+    
+    report->count = count;
+    report->total_weights = 0;
+    report->zero_weights = 0;
+    report->sparse_layers = 0;
+    report->dense_correct = 0;
+    report->sparse_correct = 0;
+    report->dense_cycles = 0;
+    report->sparse_cycles = 0;
+    report->dense_bytes = dense->num_params * sizeof(float);
+    report->sparse_bytes = smodel->weight_bytes;
+    
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        uint32_t n = model->layers[l].in * model->layers[l].out;
+        report->total_weights += n;
+        for (uint32_t i = 0; i < n; i++) {
+            report->zero_weights += (model->layers[l].weights[i] == 0.0f);
+        }
+        report->sparse_layers += (smodel->csr[l] != 0);
+    }
+    
+    for (uint32_t n = 0; n < count; n++) {
+        const uint8_t* image = images + n * MNIST_PIXELS;
+        
+        uint64_t t0 = rdtsc();
+        uint32_t pd = mlp_predict(dense, image);
+        uint64_t t1 = rdtsc();
+        uint32_t ps = sparse_mlp_predict(smodel, image);
+        uint64_t t2 = rdtsc();
+        
+        report->dense_cycles += t1 - t0;
+        report->sparse_cycles += t2 - t1;
+        report->dense_correct += (pd == labels[n]);
+        report->sparse_correct += (ps == labels[n]);
+    }
+}
+
+// A ratio as a percentage
+static float percent(uint32_t part, uint32_t whole) {
+    return whole ? 100.0f * (float)part / (float)whole : 0.0f;
+}
+
+void prune_print_report(const prune_report_t* report) {
+    uint32_t count = report->count;
+    double dense = (double)(int64_t)report->dense_cycles;
+    double sparse = (double)(int64_t)report->sparse_cycles;
+    
+    kprintf("Pruned model: sparsity %.2f%%, %u CSR layers\n",
+            percent(report->zero_weights, report->total_weights), report->sparse_layers);
+    kprintf("  Accuracy dense: %.2f%%  sparse: %.2f%%\n",
+            percent(report->dense_correct, count), percent(report->sparse_correct, count));
+    kprintf("  Cycles/image dense: %u  sparse: %u  speedup: %.2fx\n",
+            count ? (uint32_t)k_udiv64(report->dense_cycles, count) : 0,
+            count ? (uint32_t)k_udiv64(report->sparse_cycles, count) : 0,
+            sparse > 0 ? dense / sparse : 0.0);
+    kprintf("  Weight bytes dense: %u  sparse: %u\n", report->dense_bytes, report->sparse_bytes);
+}
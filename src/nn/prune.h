@@ -0,0 +1,73 @@
+#ifndef PRUNE_H
+#define PRUNE_H
+
+#include <stdint.h>
+#include "mlp.h"
+#include "optimizer.h"
+#include "../math/sparse.h"
+#include "../math/random.h"
+
+// Layers with at most this percentage of nonzero weights run as CSR
+#define PRUNE_MAX_DENSITY_PCT 30
+
+// Indices (into mlp_t.params) of the weights removed by pruning
+typedef struct {
+    uint32_t count;
+    uint32_t* index;
+} prune_mask_t;
+
+// Inference form of a pruned model: sparse layers use CSR kernels, the
+// rest keep using the source model's dense weights. The first layer is
+// stored input-major (one CSR row per pixel) so only the rows of nonzero
+// pixels are read; later layers are stored one CSR row per output. Biases and activation
+// buffers also come from the source model, which must outlive this.
+typedef struct {
+    mlp_t* model;
+    csr_matrix_t* csr[MLP_MAX_LAYERS];  // 0 where the layer stays dense
+    uint32_t weight_bytes;              // Weights + biases actually used
+} sparse_mlp_t;
+
+// Pruned vs dense comparison
+typedef struct {
+    uint32_t count;
+    uint32_t total_weights;
+    uint32_t zero_weights;
+    uint32_t sparse_layers;
+    uint32_t dense_correct;
+    uint32_t sparse_correct;
+    uint64_t dense_cycles;
+    uint64_t sparse_cycles;
+    uint32_t dense_bytes;
+    uint32_t sparse_bytes;
+} prune_report_t;
+
+// Zero the smallest-magnitude 'sparsity_pct' percent of each layer's
+// weights (biases are kept). Returns the mask of pruned weights, or 0 on
+// allocation failure.
+prune_mask_t* prune_magnitude(mlp_t* model, uint32_t sparsity_pct);
+void prune_mask_destroy(prune_mask_t* mask);
+
+// Re-zero pruned weights and their gradients
+void prune_apply_mask(mlp_t* model, const prune_mask_t* mask);
+
+// Optional fine-tuning: 'steps' minibatches of shuffled training images,
+// keeping pruned weights at zero. Gradients are summed over the batch,
+// computed on all CPUs.
+void prune_finetune(mlp_t* model, const prune_mask_t* mask, optimizer_t* opt,
+                    const mnist_set_t* set, uint32_t batch_size, uint32_t steps, rng_t* rng);
+
+// Build the inference form; layers at or below max_density_pct percent
+// nonzero weights switch to CSR
+sparse_mlp_t* prune_compile(mlp_t* model, uint32_t max_density_pct);
+void sparse_mlp_destroy(sparse_mlp_t* smodel);
+
+// Classify a 28x28 uint8 image with the sparse model
+uint32_t sparse_mlp_predict(sparse_mlp_t* smodel, const uint8_t* image);
+
+// Compare the sparse model against a dense model (pass the unpruned
+// original to measure accuracy loss, or the pruned source for pure speedup)
+void prune_evaluate(sparse_mlp_t* smodel, mlp_t* dense, const uint8_t* images,
+                    const uint8_t* labels, uint32_t count, prune_report_t* report);
+void prune_print_report(const prune_report_t* report);
+
+#endif
@@ -0,0 +1,271 @@
+#include "quant.h"
+#include "activation.h"
+#include "../memory/memory.h"
+#include "../math/math.h"
+#include "../math/simd.h"
+#include "../cpu/cpu.h"
+#include "../drivers/screen.h"
+#include "../libc/printf.h"
+#include <stdint.h>
+
+// Round to nearest and clamp to the int8 range
+static inline int32_t quantize(float x, float inv_scale) {
+    float q = x * inv_scale;
+    int32_t r = (int32_t)(q < 0.0f ? q - 0.5f : q + 0.5f);
+    if (r > QUANT_MAX) r = QUANT_MAX;
+    if (r < -QUANT_MAX) r = -QUANT_MAX;
+    return r;
+}
+
+static float max_abs(const float* x, uint32_t n) {
+    float m = 0.0f;
+    for (uint32_t i = 0; i < n; i++) {
+        float a = k_fabsf(x[i]);
+        if (a > m) {
+            m = a;
+        }
+    }
+    return m;
+}
+
+// Transpose and quantise one float layer with per-output-channel scales
+static void quant_layer(qdense_layer_t* q, const dense_layer_t* layer) {
+    for (uint32_t j = 0; j < q->out; j++) {
+        float m = 0.0f;
+        for (uint32_t i = 0; i < q->in; i++) {
+            float a = k_fabsf(layer->weights[i * q->out + j]);
+            if (a > m) {
+                m = a;
+            }
+        }
+        float scale = m > 0.0f ? m / QUANT_MAX : 1.0f;
+        float inv = 1.0f / scale;
+        
+        int8_t* row = q->weights + j * q->in_padded;
+        for (uint32_t i = 0; i < q->in; i++) {
+            row[i] = (int8_t)quantize(layer->weights[i * q->out + j], inv);
+        }
+        for (uint32_t i = q->in; i < q->in_padded; i++) {
+            row[i] = 0;
+        }
+        
+        q->weight_scale[j] = scale;
+        q->bias[j] = layer->bias[j];
+    }
+}
+
+qmlp_t* quant_alloc(const uint32_t* sizes, uint32_t num_sizes) {
+    if (num_sizes < 2 || num_sizes - 1 > MLP_MAX_LAYERS) {
+        return 0;
+    }
+    
+    qmlp_t* qmodel = (qmlp_t*)kmalloc(sizeof(qmlp_t));
+    if (!qmodel) {
+        return 0;
+    }
+    qmodel->num_layers = num_sizes - 1;
+    qmodel->weight_bytes = 0;
+    qmodel->input = 0;
+    qmodel->output = 0;
+    for (uint32_t l = 0; l < qmodel->num_layers; l++) {
+        qmodel->layers[l].weights = 0;
+        qmodel->layers[l].weight_scale = 0;
+        qmodel->layers[l].bias = 0;
+    }
+    
+    uint32_t max_width = 0;
+    for (uint32_t l = 0; l < qmodel->num_layers; l++) {
+        qdense_layer_t* q = &qmodel->layers[l];
+        q->in = sizes[l];
+        q->out = sizes[l + 1];
+        q->in_padded = (q->in + 15) & ~15;
+        q->input_scale = 1.0f;
+        q->weights = (int8_t*)kmalloc(q->out * q->in_padded);
+        q->weight_scale = (float*)kmalloc(q->out * sizeof(float));
+        q->bias = (float*)kmalloc(q->out * sizeof(float));
+        if (!q->weights || !q->weight_scale || !q->bias) {
+            quant_destroy(qmodel);
+            return 0;
+        }
+        
+        qmodel->weight_bytes += q->out * q->in_padded + 2 * q->out * sizeof(float);
+        if (q->in_padded > max_width) max_width = q->in_padded;
+        if (q->out > max_width) max_width = q->out;
+    }
+    
+    qmodel->input = (int16_t*)kmalloc(max_width * sizeof(int16_t));
+    qmodel->output = (float*)kmalloc(max_width * sizeof(float));
+    if (!qmodel->input || !qmodel->output) {
+        quant_destroy(qmodel);
+        return 0;
+    }
+    return qmodel;
+}
+
+qmlp_t* quant_create(mlp_t* model, const uint8_t* images, uint32_t count) {
+    uint32_t sizes[MLP_MAX_LAYERS + 1];
+    sizes[0] = model->layers[0].in;
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        sizes[l + 1] = model->layers[l].out;
+    }
+    qmlp_t* qmodel = quant_alloc(sizes, model->num_layers + 1);
+    if (!qmodel) {
+        return 0;
+    }
+    
+    // Calibrate: largest activation entering each layer. The input layer
+    // sees pixels / 255, so its range is fixed at [0, 1].
+    float range[MLP_MAX_LAYERS];
+    range[0] = 1.0f;
+    for (uint32_t l = 1; l < model->num_layers; l++) {
+        range[l] = 0.0f;
+    }
+    for (uint32_t n = 0; n < count; n++) {
+        mlp_load_image(model, images + n * MNIST_PIXELS);
+        mlp_forward(model);
+        for (uint32_t l = 1; l < model->num_layers; l++) {
+            float m = max_abs(model->activations[l], model->layers[l].in);
+            if (m > range[l]) {
+                range[l] = m;
+            }
+        }
+    }
+    
+    for (uint32_t l = 0; l < model->num_layers; l++) {
+        qdense_layer_t* q = &qmodel->layers[l];
+        quant_layer(q, &model->layers[l]);
+        q->input_scale = range[l] > 0.0f ? range[l] / QUANT_MAX : 1.0f;
+    }
+    return qmodel;
+}
+
+void quant_destroy(qmlp_t* qmodel) {
+    if (!qmodel) {
+        return;
+    }
+    for (uint32_t l = 0; l < qmodel->num_layers; l++) {
+        kfree(qmodel->layers[l].weights);
+        kfree(qmodel->layers[l].weight_scale);
+        kfree(qmodel->layers[l].bias);
+    }
+    kfree(qmodel->input);
+    kfree(qmodel->output);
+    kfree(qmodel);
+}
+
+// Sign-extend the low/high 8 int8 lanes to int16
+static inline v8hi widen_lo(v16qi w) {
+    return (v8hi)__builtin_ia32_punpcklbw128(w, w) >> 8;
+}
+
+static inline v8hi widen_hi(v16qi w) {
+    return (v8hi)__builtin_ia32_punpckhbw128(w, w) >> 8;
+}
+
+// int32 dot product of int8 weights with int16 activations. pmaddwd
+// multiplies 8 int16 pairs and adds adjacent products into 4 int32 lanes.
+static inline int32_t dot_i8_i16(const int8_t* w, const int16_t* x, uint32_t n) {
+    v4si acc0 = {0, 0, 0, 0};
+    v4si acc1 = {0, 0, 0, 0};
+    
+    for (uint32_t i = 0; i < n; i += 16) {
+        v16qi vw = *(const v16qi_u*)(w + i);
+        v8hi x0 = *(const v8hi_u*)(x + i);
+        v8hi x1 = *(const v8hi_u*)(x + i + 8);
+        acc0 += __builtin_ia32_pmaddwd128(widen_lo(vw), x0);
+        acc1 += __builtin_ia32_pmaddwd128(widen_hi(vw), x1);
+    }
+    
+    v4si acc = acc0 + acc1;
+    return acc[0] + acc[1] + acc[2] + acc[3];
+}
+
+// y[j] = (sum_i q_w[j][i] * q_x[i]) * input_scale * weight_scale[j] + bias[j]
+static void qdense_forward(const qdense_layer_t* q, const int16_t* x, float* y) {
+    for (uint32_t j = 0; j < q->out; j++) {
+        int32_t acc = dot_i8_i16(q->weights + j * q->in_padded, x, q->in_padded);
+        y[j] = (float)acc * (q->input_scale * q->weight_scale[j]) + q->bias[j];
+    }
+}
+
+// Requantise float activations into the int16 input buffer (zero padded)
+static void requantize(const float* y, uint32_t n, uint32_t n_padded, float scale, int16_t* x) {
+    float inv = 1.0f / scale;
+    for (uint32_t i = 0; i < n; i++) {
+        x[i] = (int16_t)quantize(y[i], inv);
+    }
+    for (uint32_t i = n; i < n_padded; i++) {
+        x[i] = 0;
+    }
+}
+
+uint32_t quant_predict(qmlp_t* qmodel, const uint8_t* image) {
+    // Pixels map to [0, 1] with scale 1/127: q = round(p * 127 / 255)
+    int16_t* x = qmodel->input;
+    for (uint32_t i = 0; i < MNIST_PIXELS; i++) {
+        x[i] = (int16_t)((image[i] * QUANT_MAX + 127) / 255);
+    }
+    for (uint32_t i = MNIST_PIXELS; i < qmodel->layers[0].in_padded; i++) {
+        x[i] = 0;
+    }
+    
+    for (uint32_t l = 0; l < qmodel->num_layers; l++) {
+        qdense_layer_t* q = &qmodel->layers[l];
+        qdense_forward(q, x, qmodel->output);
+        
+        if (l + 1 < qmodel->num_layers) {
+            relu_forward(qmodel->output, q->out);
+            qdense_layer_t* next = &qmodel->layers[l + 1];
+            requantize(qmodel->output, q->out, next->in_padded, next->input_scale, x);
+        }
+    }
+    
+    return argmax(qmodel->output, qmodel->layers[qmodel->num_layers - 1].out);
+}
+
+void quant_evaluate(qmlp_t* qmodel, mlp_t* model, const uint8_t* images,
+                    const uint8_t* labels, uint32_t count, quant_report_t* report) {
+    report->count = count;
+    report->float_correct = 0;
+    report->int8_correct = 0;
+    report->agree = 0;
+    report->float_cycles = 0;
+    report->int8_cycles = 0;
+    report->float_bytes = model->num_params * sizeof(float);
+    report->int8_bytes = qmodel->weight_bytes;
+    
+    for (uint32_t n = 0; n < count; n++) {
+        const uint8_t* image = images + n * MNIST_PIXELS;
+        
+        uint64_t t0 = rdtsc();
+        uint32_t pf = mlp_predict(model, image);
+        uint64_t t1 = rdtsc();
+        uint32_t pq = quant_predict(qmodel, image);
+        uint64_t t2 = rdtsc();
+        
+        report->float_cycles += t1 - t0;
+        report->int8_cycles += t2 - t1;
+        report->float_correct += (pf == labels[n]);
+        report->int8_correct += (pq == labels[n]);
+        report->agree += (pf == pq);
+    }
+}
+
+// correct/count as a percentage
+static float percent(uint32_t correct, uint32_t count) {
+    return count ? 100.0f * (float)correct / (float)count : 0.0f;
+}
+
+void quant_print_report(const quant_report_t* report) {
+    uint32_t count = report->count;
+    
+    kprintf("Quantised model (%u images)\n", count);
+    kprintf("  Accuracy float: %.2f%%  int8: %.2f%%  delta: %+.2f%%\n",
+            percent(report->float_correct, count), percent(report->int8_correct, count),
+            percent(report->int8_correct, count) - percent(report->float_correct, count));
+    kprintf("  Agreement: %.2f%%\n", percent(report->agree, count));
+    kprintf("  Cycles/image float: %u  int8: %u\n",
+            count ? (uint32_t)k_udiv64(report->float_cycles, count) : 0,
+            count ? (uint32_t)k_udiv64(report->int8_cycles, count) : 0);
+    kprintf("  Weight bytes float: %u  int8: %u\n", report->float_bytes, report->int8_bytes);
+}
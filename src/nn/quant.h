@@ -0,0 +1,62 @@
+#ifndef QUANT_H
+#define QUANT_H
+
+#include <stdint.h>
+#include "mlp.h"
+
+// Largest quantised magnitude (symmetric int8, -128 is unused)
+#define QUANT_MAX 127
+
+// Int8 dense layer. Weights are stored output-major (out x in_padded) so
+// each output is one contiguous int8 dot product, with in_padded a
+// multiple of 16 (zero filled) for whole SSE loads.
+typedef struct {
+    uint32_t in;
+    uint32_t out;
+    uint32_t in_padded;
+    int8_t* weights;        // out x in_padded
+    float* weight_scale;    // Per output channel: w = q * weight_scale[j]
+    float* bias;            // Float bias, added in the dequantise step
+    float input_scale;      // Per layer: x = q * input_scale
+} qdense_layer_t;
+
+// Quantised copy of an mlp_t
+typedef struct {
+    uint32_t num_layers;
+    qdense_layer_t layers[MLP_MAX_LAYERS];
+    int16_t* input;         // Quantised activations, widened for pmaddwd
+    float* output;          // Dequantised layer output
+    uint32_t weight_bytes;  // Memory used by weights, scales and biases
+} qmlp_t;
+
+// Accuracy and speed of the int8 model against the float model
+typedef struct {
+    uint32_t count;
+    uint32_t float_correct;
+    uint32_t int8_correct;
+    uint32_t agree;             // Images where both models predict the same label
+    uint64_t float_cycles;
+    uint64_t int8_cycles;
+    uint32_t float_bytes;
+    uint32_t int8_bytes;
+} quant_report_t;
+
+// Post-training quantisation: weight scales are per output channel, and
+// activation scales per layer are calibrated from the max activation seen
+// over 'count' sample images. Returns 0 on allocation failure.
+qmlp_t* quant_create(mlp_t* model, const uint8_t* images, uint32_t count);
+
+// Allocate an int8 model of the given layer widths with unset weights and
+// scales (for loading a saved one). Returns 0 on allocation failure.
+qmlp_t* quant_alloc(const uint32_t* sizes, uint32_t num_sizes);
+void quant_destroy(qmlp_t* qmodel);
+
+// Classify a 28x28 uint8 image with the int8 model
+uint32_t quant_predict(qmlp_t* qmodel, const uint8_t* image);
+
+// Run both models over a labelled set and fill in a report
+void quant_evaluate(qmlp_t* qmodel, mlp_t* model, const uint8_t* images,
+                    const uint8_t* labels, uint32_t count, quant_report_t* report);
+void quant_print_report(const quant_report_t* report);
+
+#endif
@@ -0,0 +1,183 @@
+#include "train.h"
+#include "../cpu/work.h"
+#include "../kernel/prof.h"
+#include "../kernel/trace.h"
+#include "../memory/memory.h"
+#include "../math/simd.h"
+#include <stdint.h>
+
+trainer_t* trainer_create(mlp_t* model) {
+    trainer_t* trainer = (trainer_t*)kmalloc(sizeof(trainer_t));
+    if (!trainer) {
+        return 0;
+    }
+    trainer->model = model;
+    trainer->num_replicas = smp_cpu_count();
+    trainer->replicas[0] = model;
+    for (uint32_t r = 1; r < trainer->num_replicas; r++) {
+        trainer->replicas[r] = mlp_create_replica(model);
+        if (!trainer->replicas[r]) {
+            trainer->num_replicas = r;
+            trainer_destroy(trainer);
+            return 0;
+        }
+    }
+    return trainer;
+}
+
+void trainer_destroy(trainer_t* trainer) {
+    if (!trainer) {
+        return;
+    }
+    for (uint32_t r = 1; r < trainer->num_replicas; r++) {
+        mlp_destroy(trainer->replicas[r]);
+    }
+    kfree(trainer);
+}
+
+// params -= lr * grads, clearing grads (racy by design under Hogwild)
+static void hogwild_apply(float* params, float* grads, uint32_t count, float lr) {
+    v4sf vlr = v4sf_set1(lr);
+    v4sf zero = v4sf_set1(0.0f);
+    for (uint32_t i = 0; i < count; i += 4) {
+        v4sf g = *(v4sf*)(grads + i);
+        *(v4sf*)(params + i) -= vlr * g;
+        *(v4sf*)(grads + i) = zero;
+    }
+}
+
+// Work item: forward + backward over one slice of the batch
+static void train_slice(void* arg, uint32_t slice) {
+    PROF_SCOPE("train_slice");
+    TRACE_SCOPE(TRACE_EV_TRAIN_SLICE, slice);
+    trainer_t* trainer = (trainer_t*)arg;
+    uint32_t cpu = smp_cpu_index();
+    mlp_t* replica = trainer->replicas[cpu];
+    uint32_t first = slice * TRAIN_SLICE;
+    uint32_t end = first + TRAIN_SLICE < trainer->count ? first + TRAIN_SLICE : trainer->count;
+    
+    float loss = 0.0f;
+    for (uint32_t b = first; b < end; b++) {
+        uint32_t n = trainer->indices[b];
+        mlp_load_image(replica, trainer->set->images + n * MNIST_PIXELS);
+        mlp_forward(replica);
+        loss += mlp_backward(replica, trainer->set->labels[n]);
+    }
+    trainer->loss[cpu].value += loss;
+    
+    if (trainer->hogwild_lr > 0.0f) {
+        hogwild_apply(trainer->model->params, replica->grads, replica->num_params, trainer->hogwild_lr);
+    }
+}
+
+// Work item: fold one chunk of every replica's gradients into the model
+static void reduce_chunk(void* arg, uint32_t chunk) {
+    PROF_SCOPE("reduce_chunk");
+    TRACE_SCOPE(TRACE_EV_TRAIN_REDUCE, chunk);
+    trainer_t* trainer = (trainer_t*)arg;
+    uint32_t first = chunk * TRAIN_REDUCE_CHUNK;
+    uint32_t end = first + TRAIN_REDUCE_CHUNK < trainer->model->num_params
+                 ? first + TRAIN_REDUCE_CHUNK : trainer->model->num_params;
+    float* dst = trainer->model->grads;
+    v4sf zero = v4sf_set1(0.0f);
+    
+    for (uint32_t r = 1; r < trainer->num_replicas; r++) {
+        float* src = trainer->replicas[r]->grads;
+        for (uint32_t i = first; i < end; i += 4) {
+            *(v4sf*)(dst + i) += *(v4sf*)(src + i);
+            *(v4sf*)(src + i) = zero;
+        }
+    }
+}
+
+static float trainer_run(trainer_t* trainer, const mnist_set_t* set,
+                         const uint32_t* indices, uint32_t count, float hogwild_lr) {
+    trainer->set = set;
+    trainer->indices = indices;
+    trainer->count = count;
+    trainer->hogwild_lr = hogwild_lr;
+    for (uint32_t r = 0; r < trainer->num_replicas; r++) {
+        trainer->loss[r].value = 0.0f;
+    }
+    
+    work_parallel_for(train_slice, trainer, (count + TRAIN_SLICE - 1) / TRAIN_SLICE);
+    
+    float loss = 0.0f;
+    for (uint32_t r = 0; r < trainer->num_replicas; r++) {
+        loss += trainer->loss[r].value;
+    }
+    return loss;
+}
+
+float trainer_accumulate(trainer_t* trainer, const mnist_set_t* set,
+                         const uint32_t* indices, uint32_t count) {
+    float loss = trainer_run(trainer, set, indices, count, 0.0f);
+    if (trainer->num_replicas > 1) {
+        uint32_t params = trainer->model->num_params;
+        work_parallel_for(reduce_chunk, trainer, (params + TRAIN_REDUCE_CHUNK - 1) / TRAIN_REDUCE_CHUNK);
+    }
+    return loss;
+}
+
+float trainer_hogwild(trainer_t* trainer, const mnist_set_t* set,
+                      const uint32_t* indices, uint32_t count, float lr) {
+    return trainer_run(trainer, set, indices, count, lr);
+}
+
+void trainer_train(trainer_t* trainer, optimizer_t* opt, const mnist_set_t* set,
+                   uint32_t batch_size, uint32_t steps, rng_t* rng, int hogwild) {
+    uint32_t* order = (uint32_t*)kmalloc(set->count * sizeof(uint32_t));
+    if (!order || set->count < batch_size || batch_size == 0) {
+        kfree(order);
+        return;
+    }
+    for (uint32_t i = 0; i < set->count; i++) {
+        order[i] = i;
+    }
+    
+    uint32_t pos = set->count;
+    for (uint32_t step = 0; step < steps; step++) {
+        TRACE_BEGIN(TRACE_EV_TRAIN_STEP, step);
+        if (pos + batch_size > set->count) {
+            random_shuffle(rng, order, set->count);
+            pos = 0;
+        }
+        if (hogwild) {
+            trainer_hogwild(trainer, set, order + pos, batch_size, opt->lr);
+        } else {
+            trainer_accumulate(trainer, set, order + pos, batch_size);
+            TRACE_BEGIN(TRACE_EV_OPTIMIZER, 0);
+            optimizer_step(opt, trainer->model->params, trainer->model->grads);
+            TRACE_END(TRACE_EV_OPTIMIZER, 0);
+        }
+        pos += batch_size;
+        TRACE_END(TRACE_EV_TRAIN_STEP, step);
+        thread_preempt_point();
+    }
+    
+    kfree(order);
+}
+
+void trainer_train_stream(trainer_t* trainer, optimizer_t* opt, loader_t* loader,
+                          uint32_t steps, int hogwild) {
+    for (uint32_t step = 0; step < steps; step++) {
+        const mnist_set_t* batch = loader_next(loader);
+        if (!batch) {
+            return;
+        }
+        if (batch->count == 0) {
+            continue;
+        }
+        TRACE_BEGIN(TRACE_EV_TRAIN_STEP, step);
+        if (hogwild) {
+            trainer_hogwild(trainer, batch, loader_indices(loader), batch->count, opt->lr);
+        } else {
+            trainer_accumulate(trainer, batch, loader_indices(loader), batch->count);
+            TRACE_BEGIN(TRACE_EV_OPTIMIZER, 0);
+            optimizer_step(opt, trainer->model->params, trainer->model->grads);
+            TRACE_END(TRACE_EV_OPTIMIZER, 0);
+        }
+        TRACE_END(TRACE_EV_TRAIN_STEP, step);
+        thread_preempt_point();
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef TRAIN_H
+#define TRAIN_H
+
+#include <stdint.h>
+#include "mlp.h"
+#include "mnist.h"
+#include "loader.h"
+#include "optimizer.h"
+#include "../cpu/smp.h"
+#include "../math/random.h"
+
+// Samples per work item: small enough for stealing to balance the load,
+// large enough to amortise the queue operations
+#define TRAIN_SLICE 8
+
+// Floats per work item in the gradient reduction
+#define TRAIN_REDUCE_CHUNK 4096
+
+// Per-CPU loss, on its own cache line
+typedef struct {
+    float value;
+} __attribute__((aligned(64))) train_loss_t;
+
+// Data-parallel trainer. Each CPU runs forward/backward on its own
+// replica (CPU 0 uses the model itself), all reading the shared weights.
+// Gradients are either summed into the model by a parallel reduction
+// (deterministic up to float summation order), or applied straight to
+// the shared weights by each worker without locking (Hogwild).
+typedef struct {
+    mlp_t* model;
+    mlp_t* replicas[SMP_MAX_CPUS];
+    uint32_t num_replicas;
+    train_loss_t loss[SMP_MAX_CPUS];
+    
+    // Batch being processed
+    const mnist_set_t* set;
+    const uint32_t* indices;
+    uint32_t count;
+    float hogwild_lr;           // 0 = accumulate for a later optimizer step
+} trainer_t;
+
+// One replica per online CPU. Returns 0 on allocation failure.
+trainer_t* trainer_create(mlp_t* model);
+void trainer_destroy(trainer_t* trainer);
+
+// Forward + backward over set images indices[0..count) on all CPUs and
+// sum the gradients into model->grads. Returns the summed loss.
+float trainer_accumulate(trainer_t* trainer, const mnist_set_t* set,
+                         const uint32_t* indices, uint32_t count);
+
+// Same batch split, but each slice's gradient is applied immediately as
+// a lock-free SGD update (params -= lr * grad). Returns the summed loss.
+float trainer_hogwild(trainer_t* trainer, const mnist_set_t* set,
+                      const uint32_t* indices, uint32_t count, float lr);
+
+// 'steps' minibatches of shuffled training images. With hogwild set the
+// updates use opt->lr and skip the optimizer's momentum state.
+void trainer_train(trainer_t* trainer, optimizer_t* opt, const mnist_set_t* set,
+                   uint32_t batch_size, uint32_t steps, rng_t* rng, int hogwild);
+
+// Same, with batches streamed from disk by a loader: batch N+1 is read
+// while batch N trains. Stops early if the loader does.
+void trainer_train_stream(trainer_t* trainer, optimizer_t* opt, loader_t* loader,
+                          uint32_t steps, int hogwild);
+
+#endif
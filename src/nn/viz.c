@@ -0,0 +1,179 @@
+#include "viz.h"
+#include "../cpu/cpu.h"
+#include "../drivers/clock.h"
+#include "../drivers/gfx.h"
+#include "../drivers/keyboard.h"
+#include "../libc/printf.h"
+#include "../math/math.h"
+#include <stdint.h>
+
+#define VIZ_STATUS_Y (VIZ_ROWS * VIZ_CELL_H)
+#define VIZ_NO_PREDICTION 0xFF
+
+typedef struct {
+    const mnist_set_t* set;
+    uint32_t page;
+    uint32_t pages;
+    uint32_t first;             // Index of the page's first image
+    uint32_t count;             // Images on this page
+    uint32_t correct;
+    uint8_t pred[VIZ_PER_PAGE];
+} viz_page_t;
+
+static void draw_cell(const viz_page_t* p, uint32_t i, int selected) {
+    int x = (int)(i % VIZ_COLS) * VIZ_CELL_W;
+    int y = (int)(i / VIZ_COLS) * VIZ_CELL_H;
+    uint32_t n = p->first + i;
+    uint8_t label = p->set->labels[n];
+    char text[8];
+    
+    gfx_fill_rect(x, y, VIZ_CELL_W, VIZ_CELL_H, GFX_BLACK);
+    gfx_blit_gray(x + (VIZ_CELL_W - MNIST_COLS) / 2, y + 2, p->set->images + n * MNIST_PIXELS,
+                  MNIST_COLS, MNIST_ROWS, 1);
+    if (p->pred[i] == VIZ_NO_PREDICTION) {
+        ksnprintf(text, sizeof(text), "%u", label);
+        gfx_text(x + 12, y + MNIST_ROWS + 2, text, GFX_WHITE);
+    } else if (p->pred[i] == label) {
+        ksnprintf(text, sizeof(text), "%u", label);
+        gfx_text(x + 12, y + MNIST_ROWS + 2, text, GFX_GREEN);
+    } else {
+        ksnprintf(text, sizeof(text), "%u/%u", p->pred[i], label);
+        gfx_text(x + 4, y + MNIST_ROWS + 2, text, GFX_RED);
+    }
+    if (selected) {
+        gfx_frame(x, y, VIZ_CELL_W, VIZ_CELL_H, GFX_YELLOW);
+    }
+}
+
+static void draw_zoom(const viz_page_t* p, uint32_t i) {
+    uint32_t n = p->first + i;
+    uint8_t label = p->set->labels[n];
+    int size = MNIST_COLS * VIZ_ZOOM_SCALE;
+    char text[24];
+    
+    gfx_fill_rect(0, 0, GFX_WIDTH, VIZ_STATUS_Y, GFX_BLACK);
+    gfx_frame(7, 7, size + 2, size + 2, GFX_BLUE);
+    gfx_blit_gray(8, 8, p->set->images + n * MNIST_PIXELS, MNIST_COLS, MNIST_ROWS, VIZ_ZOOM_SCALE);
+    
+    ksnprintf(text, sizeof(text), "Image %u", n);
+    gfx_text(size + 24, 16, text, GFX_WHITE);
+    ksnprintf(text, sizeof(text), "Label %u", label);
+    gfx_text(size + 24, 40, text, GFX_WHITE);
+    if (p->pred[i] != VIZ_NO_PREDICTION) {
+        ksnprintf(text, sizeof(text), "Guess %u", p->pred[i]);
+        gfx_text(size + 24, 64, text, p->pred[i] == label ? GFX_GREEN : GFX_RED);
+    }
+}
+
+static void draw_status(const viz_page_t* p) {
+    char text[48];
+    
+    gfx_fill_rect(0, VIZ_STATUS_Y, GFX_WIDTH, GFX_HEIGHT - VIZ_STATUS_Y, GFX_BLUE);
+    ksnprintf(text, sizeof(text), "Page %u/%u %u/%u ok  n p wasd z q",
+              p->page + 1, p->pages, p->correct, p->count);
+    gfx_text(4, VIZ_STATUS_Y, text, GFX_WHITE);
+}
+
+// Classify the page's images; returns the cycles it took
+static uint64_t load_page(viz_page_t* p, viz_predict_fn predict, void* model) {
+    uint64_t start = rdtsc();
+    
+    p->first = p->page * VIZ_PER_PAGE;
+    p->count = p->set->count - p->first < VIZ_PER_PAGE ? p->set->count - p->first : VIZ_PER_PAGE;
+    p->correct = 0;
+    for (uint32_t i = 0; i < p->count; i++) {
+        const uint8_t* image = p->set->images + (p->first + i) * MNIST_PIXELS;
+        p->pred[i] = predict ? (uint8_t)predict(model, image) : VIZ_NO_PREDICTION;
+        p->correct += p->pred[i] == p->set->labels[p->first + i];
+    }
+    return rdtsc() - start;
+}
+
+int viz_browse(const mnist_set_t* set, viz_predict_fn predict, void* model) {
+    viz_page_t page;
+    uint64_t predict_cycles = 0, draw_cycles = 0;
+    uint32_t predicted = 0, frames = 0;
+    uint32_t sel = 0, old_sel = 0;
+    int zoom = 0, full = 1, reload = 1;
+    
+    if (!set->count || !gfx_begin()) {
+        return 0;
+    }
+    page.set = set;
+    page.page = 0;
+    page.pages = (set->count + VIZ_PER_PAGE - 1) / VIZ_PER_PAGE;
+    
+    for (;;) {
+        if (reload) {
+            predict_cycles += load_page(&page, predict, model);
+            predicted += page.count;
+            if (sel >= page.count) {
+                sel = page.count - 1;
+            }
+            reload = 0;
+            full = 1;
+        }
+        
+        // Moving the selection only redraws the two cells involved
+        uint64_t start = rdtsc();
+        if (zoom) {
+            draw_zoom(&page, sel);
+        } else if (full) {
+            gfx_fill_rect(0, 0, GFX_WIDTH, VIZ_STATUS_Y, GFX_BLACK);
+            for (uint32_t i = 0; i < page.count; i++) {
+                draw_cell(&page, i, i == sel);
+            }
+        } else {
+            draw_cell(&page, old_sel, 0);
+            draw_cell(&page, sel, 1);
+        }
+        if (full) {
+            draw_status(&page);
+        }
+        gfx_flush();
+        draw_cycles += rdtsc() - start;
+        frames++;
+        full = 0;
+        old_sel = sel;
+        
+        char c = keyboard_getchar();
+        if (c == 'q' || c == 'Q') {
+            break;
+        }
+        switch (c) {
+            case 'n':
+            case ' ':
+                page.page = page.page + 1 == page.pages ? 0 : page.page + 1;
+                reload = 1;
+                break;
+            case 'p':
+            case 'b':
+                page.page = page.page ? page.page - 1 : page.pages - 1;
+                reload = 1;
+                break;
+            case 'a':
+                sel -= sel > 0;
+                break;
+            case 'd':
+                sel += sel + 1 < page.count;
+                break;
+            case 'w':
+                sel = sel >= VIZ_COLS ? sel - VIZ_COLS : sel;
+                break;
+            case 's':
+                sel = sel + VIZ_COLS < page.count ? sel + VIZ_COLS : sel;
+                break;
+            case 'z':
+            case '\n':
+                zoom = !zoom;
+                full = 1;
+                break;
+        }
+    }
+    gfx_end();
+    
+    kprintf("Visualizer: %u frames, %u us drawing per frame, %u us inference per image\n",
+            frames, (uint32_t)k_udiv64(clock_tsc_to_ns(draw_cycles), frames * 1000),
+            predicted ? (uint32_t)k_udiv64(clock_tsc_to_ns(predict_cycles), predicted * 1000) : 0);
+    return 1;
+}
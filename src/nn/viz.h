@@ -0,0 +1,27 @@
+#ifndef VIZ_H
+#define VIZ_H
+
+#include "mnist.h"
+#include <stdint.h>
+
+// Grid of digits per page in the browser (mode 13h, 320x200)
+#define VIZ_COLS 10
+#define VIZ_ROWS 4
+#define VIZ_PER_PAGE (VIZ_COLS * VIZ_ROWS)
+#define VIZ_CELL_W 32
+#define VIZ_CELL_H 46               // 2-pixel margin, digit, 16-pixel label line
+#define VIZ_ZOOM_SCALE 6
+
+// Classify one image (e.g. mlp_predict, cnn_predict, quant_predict)
+typedef uint32_t (*viz_predict_fn)(void* model, const uint8_t* image);
+
+// Browse 'set' in graphics mode: a page of digits with the predicted
+// label under each, green if right and red ("pred/true") if wrong.
+// Keys: n/space next page, p/b previous, w/a/s/d move the selection,
+// z or Enter toggles a scaled-up view of the selected digit, q quits.
+// 'predict' may be 0 to show the true labels only. Drawing and inference
+// times are reported on the console afterwards. Returns 0 if the set is
+// empty or graphics mode is unavailable.
+int viz_browse(const mnist_set_t* set, viz_predict_fn predict, void* model);
+
+#endif
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Symbolise a sampling-profiler dump (kernel/sample.c) against kernel.elf.
+
+The dump is the text the kernel writes to the debug console: a
+'# samples ...' header, then one line per sample holding the thread name
+followed by EIP and the return addresses of its callers, in hex.
+
+Prints a flat profile (self and inclusive samples per function) and can
+write folded stacks ('thread;outer;...;inner count') for flamegraph.pl.
+"""
+
+import argparse
+import bisect
+import collections
+import subprocess
+import sys
+
+
+def load_symbols(elf):
+    """Sorted function start addresses and names from nm."""
+    out = subprocess.run(["nm", "-n", "--defined-only", elf],
+                         check=True, capture_output=True, text=True).stdout
+    addrs, names = [], []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in "tTwW":
+            addrs.append(int(parts[0], 16))
+            names.append(parts[2])
+    return addrs, names
+
+
+def read_samples(path):
+    """Samples of the last complete dump in the file."""
+    dumps, current = [], None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("# samples"):
+                current = []
+            elif line == "# end":
+                if current is not None:
+                    dumps.append(current)
+                current = None
+            elif current is not None and line:
+                parts = line.split()
+                current.append((parts[0], [int(p, 16) for p in parts[1:]]))
+    if not dumps:
+        sys.exit("no complete sample dump in " + path)
+    return dumps[-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="kernel image with symbols (build/kernel.elf)")
+    parser.add_argument("dump", help="debug console log holding the dump")
+    parser.add_argument("--folded", help="write folded stacks to this file")
+    parser.add_argument("--top", type=int, default=30, help="functions to list")
+    args = parser.parse_args()
+
+    addrs, names = load_symbols(args.elf)
+
+    def symbol(pc):
+        i = bisect.bisect_right(addrs, pc) - 1
+        return names[i] if i >= 0 else "0x%08x" % pc
+
+    samples = read_samples(args.dump)
+    self_counts = collections.Counter()
+    total_counts = collections.Counter()
+    folded = collections.Counter()
+
+    for thread, pcs in samples:
+        # Return addresses point after the call; look up the call itself
+        frames = [symbol(pc if d == 0 else pc - 1) for d, pc in enumerate(pcs)]
+        if not frames:
+            continue
+        self_counts[frames[0]] += 1
+        for name in set(frames):
+            total_counts[name] += 1
+        folded[";".join([thread] + frames[::-1])] += 1
+
+    count = len(samples)
+    print("%d samples" % count)
+    print("%7s %6s %7s %6s  %s" % ("self", "%", "total", "%", "function"))
+    for name, n in self_counts.most_common(args.top):
+        total = total_counts[name]
+        print("%7d %5.1f%% %7d %5.1f%%  %s" % (n, 100.0 * n / count,
+                                              total, 100.0 * total / count, name))
+
+    if args.folded:
+        with open(args.folded, "w") as f:
+            for stack, n in sorted(folded.items()):
+                f.write("%s %d\n" % (stack, n))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Convert a kernel trace dump (kernel/trace.c) to Chrome trace JSON.
+
+The dump is a binary blob that follows a '# trace' line in the debug
+console log. The output opens in chrome://tracing or ui.perfetto.dev:
+one process per CPU and, on the BSP, one track per kernel thread.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x31435254
+RECORD = struct.Struct("<QBBHI")
+
+BEGIN, END, INSTANT, COUNTER, ASYNC_BEGIN, ASYNC_END = range(6)
+
+# Events whose argument is worth putting in the slice name
+NAMED_BY_ARG = {"irq", "exception"}
+
+
+class Reader:
+    def __init__(self, data, pos):
+        self.data = data
+        self.pos = pos
+
+    def take(self, size):
+        if self.pos + size > len(self.data):
+            sys.exit("trace dump is truncated")
+        chunk = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return chunk
+
+    def u32(self):
+        return struct.unpack("<I", self.take(4))[0]
+
+
+def parse(data):
+    marker = data.rfind(b"\n# trace\n")
+    if marker < 0:
+        sys.exit("no trace dump found")
+    r = Reader(data, marker + len(b"\n# trace\n"))
+    if r.u32() != MAGIC:
+        sys.exit("bad trace magic")
+    tsc_khz = r.u32()
+    num_names = r.u32()
+    num_cpus = r.u32()
+    names = [r.take(r.u32()).decode() for _ in range(num_names)]
+    cpus = []
+    for _ in range(num_cpus):
+        cpu = r.u32()
+        count = r.u32()
+        records = [RECORD.unpack(r.take(RECORD.size)) for _ in range(count)]
+        cpus.append((cpu, records))
+    return tsc_khz, names, cpus
+
+
+def convert(tsc_khz, names, cpus):
+    if not tsc_khz:
+        sys.exit("trace has no TSC frequency")
+    starts = [records[0][0] for _, records in cpus if records]
+    base = min(starts) if starts else 0
+    events = []
+    tracks = set()
+
+    for cpu, records in cpus:
+        depth = {}
+        for tsc, kind, thread, ident, arg in records:
+            name = names[ident] if ident < len(names) else "event%d" % ident
+            ev = {"name": name, "ts": (tsc - base) * 1000.0 / tsc_khz,
+                  "pid": cpu, "tid": thread}
+            tracks.add((cpu, thread))
+            if kind == BEGIN:
+                if name in NAMED_BY_ARG:
+                    ev["name"] = "%s %d" % (name, arg)
+                ev.update(ph="B", args={"arg": arg})
+                depth[thread] = depth.get(thread, 0) + 1
+            elif kind == END:
+                # The ring may have overwritten the matching BEGIN
+                if not depth.get(thread):
+                    continue
+                depth[thread] -= 1
+                ev["ph"] = "E"
+            elif kind == INSTANT:
+                ev.update(ph="i", s="t", args={"arg": arg})
+            elif kind == COUNTER:
+                ev.update(ph="C", args={name: arg})
+            elif kind in (ASYNC_BEGIN, ASYNC_END):
+                ev.update(ph="b" if kind == ASYNC_BEGIN else "e", cat=name,
+                          id2={"global": "0x%x" % arg}, args={"arg": arg})
+            else:
+                continue
+            events.append(ev)
+
+    for cpu, thread in sorted(tracks):
+        events.append({"name": "process_name", "ph": "M", "pid": cpu,
+                       "args": {"name": "cpu%d" % cpu}})
+        label = "thread %d" % thread if cpu == 0 else "cpu%d" % cpu
+        events.append({"name": "thread_name", "ph": "M", "pid": cpu,
+                       "tid": thread, "args": {"name": label}})
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="debug console log holding the dump")
+    parser.add_argument("output", help="JSON file to write")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        tsc_khz, names, cpus = parse(f.read())
+    trace = convert(tsc_khz, names, cpus)
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+    total = sum(len(records) for _, records in cpus)
+    print("%d events from %d CPUs -> %s" % (total, len(cpus), args.output))
+
+
+if __name__ == "__main__":
+    main()